@@ -27,32 +27,264 @@
 #pragma config WRT = OFF       //Disable the flash memory self write protection as it is not needed
 
 #include <xc.h>
+#include "PanelConfig.h"
+
+/************
+ *  Macros  *
+ ************/
+
+//Edge Detection, each tracker holds the previous state of its inputs in the old section and the newest state in the new section
+#define RISING_EDGES(old, new) ((new) & ((old) ^ 0xFF))   //Bits that have gone from clear to set since the last update
+#define FALLING_EDGES(old, new) ((old) & ((new) ^ 0xFF))  //Bits that have gone from set to clear since the last update
+#define CHANGED_BITS(old, new) ((old) ^ (new))            //Bits that have changed in either direction since the last update
+
+//Bootloader, written as macros since the bootloader can't call anything outside of its own block
+#define BOOT_CRC(crc, work, data) (work = ((crc) >> 0x08) ^ (data), work ^= work >> 0x04, crc = ((crc) << 0x08) ^ ((unsigned short) work << 0x0C) ^ ((unsigned short) work << 0x05) ^ work)  //Add a byte to a CRC-16-CCITT without a table
+#define BOOT_READ_WORD(address) (EEADRH = (address) >> 0x08, EEADR = (address) & 0xFF, EECON1 = 0x80, EECON1 |= 0x01, __nop(), __nop())                       //Read a word of program memory into EEDATH and EEDAT
+#define BOOT_WRITE_WORD(address, high, low) (EEADRH = (address) >> 0x08, EEADR = (address) & 0xFF, EEDATH = (high), EEDAT = (low), EECON1 = 0x84, EECON2 = 0x55, EECON2 = 0xAA, EECON1 |= 0x02, __nop(), __nop())  //Load a word of program memory, the block is written once its last word is loaded
+
+//Status LCD
+#define LCD_PUSH(data) (lcdBuffer[lcdHead] = (data), lcdHead = (lcdHead + 0x01) & LCD_BUFFER_MASK)  //Add a byte to the end of the LCD ring buffer, the caller makes sure there is room for it
+
+//Battery Standby, the clock, Timer 0 and the baud rate generator are switched together so the ticks and the status LCD keep their rate, only ever by the LCD task between bytes on the EUSART
+#define STANDBY_CLOCK_SLOW() (OSCCON = STANDBY_OSCCON, OPTION_REG = STANDBY_OPTION_REG, BAUDCTL = STANDBY_BAUDCTL)  //Slow the clock down to run off the battery
+#define STANDBY_CLOCK_FULL() (OSCCON = 0x60, OPTION_REG = 0xD7, BAUDCTL = 0x00)                                      //Put the clock back to full rate
+#define STANDBY_CLOCK_IS_SLOW() ((OSCCON & 0x70) == (STANDBY_OSCCON & 0x70))                                         //Set while the clock is slowed down, read back from OSCCON rather than kept in RAM
+
+//Telemetry
+#define TELEMETRY_PUT(data) (lcdBuffer[position] = (data), check += lcdBuffer[position], position = (position + 0x01) & LCD_BUFFER_MASK)  //Add a byte to the frame being built past the end of the LCD ring buffer, adding it into the check of the frame
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Battery Monitor, the battery is read on PORTE0 along with the NAC supervision channels, its low limit is set by the battery rather than the wiring so it is never calibrated
+#define BATTERY_CHANNEL 0x05       //ADC channel of the battery monitor
+#define BATTERY_LOW_LIMIT 0xA4     //Reading below which the battery is low, about 85% of the reading of a charged battery
+
+//Condition Verification, each channel keeps a history of whether its last readings had an alarm and whether they had a trouble, a condition is verified once N of the last M readings have it
+//An alarm is verified for as long as N of the readings in its history have it, a verified trouble only goes again once N of the readings in its history are without it
+#define VERIFY_WINDOW 0x04  //Readings kept in the alarm and trouble histories of each channel, the M of the N-of-M verification, so a condition present on N of any M readings is verified by the last of them
+
+//Condition Verification Counts, the N of the N-of-M verification, the readings in the history that must have a condition before it is verified, first 4 bits for alarms, last 4 bits for troubles
+//Indexed by ADC channel, a count must be at least 1 and no greater than the window, an alarm count of 1 disables alarm verification on that channel
+const unsigned char channelVerifyCount[] = {
+    0x41, 0x41, 0x41, 0x41,                         //NAC1 to NAC4 Supervision, troubles must be present for 4 readings in a row
+    0x11,                                           //AN4, not verified
+    0x41,                                           //Battery Monitor, a low battery must be present for 4 readings in a row
+    0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43  //SLC1 to SLC8, alarms must be present for 3 of any 4 readings and troubles for 4 readings in a row
+};
+
+//Verification History Counts, the number of readings in a 4 bit history that had the condition, indexed by the history
+const unsigned char verifyHistoryCount[0x10] = {0x00, 0x01, 0x01, 0x02, 0x01, 0x02, 0x02, 0x03, 0x01, 0x02, 0x02, 0x03, 0x02, 0x03, 0x03, 0x04};
+
+//Channel Bands, each reading is put into one of 4 bands by the 3 limits of its channel, open below the open limit, normal below the alarm limit, alarm below the short limit, otherwise short
+//The limits are compared against the top 8 bits of the 10 bit reading, which is all the bands need and keeps every limit to a byte
+//The open and alarm limits are learnt by calibration, these are the limits used until a calibration has been stored, indexed by ADC channel with the open limit first
+const unsigned char channelDefaultLimits[0x1C] = {
+    0x04, 0xF0, 0x04, 0xF0, 0x04, 0xF0, 0x04, 0xF0,  //NAC1 to NAC4 Supervision, open if the EOL resistor is missing
+    0x00, 0xFF, BATTERY_LOW_LIMIT, 0xFF,             //AN4, never read, and the Battery Monitor, open once the battery has run low, its alarm and short bands carry no condition
+    0x30, 0xD5, 0x30, 0xD5, 0x30, 0xD5, 0x30, 0xD5,  //SLC1 to SLC8, open if the EOL resistor is missing, alarm once a detector draws current
+    0x30, 0xD5, 0x30, 0xD5, 0x30, 0xD5, 0x30, 0xD5
+};
+
+//Channel Short Limits, the start of the short band of each channel, this is set by the wiring rather than the devices on the loop so it is never calibrated
+const unsigned char channelShortLimit[0x0E] = {
+    0xF0, 0xF0, 0xF0, 0xF0,                          //NAC1 to NAC4 Supervision
+    0xFF, 0xFF,                                      //AN4 and Battery Monitor
+    0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8   //SLC1 to SLC8
+};
+
+//Channel Limit Slots, the slot of each ADC channel in the channel limits, only the channels in the scan schedule have one so no RAM is spent on channels that are never read
+const unsigned char channelLimitSlot[0x0E] = {
+    PANEL_LIMIT_SLOTS
+};
+
+//Channel Band Conditions, the condition flag bits of a reading in each band, open, normal, alarm and short, indexed by ADC channel
+const unsigned char channelBands[0x0E][0x04] = {
+    {0x40, 0x00, 0x40, 0x40}, {0x40, 0x00, 0x40, 0x40}, {0x40, 0x00, 0x40, 0x40}, {0x40, 0x00, 0x40, 0x40},  //NAC1 to NAC4 Supervision, anything but normal is a NAC trouble
+    {0x00, 0x00, 0x00, 0x00}, {0x20, 0x00, 0x00, 0x00},                                                      //AN4, never a condition, and the Battery Monitor, open is a low battery trouble
+    {0x20, 0x00, 0x10, 0x10}, {0x20, 0x00, 0x10, 0x10}, {0x20, 0x00, 0x10, 0x10}, {0x20, 0x00, 0x10, 0x10},  //SLC1 to SLC8, open is an SLC trouble, a short is an alarm like on any conventional zone
+    {0x20, 0x00, 0x10, 0x10}, {0x20, 0x00, 0x10, 0x10}, {0x20, 0x00, 0x10, 0x10}, {0x20, 0x00, 0x10, 0x10}
+};
+
+//Calibration, holding the silence button while the panel powers up learns the normal band of every channel being scanned and stores it in the data EEPROM
+#define CALIBRATION_SWEEPS 0x80   //ADC sweeps the normal band is learnt over
+#define CALIBRATION_MARGIN 0x18   //Distance kept between the learnt normal band and the open and alarm limits
+#define CALIBRATION_ADDRESS 0xC0  //Data EEPROM address of the calibration, a marker byte followed by the open and alarm limits of every ADC channel, so a change to panel.cfg never loads the limits of one channel into another
+#define CALIBRATION_MARKER 0x5A   //Value of the marker byte once a complete calibration has been stored, changed from 0xA5 when the limits went down to a byte so an old calibration is never loaded
+#define CALIBRATION_WRITES 0x1E   //Bytes written to store a calibration, the marker is cleared first and only set once the 28 bytes of limits are written
+
+//ADC Scan Schedule, each entry is the ADC channel to read next, bit 7 marks the last reading of a sweep after which the trackers are processed
+//All the enabled SLC's are read on every sweep, while the enabled NAC supervision channels and the battery monitor take turns, AN4 carries nothing and is never read
+//The schedule is generated from panel.cfg, so disabled SLC's and NAC's are never read at all
+const unsigned char adcScanSchedule[] = {
+    PANEL_ADC_SCAN_SCHEDULE
+};
+
+//NAC Coder Table, each entry holds the NAC's that are on at a phase of the coder, first bit is NAC1, the coder phase moves on every 4 counts of the utility counter
+//The table is generated from the patterns in panel.cfg and repeats once the pattern of every enabled NAC has, a disabled NAC is never on
+const unsigned char coderTable[PANEL_CODER_PHASES] = {
+    PANEL_CODER_TABLE
+};
+
+//Status LCD, driven over the EUSART on PORTC6 as a 16x2 serial LCD that takes 0xFE followed by a command byte, 0x80 plus the address moves the cursor
+#define LCD_BUFFER_MASK 0x1F  //Size of the LCD ring buffer minus 1, the size must be a power of 2 so the positions can wrap with a mask
+#define LCD_LINE_BYTES 0x12   //Bytes needed to redraw a single line, 2 bytes to move the cursor to the start of the line and 16 characters
+
+//Status LCD Text, the first 14 characters of the status line for each condition, in order of priority
+const unsigned char lcdStatusText[0x06][0x0E] = {
+    "SYSTEM NORMAL ",  //No conditions are present
+    "TROUBLE       ",  //A trouble condition is present
+    "PRE-ALARM     ",  //A pre-alarm condition is present
+    "GENERAL ALARM ",  //A general alarm condition is present
+    "CALIBRATING   ",  //The normal band of every channel is being learnt
+    "UPDATING      "   //The panel is handing over to the bootloader for a firmware update
+};
+
+//Smoke Reset, power to the SLC's in alarm is cut for a while and then given time to settle, so latching smoke detectors drop out of alarm, counted in Timer 0 overflows
+#define SMOKE_RESET_OFF_TICKS 0x20     //Time the power stays cut, about 2 seconds
+#define SMOKE_RESET_SETTLE_TICKS 0x10  //Time the readings are ignored after the power comes back, about 1 second
+
+//Firmware Update, the bootloader lives in the last block of program memory, which an update never rewrites, and takes a new image over the software update port
+//Every frame is a command byte, a 16 bit word address, 4 words low byte first and a CRC-16 of the first 11 bytes, the bootloader answers every frame with a single byte
+#define BOOT_ADDRESS 0x0D00           //Word address the bootloader is placed at, it has the 512 words up to 0x0EFF as the PICkit 2 debug executive takes 0x0F00 to 0x0FFE, the linker keeps everything else out of both with --ROM=default,-D00-FFF
+#define BOOT_KEY_LENGTH 0x06          //Bytes in the key that starts a firmware update, sent a byte at a time more than a Timer 0 overflow apart as the input task only polls the EUSART once every overflow
+#define BOOT_FRAME_SIZE 0x0D          //Bytes in a frame
+#define BOOT_TIMEOUT_OVERFLOWS 0x08   //Timer 1 overflows without a byte before the bootloader gives up waiting, about 2 seconds
+#define BOOT_CHECK 'C'                //Command of a frame only checked into the image CRC, nothing is written until the whole image has come through once
+#define BOOT_WRITE 'W'                //Command of a frame written into program memory and read back into the image CRC
+#define BOOT_END 'E'                  //Command of the frame ending a pass, the address carries the image CRC worked out by the uploader
+#define BOOT_READY 'B'                //Sent once the bootloader is listening, and again every time it gives up waiting
+#define BOOT_ACK 0x06                 //Sent when a frame has been taken in
+#define BOOT_NAK 0x15                 //Sent when a frame was damaged or not allowed, the uploader sends it again
+#define BOOT_DONE 'K'                 //Sent when the image CRC of a pass matches
+#define BOOT_FAILED 'F'               //Sent when the image CRC of a pass doesn't match
+
+//Bootloader Buffers, the frame and the block written over the reset vector are kept in the LCD ring buffer rather than on the compiled stack, which keeps the bootloader off the deepest call path
+//The status LCD has been written out before the bootloader takes over, and nothing else is left running to use the buffer
+#define BOOT_FRAME lcdBuffer                        //Frame being received
+#define BOOT_VECTOR (lcdBuffer + BOOT_FRAME_SIZE)   //Block written over the reset vector, the bootloader's own until the first block of the new image comes in
+
+//Bootloader Reset Vector, written over the first block while an update is in progress so a reset part way through lands in the bootloader rather than a half written image
+#define BOOT_VECTOR_MOVLW (0x3000 | (BOOT_ADDRESS >> 0x08))   //MOVLW with the high byte of the bootloader address
+#define BOOT_VECTOR_MOVWF 0x008A                              //MOVWF PCLATH
+#define BOOT_VECTOR_GOTO (0x2800 | (BOOT_ADDRESS & 0x07FF))  //GOTO the bootloader within the page selected by PCLATH
+
+//Bootloader Placement, the project is built without CCI so the absolute address is given with @ rather than __at(), the simulator defines it away as it calls the bootloader by name
+#ifndef BOOT_PLACEMENT
+#define BOOT_PLACEMENT @ BOOT_ADDRESS
+#endif
+
+//Event Log, a ring of fixed size records in the data EEPROM, every record is the event data, the timestamp high byte, the timestamp low byte and the event type
+//The last byte of a record holds the event type in the first 7 bits and a lap bit in the last bit, the lap bit flips every time the ring wraps so the newest record can be found after a reset
+#define EVENT_RECORD_SIZE 0x04  //Bytes in a single record
+#define EVENT_LOG_SIZE 0xC0     //Bytes of data EEPROM taken by the ring, 48 records, the rest holds the calibration
+#define EVENT_QUEUE_MASK 0x1F   //Size of the event queue minus 1, holds up to 7 records waiting to be written into the data EEPROM
+
+//Event Types
+#define EVENT_POWER_UP 0x01         //The panel has powered up or been reset, no data
+#define EVENT_GENERAL_ALARM 0x02    //General alarm condition, data is the SLC's it came in on
+#define EVENT_PRE_ALARM 0x03        //Pre-alarm condition, data is the SLC's it came in on
+#define EVENT_SLC_TROUBLE 0x04      //Trouble condition on SLC's, data is the SLC's it came in on
+#define EVENT_SLC_RESTORE 0x05      //Trouble condition restored on SLC's, data is the SLC's it was restored on
+#define EVENT_NAC_TROUBLE 0x06      //Trouble condition on NAC's, data is the NAC's it came in on
+#define EVENT_NAC_RESTORE 0x07      //Trouble condition restored on NAC's, data is the NAC's it was restored on
+#define EVENT_ACKNOWLEDGE 0x08      //Acknowledge button pushed, data is the un-acknowledged conditions left afterwards
+#define EVENT_SILENCE 0x09          //Silence button pushed, data is the output state of the NAC's afterwards
+#define EVENT_SYSTEM_RESET 0x0A     //Reset button pushed, data is the general alarm cause at the time of the reset
+#define EVENT_CALIBRATION 0x0B      //Calibration learnt and being stored, no data
+#define EVENT_UPDATE 0x0C           //Firmware update started over the software update port, no data
+#define EVENT_POWER_TROUBLE 0x0D    //General trouble condition, data is the troubles that came in, first bit is AC power loss and second bit is a low battery
+#define EVENT_POWER_RESTORE 0x0E    //General trouble condition restored, data is the troubles that were restored
+#define EVENT_PEER_ALARM 0x0F       //General alarm condition that came in from another panel on the network, no data
+
+//Telemetry, frames of the causes and the raw ADC readings sent into hidden display RAM past the end of the zone line, so a receiver on PORTC6 can follow the panel without the status LCD showing them
+//A frame is 0xFE 0xD0, a header, the items and an end item, every byte after the command is below 0x80, so the LCD takes it as a character and 0xFE only ever starts a command
+#define TELEMETRY_CURSOR 0xD0              //Command byte that moves the cursor past the end of the zone line, 24 bytes of hidden display RAM follow
+#define TELEMETRY_FRAME_BYTES 0x1A         //Most bytes in a frame, 2 bytes to move the cursor and 24 bytes of hidden display RAM
+#define TELEMETRY_ITEM_BYTES 0x15          //Most bytes of items in a frame, the header and the end item take up the rest
+#define TELEMETRY_HEARTBEAT 0x40           //Header bit set on a heartbeat, the first 6 bits of the header are the sequence number
+#define TELEMETRY_SEQUENCE_MASK 0x3F       //Sequence numbers count up by 1 every frame and wrap around after 63
+#define TELEMETRY_DELTA 0x00               //Item with the change of a reading since it was last sent, the channel in the first 4 bits and the change as a 6 bit two's complement in the next byte
+#define TELEMETRY_READING 0x10             //Item with a whole reading, the channel in the first 4 bits and the 8 bit reading in the next 2 bytes, the top bit first
+#define TELEMETRY_CAUSE 0x20               //Item with a cause bitmap, the cause in the first 3 bits, the top bit of the bitmap in the fourth bit and the other 7 bits in the next byte
+#define TELEMETRY_END 0x7F                 //Item ending the frame, followed by the sum of every byte from the header on in 7 bits
+#define TELEMETRY_CAUSE_COUNT 0x05         //Cause bitmaps sent, general alarm, pre-alarm, SLC trouble, NAC trouble and general trouble
+#define TELEMETRY_DEADBAND 0x02            //Change the top 8 bits of a reading have to make before it is sent again, keeps the noise on a reading off the link
+#define TELEMETRY_HEARTBEAT_COUNTS 0x20    //Utility counter counts between heartbeats, about 2 seconds as the counter counts every Timer 0 overflow
+#define TELEMETRY_HEARTBEAT_READINGS 0x03  //Whole readings sent in every heartbeat, the channels in the scan take turns so every reading is sent whole every 5 heartbeats at most
+
+//Battery Standby, while the AC power is lost and nothing is in alarm the panel slows its clock down, scans a single sweep every Timer 0 overflow and sleeps in between
+#define STANDBY_OSCCON 0x40      //Run the internal RC-Oscillator at 1MHz, a quarter of the full rate
+#define STANDBY_OPTION_REG 0xD5  //Give Timer 0 a pre-scale of 64, so it overflows as often as it does at full rate
+#define STANDBY_BAUDCTL 0x08     //Use the 16 bit baud rate generator, it divides the clock by a quarter as much so the status LCD stays at 9600 baud
+#define STANDBY_WATCHDOG 0x0D    //Enable the watchdog timer with a pre-scale of 2048, it wakes the MCU up after about 66ms, as long as a Timer 0 overflow
+
+//Panel Network, messages on an RS-485 bus wired to PORTC6 and PORTC7 along with the status LCD and the software update port, PORTC0 turns on the driver of the transceiver while a message is sent and its receiver is off while the driver is on
+//A message is 0xFE 0xA0, the state of the panel and the state flipped as a check, the status LCD takes it as moving the cursor past the end of the status line and stores the rest in hidden display RAM
+#define PEER_CURSOR 0xA0            //Command byte a message starts with
+#define PEER_ALARM 0x01             //State bit set while the panel has a general alarm of its own, alarms that came in over the network are never passed on
+#define PEER_HEARTBEAT_COUNTS 0x10  //Utility counter counts between messages while the panel isn't in alarm, about a second
+#define PEER_ALARM_COUNTS 0x04      //Utility counter counts between messages while the panel is in alarm, about a quarter of a second, so a message lost to a collision is soon sent again
+#define PEER_QUIET_TIME 0x08        //Timer 1 high byte counts the bus has to be quiet for before a message is sent, about 2ms or 2 bytes at 9600 baud
+
+//State Store, the verified conditions of the ADC channels packed a bit per channel, in 3 copies of 3 bytes
+//The ADC interrupt builds one copy up reading by reading and copies it whole into the sweep copy as the sweep completes, softwareISR() only reads the sweep copy so it never sees half a sweep
+#define STATE_BUILD 0x00        //Copy the ADC interrupt builds up over a sweep, NAC's aren't read every sweep so their bits carry over from sweep to sweep
+#define STATE_SWEEP 0x03        //Copy of the last whole sweep, written by the ADC interrupt as the sweep completes and read by softwareISR() and the input task
+#define STATE_LAST 0x06         //Copy of the sweep before it, only touched by softwareISR() to find the conditions that have changed
+#define STATE_SLC_ALARM 0x00    //SLC's with a verified alarm condition, first bit is SLC1
+#define STATE_SLC_TROUBLE 0x01  //SLC's with a verified trouble condition, first bit is SLC1
+#define STATE_CHANNELS 0x02     //First 4 bits are the NAC's with a verified trouble condition, fifth bit is a verified low battery
+#define STATE_STORE_SIZE 0x09   //Bytes in the state store
+
+//Scheduler Tasks, the index of each task in the task table, in order of priority
+#define TASK_COUNT 0x04   //Number of tasks in the task table
+#define TASK_ALARM 0x00   //Processes the software interrupts, made ready by the ADC sweep completing and by the input task
+#define TASK_INPUT 0x01   //Samples the buttons and general trouble inputs
+#define TASK_OUTPUT 0x02  //Updates the LED's, buzzer and NAC's, also made ready by the alarm task when it changes them
+#define TASK_LCD 0x03     //Redraws the status LCD, also made ready by the alarm task when a line has changed
+
+//Firmware Update Key, receiving these bytes in a row on the software update port hands the panel over to the bootloader
+const unsigned char bootKey[BOOT_KEY_LENGTH] = {'U', 'P', 'D', 'A', 'T', 'E'};
+
+//Task Periods, the number of Timer 0 overflows between runs of each task, a period of 0 means the task only runs when something else makes it ready
+const unsigned char taskPeriod[TASK_COUNT] = {0x00, 0x01, 0x01, 0x02};
+
+#ifdef CYCLE_STATS
+//Cycle Statistics, only built in when CYCLE_STATS is defined, the index of each counter measured with Timer 1
+#define CYCLE_ISR 0x00           //Each run of hardwareInterruptISR(), not counting the context save and restore around it
+#define CYCLE_SOFTWARE_ISR 0x01  //Each run of softwareISR() from the alarm task
+#define CYCLE_MAIN_LOOP 0x02     //Each pass of the scheduler loop that runs a task, including any hardware interrupts that came in
+#define CYCLE_COUNTERS 0x03      //Number of cycle counters
+#define CYCLE_REPORT_BYTES 0x0F  //Bytes in the report of a single counter, 2 bytes to move the cursor, the tag and 12 hex digits
+
+//Cycle Report Text, a report is sent into the hidden display RAM past the end of the status line so the status LCD never shows it
+const unsigned char cycleReportTag[CYCLE_COUNTERS] = {'I', 'S', 'L'};  //Tag sent at the start of the report of each counter
+const unsigned char cycleHexDigits[] = "0123456789ABCDEF";              //Characters used to send the counters as hex
+#endif
 
 /***************
  *  Variables  *
  ***************/
 
 //Control Variables
-unsigned char slcControl = 0x00;       //Determines if an SLC is disabled via software internally
-unsigned char nacControl = 0xC0;       //First 4 bits determine the output state of the NAC, last 4 bits determine if it's disabled by software
-unsigned char nacTypeControl = 0x0F;   //Determines the type of NAC, first 4 bits determines if it's silence-able, last 4 bits determine if it's used in pre-signal
-unsigned char preAlarmControl = 0x00;  //Determines how the panel should behave in a pre-alarm condition, or if it should just throw a general alarm condition
-unsigned char ledControl = 0x00;       //Controls the state of the LED's on the user interface, last bit are used for flashing the LED's
-unsigned char coderControl = 0x03;     //Used to MUX coding patterns out to the NAC's, first 2 bits NAC 1 coding pattern, next 2 bits NAC 2 coding pattern, etc.
+unsigned char slcControl = PANEL_SLC_ENABLED;  //Power state of the SLC's, shifted out to the SLC control shift register by the output task, a set bit powers the SLC
+unsigned char nacControl = 0x00;  //First 4 bits determine the output state of the NAC, which NAC's are enabled and how they behave is set in panel.cfg
+unsigned char ledControl = 0x00;  //Controls the state of the LED's on the user interface, last bit are used for flashing the LED's
 
 //Cause Tracking Variables
 unsigned char preAlarmCause = 0x00;        //Tracks all the pre-alarm conditions that have occurred during an alarm session
 unsigned char generalAlarmCause = 0x00;    //Tracks all the general alarm conditions that have occurred during an alarm session
 unsigned char slcTroubleCause = 0x00;      //Tracks all the troubles related to the SLC's with no EOL resistor, if a bit is set, that trouble is present
 unsigned char nacTroubleCause = 0x00;      //Tracks all the troubles related to the NAC's, first 4 bits are no EOL trouble conditions, the last 4 bits are a NAC disabled condition
-unsigned char generalTroubleCause = 0x00;  //Tracks general trouble conditions that don't have a dedicated tracker, if a bit is set, that condition is present
+unsigned char generalTroubleCause = 0x00;  //Tracks general trouble conditions that don't have a dedicated tracker, first bit is AC power loss and second bit is a low battery, if a bit is set, that condition is present
 
 //Interrupt Tracking Variables
 unsigned char buttonTracker = 0x00;          //Tracks the previous and newest state of the buttons on the user interface, used by the software interrupt system
-unsigned short slcAlarmTracker = 0x0000;     //Tracks the previous and newest state of alarm conditions on SLC's
-unsigned short slcTroubleTracker = 0x0000;   //Tracks the previous and newest state of trouble conditions on the SLC's
-unsigned char nacTroubleTracker = 0x00;      //Tracks the previous and newest state of trouble conditions on the NAC's
 unsigned char generalTroubleTracker = 0x00;  //Tracks the previous and newest state of general trouble conditions
+unsigned char stateStore[STATE_STORE_SIZE];  //Verified conditions of the ADC channels handed over from the ADC interrupt, left without a bank qualifier so it stays in bank 0 with activeADChannel and generalInterrupt and only ever takes direct addressing, the cause bitmaps stay out of it as the interrupts never touch them and only the tasks write them a whole byte at a time
 
 //Software Interrupts Variables
 unsigned char generalInterrupt = 0x00;         //Used to track general interrupts within the software, primarily used to update the status LCD on the user interface/annunciator panel
@@ -64,27 +296,575 @@ unsigned char generalTroubleInterrupt = 0x00;  //Used to track general trouble c
 
 //Utility Variables
 unsigned char utilityCounter = 0x00;     //Counts up at a rate of 8Hz, used for various tasks needing delay
-unsigned char coderCounter = 0x13;       //Internal NAC coder counter, first 4 bits are used to code the NAC's and the last 4 bits are used to control the temporal coding pattern
+unsigned char coderPhase = 0x00;         //Phase of the NAC coder, indexes the coder table and is shared by every NAC so their patterns stay in step
 unsigned char activeADChannel = 0x00;    //Used by the ADC reading function to load the new value into the appropriate register, first 4 bits determine the active channel, last 4 bits determine the condition of the reading
+unsigned char adcScanIndex = 0x00;       //Position of the active ADC channel within the ADC scan schedule
+bank1 unsigned char channelVerifier[PANEL_SCANNED_CHANNELS];  //Verification histories of each ADC channel in the scan, by slot, first 4 bits are the alarm history and last 4 bits the trouble history, the first bit of each is the newest reading
+bank1 unsigned char channelLimits[PANEL_SCANNED_CHANNELS << 0x01];  //Open and alarm limits of each ADC channel in the scan, by slot, the lowest and highest readings seen while calibrating
+unsigned char calibrationSweeps = 0x00;     //ADC sweeps left to learn the normal bands over, the panel is calibrating while this isn't 0
+unsigned char calibrationWrite = CALIBRATION_WRITES;  //Bytes of the calibration written into the data EEPROM so far
 unsigned char currentConditions = 0x00;  //Used by the user interface to track the types of conditions that are current and if they have been acknowledged
 unsigned char resetCounter = 0x00;       //Used to create a delay for how long a system reset shall take
+unsigned char smokeResetSLCs = 0x00;     //SLC's going through a smoke reset, their readings are ignored until it has finished
+unsigned char smokeResetCounter = 0x00;  //Timer 0 overflows left in the smoke reset, the power is restored once it reaches the settle time
+unsigned char slcControlLatched = 0x00;  //Power state of the SLC's last latched into the SLC control shift register
+unsigned char bootKeyIndex = 0x00;       //Bytes of the firmware update key received in a row so far
+unsigned char updatePending = 0x00;      //Set once the firmware update key has been received, the panel hands over to the bootloader once the LCD and event log are written out
+unsigned char standbyMode = 0x00;        //Set while the panel is running off the battery in standby and scans a sweep every tick, cleared by the ADC interrupt the moment a reading crosses into alarm, the LCD task follows it with the clock
+unsigned char scanParked = 0x00;         //Set while the ADC scan is waiting in standby for the next Timer 0 overflow to start the next sweep
+unsigned char peerAlarmCause = 0x00;     //Set once another panel on the network has gone into alarm, the panel stays in alarm till it is reset like an alarm on one of its own SLC's
+unsigned char peerAlarmInterrupt = 0x00; //Set by the EUSART receive interrupt when a message from a panel in alarm comes in
+#if PANEL_NETWORK == 0x01
+unsigned char peerReceiveState = 0x00;   //Bytes of a message received so far, 0 while waiting for the command prefix
+unsigned char peerReceived = 0x00;       //State of the panel the message being received came from
+unsigned char peerHeard = 0x00;          //Timer 0 overflows left before the bus counts as quiet whatever Timer 1 says, set whenever a byte comes in
+unsigned char peerHeardAt = 0x00;        //Timer 1 high byte when the last byte came in on the bus
+unsigned char peerWait = PEER_QUIET_TIME;  //Timer 1 high byte counts to wait after the last byte before sending, a little different every time so two panels waiting on the bus don't start together
+unsigned char peerStateSent = 0x00;      //State of the panel sent in the last message
+unsigned char peerSentAt = 0x00;         //Utility counter when the last message was sent
+#endif
 unsigned char LATA = 0x00;               //A fake LATA register, this MCU doesn't have one which is kind of annoying
 unsigned char LATB = 0x00;               //A fake LATB register, this MCU doesn't have one which is kind of annoying
 unsigned char LATC = 0x00;               //A fake LATC register, this MCU doesn't have one which is kind of annoying
 unsigned char LATD = 0x00;               //A fake LATD register, this MCU doesn't have one which is kind of annoying
 
+//Status LCD Variables
+bank1 unsigned char lcdBuffer[LCD_BUFFER_MASK + 0x01];  //Ring buffer holding the bytes waiting to be sent out to the status LCD by the EUSART
+unsigned char lcdHead = 0x00;                           //Position in the ring buffer the main loop writes the next byte to
+unsigned char lcdTail = 0x00;                           //Position in the ring buffer the EUSART transmit interrupt sends the next byte from
+unsigned char lcdDirty = 0x03;                          //Lines of the status LCD that need to be redrawn, first bit is the status line, second bit is the zone line
+
+//Telemetry Variables
+bank2 unsigned char channelLevels[PANEL_SCANNED_CHANNELS];    //Top 8 bits of the latest reading of each ADC channel in the scan, by slot, stored by the ADC interrupt
+bank2 unsigned char telemetryLevels[PANEL_SCANNED_CHANNELS];  //Top 8 bits of the reading of each ADC channel in the scan as last sent, by slot, the receiver adds the changes onto these
+unsigned char telemetryCauses[TELEMETRY_CAUSE_COUNT];         //Cause bitmaps as last sent
+unsigned char * const telemetryCauseSources[TELEMETRY_CAUSE_COUNT] = {&generalAlarmCause, &preAlarmCause, &slcTroubleCause, &nacTroubleCause, &generalTroubleCause};  //Cause bitmaps in the order of their number in the frame, read in place as only the tasks ever change them
+unsigned char telemetrySequence = 0x00;                       //Sequence number of the next frame, the receiver spots a lost frame by a gap in the numbers
+unsigned char telemetryHeartbeatAt = 0x00 - TELEMETRY_HEARTBEAT_COUNTS;  //Utility counter at the last heartbeat, starts a heartbeat's time back so the first frame is a heartbeat
+unsigned char telemetryChannel = 0x0D;                        //Channel last sent whole in a heartbeat, the next heartbeat carries on from the channel in the scan after it
+unsigned char telemetryScan = 0x00;                           //Channel the search for changed readings starts from, moved on past the last one sent so every channel gets a turn
+
+//Event Log Variables
+bank2 unsigned char eventQueue[EVENT_QUEUE_MASK + 0x01];  //Ring buffer holding the bytes of the records waiting to be written into the data EEPROM
+unsigned char eventQueueHead = 0x00;                      //Position in the event queue the next record is added at by the main loop
+unsigned char eventQueueTail = 0x00;                      //Position in the event queue the EEPROM write complete interrupt writes the next byte from
+unsigned char eventLogHead = 0x00;                        //Data EEPROM address the next record added to the event queue will be written to
+unsigned char eventLogLap = 0x00;                         //Lap bit written into the records of the current lap around the ring
+unsigned char eventLogAddress = 0x00;                     //Data EEPROM address the next byte from the event queue is written to
+unsigned char eventClock = 0x00;                          //Counts the overflows of the utility counter, the high byte of the event timestamps
+
+//Scheduler Variables
+unsigned char taskReady[TASK_COUNT] = {0x00, 0x01, 0x01, 0x01};      //Set when a task is ready to run, one byte per task so the interrupts and the scheduler never share a byte
+unsigned char taskCountdown[TASK_COUNT] = {0x00, 0x01, 0x01, 0x02};  //Timer 0 overflows left before each task is due to run again
+
+#ifdef CYCLE_STATS
+bank1 unsigned short taskWorstCase[TASK_COUNT];                     //Longest each task has taken to run in instruction cycles, measured with Timer 1, kept with the cycle statistics as it costs 8 bytes of RAM
+//Cycle Statistics Variables
+bank2 unsigned short cycleMin[CYCLE_COUNTERS] = {0xFFFF, 0xFFFF, 0xFFFF};  //Shortest run of each counter in instruction cycles
+bank2 unsigned short cycleMax[CYCLE_COUNTERS];                            //Longest run of each counter in instruction cycles
+bank2 unsigned short cycleLast[CYCLE_COUNTERS];                           //Latest run of each counter in instruction cycles
+unsigned char cycleReport = 0x00;                                         //Counters waiting to be reported over the EUSART, one bit per counter
+unsigned char cycleRequest = 0x00;                                        //Set by the EUSART receive interrupt when a report has been asked for
+#endif
+
+/***************
+ *  Event Log  *
+ ***************/
+
+//Start EEPROM Writes Function, starts the EEPROM write complete interrupt writing out whatever is waiting if the EEPROM is idle
+void startEepromWrites() {
+    //Setting the flag makes the interrupt write the first byte
+    if ((PIE2 & 0x10) == 0x00) {
+        PIR2 |= 0x10;  //Set the EEPROM write complete interrupt flag
+        PIE2 |= 0x10;  //Enable the EEPROM write complete interrupt
+    }
+}
+
+//Log Event Function, adds a record to the event queue to be written into the data EEPROM by the EEPROM write complete interrupt, never waits on the EEPROM
+void logEvent(unsigned char type, unsigned char data) {
+    //Drop the event if the queue is full, the panel must never wait on the data EEPROM
+    if (((eventQueueTail - eventQueueHead - 0x01) & EVENT_QUEUE_MASK) < EVENT_RECORD_SIZE) {
+        return;
+    }
+
+    eventQueue[eventQueueHead] = data;                                                   //Add the event data to the event queue
+    eventQueue[(eventQueueHead + 0x01) & EVENT_QUEUE_MASK] = eventClock;                 //Add the high byte of the timestamp to the event queue
+    eventQueue[(eventQueueHead + 0x02) & EVENT_QUEUE_MASK] = utilityCounter;             //Add the low byte of the timestamp to the event queue
+    eventQueue[(eventQueueHead + 0x03) & EVENT_QUEUE_MASK] = type | eventLogLap;         //Add the event type and lap bit last, so a record cut short by a reset still looks like the old one
+    eventQueueHead = (eventQueueHead + EVENT_RECORD_SIZE) & EVENT_QUEUE_MASK;            //Move on to the position of the next record in the event queue
+
+    //Move on to the next record in the data EEPROM, flipping the lap bit every time the ring wraps back to the start
+    eventLogHead += EVENT_RECORD_SIZE;
+    if (eventLogHead == EVENT_LOG_SIZE) {
+        eventLogHead = 0x00;
+        eventLogLap ^= 0x80;
+    }
+
+    startEepromWrites();  //Start writing the event queue if the EEPROM is idle
+}
+
+/***************
+ *  Telemetry  *
+ ***************/
+
+//Send Telemetry Function, sends a frame with every cause and reading that has changed since it was last sent, and a heartbeat with every cause and a few whole readings about every 2 seconds
+//The frame is built past the end of the LCD ring buffer and only handed to the EUSART if there is something in it, nothing is sent while the panel is steady apart from the heartbeats
+//Only the top 8 bits of each reading are kept and those 8 bits are what the frame carries, a channel that isn't in the scan is never sent
+void sendTelemetry() {
+    unsigned char cause;                          //Cause bitmap being looked at
+    unsigned char position;                       //Position in the ring buffer the next byte of the frame goes to
+    unsigned char length;                         //Bytes of items in the frame so far
+    unsigned char check;                          //Sum of the bytes of the frame from the header on
+    unsigned char heartbeat;                      //Set if the frame is a heartbeat
+    unsigned char channel;                        //ADC channel or cause being looked at
+    unsigned char slot;                           //Slot of the channel being looked at
+    unsigned char i;                              //Channels looked at so far
+    unsigned char level;                          //Top 8 bits of the latest reading of the channel, a single byte so the ADC interrupt can't change it half way through being read
+    unsigned char delta;                          //Change of the top 8 bits since they were last sent, offset by 0x20 so a change a delta item can hold is below 0x40
+
+    //Wait for room for the largest frame, the frame is put together in place so it has to fit whatever ends up in it
+    if (((lcdTail - lcdHead - 0x01) & LCD_BUFFER_MASK) < TELEMETRY_FRAME_BYTES) {
+        return;
+    }
+
+    heartbeat = (unsigned char) (utilityCounter - telemetryHeartbeatAt) >= TELEMETRY_HEARTBEAT_COUNTS;
+
+    //Leave room for the command and the header, which are filled in once the frame is known to be sent
+    position = (lcdHead + 0x03) & LCD_BUFFER_MASK;
+    length = 0x00;
+    check = 0x00;
+
+    //Add every cause that has changed, or all of them in a heartbeat
+    for (channel = 0x00; channel < TELEMETRY_CAUSE_COUNT; channel++) {
+        cause = *telemetryCauseSources[channel];
+        if (heartbeat == 0x01 || cause != telemetryCauses[channel]) {
+            TELEMETRY_PUT(TELEMETRY_CAUSE | ((cause & 0x80) >> 0x04) | channel);  //Add the cause item with the top bit of the bitmap
+            TELEMETRY_PUT(cause & 0x7F);                                         //Add the other 7 bits of the bitmap
+            telemetryCauses[channel] = cause;
+            length += 0x02;
+        }
+    }
+
+    //Add the next few whole readings in a heartbeat, so a receiver that missed a frame catches up on every reading within a few heartbeats
+    if (heartbeat == 0x01) {
+        telemetryHeartbeatAt = utilityCounter;
+
+        for (i = 0x00; i < TELEMETRY_HEARTBEAT_READINGS; i++) {
+            //Move on to the next channel in the scan
+            do {
+                telemetryChannel = telemetryChannel == 0x0D ? 0x00 : telemetryChannel + 0x01;
+            } while (channelLimitSlot[telemetryChannel] == 0xFF);
+
+            slot = channelLimitSlot[telemetryChannel];
+            level = channelLevels[slot];
+            TELEMETRY_PUT(TELEMETRY_READING | telemetryChannel);  //Add the reading item
+            TELEMETRY_PUT(level >> 0x07);                         //Add the top bit of the reading
+            TELEMETRY_PUT(level & 0x7F);                          //Add the other 7 bits of the reading
+            telemetryLevels[slot] = level;
+            length += 0x03;
+        }
+    }
+
+    //Add every reading that has moved out of the deadband since it was last sent, as a change if it fits in a delta item, for as long as there is room
+    channel = telemetryScan;
+    for (i = 0x00; i < 0x0E; i++) {
+        slot = channelLimitSlot[channel];
+
+        if (slot != 0xFF && (unsigned char) (channelLevels[slot] - telemetryLevels[slot] + TELEMETRY_DEADBAND - 0x01) >= TELEMETRY_DEADBAND * 0x02 - 0x01) {
+            level = channelLevels[slot];
+            delta = level - telemetryLevels[slot] + 0x20;
+
+            if (delta < 0x40) {
+                if (length + 0x02 > TELEMETRY_ITEM_BYTES) {
+                    break;
+                }
+                TELEMETRY_PUT(TELEMETRY_DELTA | channel);  //Add the delta item
+                TELEMETRY_PUT((delta - 0x20) & 0x3F);     //Add the change as a 6 bit two's complement
+                length += 0x02;
+            } else {
+                if (length + 0x03 > TELEMETRY_ITEM_BYTES) {
+                    break;
+                }
+                TELEMETRY_PUT(TELEMETRY_READING | channel);  //Add the reading item
+                TELEMETRY_PUT(level >> 0x07);                //Add the top bit of the reading
+                TELEMETRY_PUT(level & 0x7F);                 //Add the other 7 bits of the reading
+                length += 0x03;
+            }
+            telemetryLevels[slot] = level;
+            telemetryScan = channel == 0x0D ? 0x00 : channel + 0x01;  //Start from the next channel next time
+        }
+
+        channel = channel == 0x0D ? 0x00 : channel + 0x01;
+    }
+
+    //Drop the frame if nothing has changed, none of it has been handed to the EUSART
+    if (heartbeat == 0x00 && length == 0x00) {
+        return;
+    }
+
+    //Fill in the command and the header, then end the frame with the check
+    lcdBuffer[lcdHead] = 0xFE;                                                                                     //Send the command prefix to the status LCD
+    lcdBuffer[(lcdHead + 0x01) & LCD_BUFFER_MASK] = TELEMETRY_CURSOR;                                             //Move the cursor past the end of the zone line into hidden display RAM
+    lcdBuffer[(lcdHead + 0x02) & LCD_BUFFER_MASK] = telemetrySequence | (heartbeat == 0x01 ? TELEMETRY_HEARTBEAT : 0x00);  //Set the header
+    check += lcdBuffer[(lcdHead + 0x02) & LCD_BUFFER_MASK];
+    TELEMETRY_PUT(TELEMETRY_END);                                                                                 //Add the end item
+    lcdBuffer[position] = check & 0x7F;                                                                           //Add the check of the frame
+
+    telemetrySequence = (telemetrySequence + 0x01) & TELEMETRY_SEQUENCE_MASK;
+    lcdHead = (position + 0x01) & LCD_BUFFER_MASK;  //Hand the whole frame to the EUSART at once
+    PIE1 |= 0x10;                                   //Enable the EUSART transmit interrupt to start sending the frame
+}
+
+/************
+ *  Timing  *
+ ************/
+
+#ifdef CYCLE_STATS
+//Timer 1 Read Function, reads the free running Timer 1 as a 16 bit value, reading the high byte twice in case the low byte rolled over in between
+unsigned short readTimer1() {
+    unsigned char high = TMR1H;  //Read the high byte of Timer 1
+    unsigned char low = TMR1L;   //Read the low byte of Timer 1
+
+    //Read the timer again if the low byte rolled over into the high byte after the high byte was read
+    if (TMR1H != high) {
+        high = TMR1H;  //Read the high byte of Timer 1 again
+        low = TMR1L;   //Read the low byte of Timer 1 again
+    }
+
+    return (high << 0x08) | low;
+}
+
+//Record Cycles Function, updates the statistics of a cycle counter with the instruction cycles passed since the given Timer 1 value
+void recordCycles(unsigned char counter, unsigned short start) {
+    unsigned short cycles = readTimer1() - start;  //Instruction cycles passed since the start value was read
+
+    cycleLast[counter] = cycles;
+    if (cycles < cycleMin[counter]) {
+        cycleMin[counter] = cycles;
+    }
+    if (cycles > cycleMax[counter]) {
+        cycleMax[counter] = cycles;
+    }
+}
+#endif
+
+/*************
+ *  Standby  *
+ *************/
+
+//Standby Sleep Function, sleeps through the rest of the Timer 0 overflow once the sweep is parked and nothing is left to send or write, the watchdog timer wakes the MCU up again
+//SLEEP stops Timer 0 along with the instruction clock, so the overflow that was slept through is made up for by setting its flag once the MCU is awake
+//Timer 0 keeps what it counted while the MCU was awake, so every so often it overflows on its own as well and the overflows keep their rate on average
+void standbySleep() {
+    INTCON &= 0x7F;  //Disable interrupts, so nothing can start between checking and sleeping
+
+    //The status LCD, the event log and the software update port all need the instruction clock, as does the watchdog timer while it is counting down to a reset
+    //A panel on the network never sleeps, its receiver would miss the messages from the other panels
+    if (PANEL_NETWORK == 0x00 && scanParked == 0x01 && lcdTail == lcdHead && (TXSTA & 0x02) == 0x02 && (PIE2 & 0x10) == 0x00 && (WDTCON & 0x01) == 0x00 && updatePending == 0x00) {
+        WDTCON = STANDBY_WATCHDOG;  //Start the watchdog timer to wake the MCU up after as long as a Timer 0 overflow
+        SLEEP();                    //Sleep till the watchdog timer times out, or an enabled interrupt wakes the MCU up early
+        WDTCON = 0x00;              //Stop the watchdog timer again
+        INTCON |= 0x04;             //Set the Timer 0 overflow flag to take the overflow that was slept through
+    } else {
+        __nop();
+    }
+
+    INTCON |= 0x80;  //Enable interrupts again, anything that woke the MCU up is taken straight away
+}
+
+/*******************
+ *  Panel Network  *
+ *******************/
+
+#if PANEL_NETWORK == 0x01
+
+//Send Peer Message Function, sends the state of the panel onto the network once it has changed or the next message is due and the bus has been quiet for long enough
+//Returns 1 while a message is due or still going out, the LCD task holds everything else back till then so the driver is only ever on for the message
+unsigned char sendPeerMessage() {
+    unsigned char state = generalAlarmCause != 0x00 ? PEER_ALARM : 0x00;  //State of the panel to send
+
+    //Turn off the driver once the message has left the transmit shift register, coming straight back to check till it has
+    if ((LATC & 0x01) == 0x01) {
+        if ((TXSTA & 0x02) == 0x02 && lcdTail == lcdHead) {
+            LATC &= 0xFE;  //Clear the driver enable bit of LATC
+            PORTC = LATC;  //Write the value of LATC to PORTC
+            return 0x00;
+        }
+
+        taskReady[TASK_LCD] = 0x01;
+        return 0x01;
+    }
+
+    //Only send a message that has changed or is due
+    if (state == peerStateSent && (unsigned char) (utilityCounter - peerSentAt) < (state == PEER_ALARM ? PEER_ALARM_COUNTS : PEER_HEARTBEAT_COUNTS)) {
+        return 0x00;
+    }
+
+    //Wait for the status LCD line to be sent out and the bus to be quiet, coming straight back to check again
+    if ((TXSTA & 0x02) == 0x00 || lcdTail != lcdHead || (peerHeard != 0x00 && (unsigned char) (TMR1H - peerHeardAt) < peerWait)) {
+        taskReady[TASK_LCD] = 0x01;
+        return 0x01;
+    }
+
+    LATC |= 0x01;  //Set the driver enable bit of LATC
+    PORTC = LATC;  //Write the value of LATC to PORTC, turning on the driver before the first byte goes out
+
+    LCD_PUSH(0xFE);          //Send the command prefix
+    LCD_PUSH(PEER_CURSOR);   //Send the command byte the message starts with
+    LCD_PUSH(state);         //Send the state of the panel
+    LCD_PUSH(state ^ 0x7F);  //Send the state flipped as the check
+    PIE1 |= 0x10;            //Enable the EUSART transmit interrupt to start sending the message
+
+    peerStateSent = state;
+    peerSentAt = utilityCounter;
+    taskReady[TASK_LCD] = 0x01;  //Come back to turn off the driver once the message has gone out
+    return 0x01;
+}
+#endif
+
+/****************
+ *  Bootloader  *
+ ****************/
+
+//Bootloader Function, takes a new image over the software update port and never returns, the MCU is reset into the new image once it has been written and checked
+//It sits at a fixed address in its own block and calls nothing, so it keeps working with the rest of program memory half written
+//Entered from the input task with interrupts off, or straight from the reset vector if an update was cut short
+void bootloader() BOOT_PLACEMENT {
+    unsigned char length;                  //Bytes of the frame received so far
+    unsigned char idle;                    //Timer 1 overflows since the last byte was received
+    unsigned char i;                       //Byte of the frame being worked on
+    unsigned char work;                    //Working byte of the CRC
+    unsigned char reply;                   //Byte to send back, 0 if there is nothing to send
+    unsigned char finished;                //Set once the MCU is to be reset after the reply has gone out
+    unsigned char writing;                 //Set once the check pass has come through, frames are written from then on
+    unsigned char redirected;              //Set once the reset vector points at the bootloader, the old image can't be gone back to from then on
+    unsigned short address;                //Word address of the block in the frame
+    unsigned short crc;                    //CRC-16 of the frame
+    unsigned short imageCrc;               //CRC-16 of the address and words of every frame taken in during the pass
+
+    //Make the outputs safe, the NAC's and the buzzer are turned off and the Trouble LED shows the panel is out of service
+    PORTA = 0x00;  //Turn off the NAC's
+    PORTB = 0x00;  //Turn off the buzzer
+    PORTD = 0x40;  //Turn on the Trouble LED
+
+    //Run the EUSART at 250000 baud, a reply lasts less than half a bit at 9600 baud so the status LCD throws it away as noise
+    OSCCON = 0x70;   //Set the internal RC-Oscillator to run at 8MHz
+    BAUDCTL = 0x08;  //Use the 16 bit baud rate generator
+    SPBRGH = 0x00;   //Clear the high byte of the baud rate generator
+    SPBRG = 0x07;    //Set the baud rate generator to 7 to run the EUSART at 250000 baud
+    TXSTA = 0x24;    //Enable the transmitter in asynchronous mode using the high speed baud rate
+    RCSTA = 0x90;    //Enable the serial port and the receiver
+    T1CON = 0x31;    //Turn on Timer 1 off the instruction clock with a pre-scale of 8, it overflows about every 262ms and times the gaps between bytes
+
+    //The block written over the reset vector while the update is in progress, MOVLW, MOVWF PCLATH, GOTO the bootloader and a NOP, low byte first
+    BOOT_VECTOR[0x00] = BOOT_VECTOR_MOVLW & 0xFF;
+    BOOT_VECTOR[0x01] = BOOT_VECTOR_MOVLW >> 0x08;
+    BOOT_VECTOR[0x02] = BOOT_VECTOR_MOVWF & 0xFF;
+    BOOT_VECTOR[0x03] = BOOT_VECTOR_MOVWF >> 0x08;
+    BOOT_VECTOR[0x04] = BOOT_VECTOR_GOTO & 0xFF;
+    BOOT_VECTOR[0x05] = BOOT_VECTOR_GOTO >> 0x08;
+    BOOT_VECTOR[0x06] = 0x00;
+    BOOT_VECTOR[0x07] = 0x00;
+
+    //Find out if an update was already in progress, if the reset vector points at the bootloader the old image is already gone
+    redirected = 0x01;
+    for (i = 0x00; i < 0x06; i += 0x02) {
+        BOOT_READ_WORD(i >> 0x01);
+        if (EEDAT != BOOT_VECTOR[i] || EEDATH != BOOT_VECTOR[i + 0x01]) {
+            redirected = 0x00;
+        }
+    }
+
+    length = 0x00;
+    idle = 0x00;
+    writing = 0x00;
+    finished = 0x00;
+    imageCrc = 0xFFFF;
+    reply = BOOT_READY;  //Let the uploader know the bootloader is listening
+
+    while (0x01) {
+        //Send the reply, once the last reply has gone out the MCU is reset, into the new image after a write pass or back into the old image
+        if (reply != 0x00) {
+            while ((PIR1 & 0x10) == 0x00) {
+            }
+            TXREG = reply;  //Send the reply
+            reply = 0x00;
+
+            if (finished == 0x01) {
+                while ((TXSTA & 0x02) == 0x00) {
+                }
+                WDTCON = 0x01;  //Enable the watchdog timer to reset the MCU
+
+                //Wait for the watchdog timer
+                while (0x01) {
+                    __nop();
+                }
+            }
+        }
+
+        //Count the Timer 1 overflows while the line is quiet, any frame cut short is thrown away so the next one starts lined up
+        if ((PIR1 & 0x01) == 0x01) {
+            PIR1 &= 0xFE;  //Clear the Timer 1 overflow flag
+            length = 0x00;
+
+            //Give up waiting, nothing has been written yet so go back to the old image, otherwise start over and wait for the uploader to try again
+            if (++idle == BOOT_TIMEOUT_OVERFLOWS) {
+                idle = 0x00;
+                writing = 0x00;
+                imageCrc = 0xFFFF;
+                reply = BOOT_READY;
+                if (redirected == 0x00) {
+                    reply = BOOT_FAILED;
+                    finished = 0x01;
+                }
+            }
+        }
+
+        //Restart the receiver if a byte was lost, the frame it belonged to is thrown away
+        if ((RCSTA & 0x02) == 0x02) {
+            RCSTA &= 0xEF;  //Clear the CREN bit to clear the overrun
+            RCSTA |= 0x10;  //Set the CREN bit to start receiving again
+            length = 0x00;
+        }
+
+        //Take in the next byte of the frame and start timing the gap after it
+        if ((PIR1 & 0x20) == 0x20) {
+            BOOT_FRAME[length++] = RCREG;
+            TMR1H = 0x00;  //Clear the high byte of Timer 1
+            TMR1L = 0x00;  //Clear the low byte of Timer 1
+            idle = 0x00;
+        }
+
+        //Handle the frame once all of it has come in, it is turned down unless it checks out
+        if (length == BOOT_FRAME_SIZE) {
+            length = 0x00;
+            reply = BOOT_NAK;
+            address = (BOOT_FRAME[0x01] << 0x08) | BOOT_FRAME[0x02];
+
+            crc = 0xFFFF;
+            for (i = 0x00; i < BOOT_FRAME_SIZE - 0x02; i++) {
+                BOOT_CRC(crc, work, BOOT_FRAME[i]);
+            }
+
+            if (crc == ((BOOT_FRAME[0x0B] << 0x08) | BOOT_FRAME[0x0C])) {
+                if (BOOT_FRAME[0x00] == BOOT_END) {
+                    //The address of the end frame carries the image CRC worked out by the uploader
+                    reply = BOOT_FAILED;
+                    if (address == imageCrc) {
+                        reply = BOOT_DONE;
+
+                        //Finish a write pass by writing the first block of the new image, which points the reset vector at it
+                        if (writing == 0x01) {
+                            for (i = 0x00; i < 0x08; i += 0x02) {
+                                BOOT_WRITE_WORD(i >> 0x01, BOOT_VECTOR[i + 0x01], BOOT_VECTOR[i]);
+                            }
+                            finished = 0x01;
+                        }
+                        writing = 0x01;  //The check pass came through, frames are written from now on
+                    } else if (redirected == 0x00) {
+                        finished = 0x01;  //A check pass that didn't come through has left the old image as it was, so go back to it
+                    }
+                    imageCrc = 0xFFFF;  //Start the next pass
+                } else if ((BOOT_FRAME[0x02] & 0x03) == 0x00 && address < BOOT_ADDRESS && BOOT_FRAME[0x00] == (writing == 0x01 ? BOOT_WRITE : BOOT_CHECK)) {
+                    if (writing == 0x01) {
+                        //Point the reset vector at the bootloader before the old image is touched
+                        if (redirected == 0x00) {
+                            for (i = 0x00; i < 0x08; i += 0x02) {
+                                BOOT_WRITE_WORD(i >> 0x01, BOOT_VECTOR[i + 0x01], BOOT_VECTOR[i]);
+                            }
+                            redirected = 0x01;
+                        }
+
+                        //Hold on to the first block till the end, write any other block and read it back so the image CRC covers what is really in program memory
+                        if (address == 0x0000) {
+                            for (i = 0x00; i < 0x08; i++) {
+                                BOOT_VECTOR[i] = BOOT_FRAME[0x03 + i];
+                            }
+                        } else {
+                            for (i = 0x00; i < 0x08; i += 0x02) {
+                                BOOT_WRITE_WORD(address + (i >> 0x01), BOOT_FRAME[0x04 + i], BOOT_FRAME[0x03 + i]);
+                            }
+                            for (i = 0x00; i < 0x08; i += 0x02) {
+                                BOOT_READ_WORD(address + (i >> 0x01));
+                                BOOT_FRAME[0x03 + i] = EEDAT;
+                                BOOT_FRAME[0x04 + i] = EEDATH;
+                            }
+                        }
+                    }
+
+                    for (i = 0x01; i < BOOT_FRAME_SIZE - 0x02; i++) {
+                        BOOT_CRC(imageCrc, work, BOOT_FRAME[i]);
+                    }
+                    reply = BOOT_ACK;
+                }
+            }
+        }
+    }
+}
+
 /****************
  *  Interrupts  *
  ****************/
 
 //Hardware Interrupt ISR Function, called whenever an interrupt occurs on the MCU's builtin interrupt system
 void interrupt hardwareInterruptISR() {
+    unsigned char verifyHistory;  //Working copy of the verification histories of the channel a reading was taken from
+    unsigned char verifyCleared;  //Set if N of the readings in the trouble history of the channel are without a trouble, so a verified trouble goes
+    unsigned char task;           //Task having its period counted down
+    unsigned char level;          //Top 8 bits of the reading taken from the ADC, compared against the limits of the channel
+    unsigned char limit;          //Index of the open limit of the channel a reading was taken from, or the slot of the channel a byte of the calibration belongs to
+    unsigned char band;           //Band a reading falls into, 0 for open, 1 for normal, 2 for alarm and 3 for short
+    unsigned char received;       //Byte received on PORTC7
+    unsigned char channelBit;     //Bit of the channel a reading was taken from in the state store
+#ifdef CYCLE_STATS
+    unsigned short isrStart = readTimer1();  //Timer 1 value the ISR started running at
+#endif
+
     //Internal timing counter, used for things that need delay such as smoke reset, user interface coding and NAC coding
     if ((INTCON & 0x04) == 0x04) {
         INTCON &= 0xFB;  //Clear the Timer 0 overflow interrupt flag to prevent false interrupts
 
         utilityCounter++;  //Increment the counter by 1
 
+        //Carry the utility counter over into the event clock, used to timestamp the event log
+        if (utilityCounter == 0x00) {
+            eventClock++;
+        }
+
+#if PANEL_NETWORK == 0x01
+        //Count down the time since a byte came in on the bus, Timer 1 has wrapped around by the time it runs out
+        if (peerHeard != 0x00) {
+            peerHeard--;
+        }
+#endif
+
+        //Start the next sweep in standby, where the scan waits for the tick rather than starting straight after the last sweep
+        if (scanParked == 0x01) {
+            scanParked = 0x00;  //The scan is running again
+            TMR2 = 0x00;        //Restart the acquisition delay from the beginning
+            T2CON = 0x04;       //Turn on Timer 2, an interrupt will be created once the acquisition delay has passed
+        }
+
+        //Count down the periods of the tasks, making each one ready to run once its period is up
+        for (task = 0x00; task < TASK_COUNT; task++) {
+            if (taskPeriod[task] != 0x00 && --taskCountdown[task] == 0x00) {
+                taskCountdown[task] = taskPeriod[task];  //Start counting down the next period of the task
+                taskReady[task] = 0x01;                  //Make the task ready to run
+            }
+        }
+
+        //Count down the smoke reset, the power is restored once it has been cut for long enough and the readings are used again once the detectors have settled
+        if (smokeResetCounter != 0x00) {
+            smokeResetCounter--;
+
+            if (smokeResetCounter == SMOKE_RESET_SETTLE_TICKS) {
+                slcControl |= smokeResetSLCs;   //Restore power to the SLC's going through the smoke reset
+                taskReady[TASK_OUTPUT] = 0x01;  //Make the output task ready to shift the new power state out
+            } else if (smokeResetCounter == 0x00) {
+                smokeResetSLCs = 0x00;  //Finish the smoke reset, the readings of the SLC's are used again
+            }
+        }
+
         //True every 1st count (8Hz)
         if ((utilityCounter & 0x01) == 0x01) {
             ledControl ^= 0x80;  //XOR the bit used for flashing the LED's on the user interface
@@ -100,29 +880,117 @@ void interrupt hardwareInterruptISR() {
             }
         }
 
+#if PANEL_CODER_PHASES > 0x01
         //True every 2nd count (4Hz)
         if ((utilityCounter & 0x03) == 0x01) {
-            coderCounter ^= 0x02;  //XOR the bit used by the coder to produce a 120 BPM March-Time pattern
+            coderPhase++;  //Move the coder on to its next phase
+
+            //Start the coder table over once the pattern of every enabled NAC has repeated
+            if (coderPhase == PANEL_CODER_PHASES) {
+                coderPhase = 0x00;
+            }
         }
+#endif
 
         //True every 4th count (2Hz)
         if ((utilityCounter & 0x07) == 0x01) {
-            ledControl ^= 0x40;     //XOR the bit used to pulse the buzzer on the user interface to a 60 BPM March-Time pattern
-            coderCounter ^= 0x04;   //XOR the bit used by the coder to produce a 60 BPM March-Time pattern
-            coderCounter += 0x10;   //Increment the counter the coder uses to produce a temporal pattern by 1
+            ledControl ^= 0x40;  //XOR the bit used to pulse the buzzer on the user interface to a 60 BPM March-Time pattern
+        }
+    }
 
-            //Update the temporal output bit of the coder if the pattern hasn't reach 3 pulses yet
-            if ((coderCounter & 0xF0) < 0x70) {
-                coderCounter &= 0xF7;                           //Clear the bit that produces the temporal pattern
-                coderCounter |= (coderCounter & 0x10) >> 0x01;  //Set the bit that produces the temporal pattern to the same state as the first bit in the counter
+    //Start the ADC conversion once the acquisition delay for the selected channel has passed
+    if ((PIR1 & 0x02) == 0x02) {
+        PIR1 &= 0xFD;    //Clear the Timer 2 match interrupt flag to prevent false interrupts
+        T2CON = 0x00;    //Turn off Timer 2 until the next channel has been selected
+        ADCON0 |= 0x02;  //Set the GO bit to start the conversion, an interrupt will be created once the conversion is done
+    }
+
+    //Take in every byte received on PORTC7, from the panel network or the software update port
+    if ((PIR1 & 0x20) == 0x20) {
+        received = RCREG;  //Read the received byte, this clears the receive flag
+
+#if PANEL_NETWORK == 0x01
+        //Note the bus being busy, the wait before sending is taken from the low byte of Timer 1 so it differs a little between panels
+        peerHeard = 0x02;
+        peerHeardAt = TMR1H;
+        peerWait = PEER_QUIET_TIME + (TMR1L & 0x0F);
+
+        //Follow a message from another panel, one with a check that doesn't match was damaged on the bus and is thrown away
+        if (received == 0xFE) {
+            peerReceiveState = 0x01;
+        } else if (peerReceiveState == 0x01 && received == PEER_CURSOR) {
+            peerReceiveState = 0x02;
+        } else if (peerReceiveState == 0x02) {
+            peerReceived = received;
+            peerReceiveState = 0x03;
+        } else {
+            if (peerReceiveState == 0x03 && received == (peerReceived ^ 0x7F) && (peerReceived & PEER_ALARM) == PEER_ALARM && peerAlarmCause == 0x00) {
+                peerAlarmInterrupt = 0x01;      //Let the alarm task know another panel is in alarm
+                taskReady[TASK_ALARM] = 0x01;  //Wake up the alarm task to process it
             }
+            peerReceiveState = 0x00;
+        }
+#endif
+
+        //Follow the firmware update key, a byte out of place starts it over, the input task starts the update once the whole key is in
+        if (bootKeyIndex < BOOT_KEY_LENGTH) {
+            if (received == bootKey[bootKeyIndex]) {
+                bootKeyIndex++;
+            } else {
+                bootKeyIndex = received == bootKey[0x00] ? 0x01 : 0x00;
+#ifdef CYCLE_STATS
+                cycleRequest = 0x01;  //Any byte that isn't part of the key asks for a report
+#endif
+            }
+        }
+    }
 
-            //Reset the temporal coder counter after the pattern has finished
-            if ((coderCounter & 0xF0) == 0x80) {
-                coderCounter &= 0x0F;  //Reset the counter used by the coder to produce another round of the temporal pattern
+    //Send the next byte waiting in the LCD ring buffer out to the status LCD once the EUSART is ready for it
+    if ((PIE1 & 0x10) == 0x10 && (PIR1 & 0x10) == 0x10) {
+        TXREG = lcdBuffer[lcdTail];                      //Load the next byte into the EUSART, this clears the transmit interrupt flag until it is ready for another one
+        lcdTail = (lcdTail + 0x01) & LCD_BUFFER_MASK;  //Move on to the next byte in the ring buffer
+
+        //Turn off the transmit interrupt once the ring buffer is empty, the main loop turns it back on when it adds more bytes
+        if (lcdTail == lcdHead) {
+            PIE1 &= 0xEF;  //Disable the EUSART transmit interrupt
+        }
+    }
+
+    //Write the next byte waiting in the event queue into the data EEPROM once the last write has completed
+    if ((PIR2 & 0x10) == 0x10 && (PIE2 & 0x10) == 0x10) {
+        PIR2 &= 0xEF;  //Clear the EEPROM write complete interrupt flag to prevent false interrupts
+
+        //Check to see if there are any bytes left to write, the event queue goes first, otherwise stop the EEPROM write complete interrupt till the next event is logged
+        if (eventQueueTail != eventQueueHead || calibrationWrite != CALIBRATION_WRITES) {
+            if (eventQueueTail != eventQueueHead) {
+                EEADR = eventLogAddress;                                      //Set the address the byte is written to
+                EEDAT = eventQueue[eventQueueTail];                           //Set the byte to write
+                eventLogAddress = eventLogAddress + 0x01 == EVENT_LOG_SIZE ? 0x00 : eventLogAddress + 0x01;  //Move on to the next address, wrapping around to the start of the ring at the end
+                eventQueueTail = (eventQueueTail + 0x01) & EVENT_QUEUE_MASK;  //Move on to the next byte in the event queue
+            } else {
+                //Clear the marker, write the limits, then set the marker, so a calibration cut short by a reset is never loaded
+                EEADR = CALIBRATION_ADDRESS;  //Set the address to the marker
+                EEDAT = 0x00;                 //Set the byte to write to a cleared marker
+                if (calibrationWrite == CALIBRATION_WRITES - 0x01) {
+                    EEDAT = CALIBRATION_MARKER;  //Set the byte to write to the marker of a complete calibration
+                } else if (calibrationWrite != 0x00) {
+                    EEADR = CALIBRATION_ADDRESS + calibrationWrite;              //Set the address to the byte of the limits
+                    EEDAT = channelDefaultLimits[calibrationWrite - 0x01];       //Set the byte to write to the default limit, kept for a channel that is never read
+                    limit = channelLimitSlot[(calibrationWrite - 0x01) >> 0x01];  //Find the slot of the channel the byte belongs to
+                    if (limit != 0xFF) {
+                        EEDAT = channelLimits[(limit << 0x01) | ((calibrationWrite - 0x01) & 0x01)];  //Set the byte to write to the learnt limit
+                    }
+                }
+                calibrationWrite++;  //Move on to the next byte of the calibration
             }
 
-            ADCON0 |= 0x02;  //Set the GO bit to start the conversion
+            EECON1 = 0x04;   //Select the data EEPROM and enable writes to it
+            EECON2 = 0x55;   //Write the first half of the unlock sequence, interrupts are already disabled inside the ISR
+            EECON2 = 0xAA;   //Write the second half of the unlock sequence
+            EECON1 |= 0x02;  //Set the WR bit to start the write, an interrupt will be created once the write is done
+        } else {
+            EECON1 = 0x00;  //Disable writes to the data EEPROM
+            PIE2 &= 0xEF;   //Disable the EEPROM write complete interrupt
         }
     }
 
@@ -131,51 +999,165 @@ void interrupt hardwareInterruptISR() {
         PIR1 &= 0xBF;  //Clear the ADC read complete flag to prevent false interrupts
 
         //Handle the new reading, determine what condition the reading is
+        activeADChannel &= 0x0F;                            //Clear the condition flag bits
+        level = ADRESH;                                     //Take the top 8 bits of the reading, the result is left justified so the bottom 2 bits in ADRESL are never needed
+        limit = channelLimitSlot[activeADChannel] << 0x01;  //Find the open limit of the channel, the alarm limit follows it, only channels in the scan are ever read so the channel always has a slot
+        channelLevels[limit >> 0x01] = level;               //Keep the reading for the telemetry
+
+        //Put the reading into a band, the limits of a channel are in order so every limit the reading reaches moves it up a band, all 3 are always compared so no band skips a compare
+        band = 0x00;
+        if (level >= channelLimits[limit]) {
+            band++;
+        }
+        if (level >= channelLimits[limit + 0x01]) {
+            band++;
+        }
+        if (level >= channelShortLimit[activeADChannel]) {
+            band++;
+        }
+
+        //Learn the normal band of the channel while calibrating, every reading is taken as normal till the limits are in place
+        if (calibrationSweeps != 0x00) {
+            if (level < channelLimits[limit]) {
+                channelLimits[limit] = level;  //Keep the lowest reading seen in place of the open limit
+            }
+            if (level > channelLimits[limit + 0x01]) {
+                channelLimits[limit + 0x01] = level;  //Keep the highest reading seen in place of the alarm limit
+            }
+            band = 0x01;
+        }
+
+        //Supervise a NAC only while it is off, a NAC that is being driven reads as a short
+        if (activeADChannel < 0x04 && (nacControl & (0x01 << activeADChannel)) != 0x00) {
+            band = 0x01;
+        }
+
+        activeADChannel |= channelBands[activeADChannel][band];  //Set the condition flag bits of the band
+
+        //Go back to the full scan rate the moment a reading crosses into alarm, so the alarm is verified at the full scan rate rather than a sweep every tick
+        //Only the scan rate is switched here, a byte may be on its way out of the EUSART, so the LCD task puts the clock back once it has left
+        if (standbyMode == 0x01 && (activeADChannel & 0x10) == 0x10) {
+            standbyMode = 0x00;
+            taskReady[TASK_LCD] = 0x01;  //Wake up the LCD task to put the clock back to full rate
+        }
+
+        //Run the conditions of the reading through the verification histories of the channel, so a noisy reading can't cause a condition on its own
+        verifyHistory = (channelVerifier[limit >> 0x01] << 0x01) & 0xEE;  //Load the verification histories of the channel the reading was taken from, shifting the oldest reading out of each
+        if ((activeADChannel & 0x10) == 0x10) {
+            verifyHistory |= 0x01;  //Add the reading to the alarm history if it is an alarm condition
+        }
+        if ((activeADChannel & 0x60) != 0x00) {
+            verifyHistory |= 0x10;  //Add the reading to the trouble history if it is a trouble condition
+        }
+
+        //Throw away the readings of an SLC going through a smoke reset, an SLC with its power cut reads as if it has no EOL resistor
+        if ((activeADChannel & 0x0F) >= 0x06 && (smokeResetSLCs & (0x01 << ((activeADChannel & 0x0F) - 0x06))) != 0x00) {
+            verifyHistory = 0x00;  //Clear both verification histories, so the SLC has to verify any condition from scratch once the smoke reset finishes
+        }
+
+        channelVerifier[limit >> 0x01] = verifyHistory;  //Store the updated verification histories of the channel
+
+        //Replace the conditions of the reading with the verified conditions of the channel
         activeADChannel &= 0x0F;  //Clear the condition flag bits
 
-        //Check to see if the reading is considered an alarm condition
-        if (ADRESL >= 0x55 && (ADRESH & 0x03) >= 0x03) {
+        //Check to see if the channel has a verified alarm condition
+        if (verifyHistoryCount[verifyHistory & 0x0F] >= (channelVerifyCount[activeADChannel] & 0x0F)) {
             activeADChannel |= 0x10;  //Set the alarm condition flag bit
         }
 
-        //Check to see if the reading is considered as a trouble condition for an SLC
-        if (!(ADRESL >= 0xEF && (ADRESH & 0x03) == 0x01) && (ADRESL <= 0x03 && (ADRESH & 0x03) == 0x02)) {
-        //if (!(ADRESL >= 0xEF && (ADRESH & 0x03) == 0x01)) {
-            //activeADChannel |= 0x20;  //Set the SLC trouble condition flag bit
+        //Check to see if the channel has a verified trouble condition
+        if (verifyHistoryCount[verifyHistory >> 0x04] >= channelVerifyCount[activeADChannel & 0x0F] >> 0x04) {
+            activeADChannel |= (activeADChannel < 0x04) ? 0x40 : 0x20;  //Set the NAC or SLC trouble condition flag bit depending on the channel
         }
 
-        //Check to see if the reading is considered as a trouble condition for a NAC
-        if (ADRESL <= 0x0F && (ADRESH & 0x03) == 0x00) { //(nacControl & 0x0F ^ 0x0F) & (0x01 << (activeADChannel & 0x03))
-            //activeADChannel |= 0x40;  //Set the NAC trouble condition flag bit
+        //Check to see if enough readings in the trouble history are without a trouble for a verified trouble to go, between the two counts a verified trouble stays as it was
+        verifyCleared = 0x00;
+        if (VERIFY_WINDOW - verifyHistoryCount[verifyHistory >> 0x04] >= channelVerifyCount[activeADChannel & 0x0F] >> 0x04) {
+            verifyCleared = 0x01;  //Let a verified trouble go
         }
 
-        //Determine if the selected ADC channel is an SLC or NAC and then update the interrupt trackers
+        //Determine if the selected ADC channel is an SLC, a NAC or the battery monitor and then update its bits in the copy of the state store being built, the bit is shifted into place once as an 8 bit value
+        //A trouble bit is set by a verified trouble and only cleared once the trouble is let go, so a trouble that comes and goes doesn't flap
         if ((activeADChannel & 0x0F) < 0x04) {
-//            nacTroubleTracker &= 0xFF ^ (0x01 << (activeADChannel & 0x0F));                       //Clear the trouble tracker bit that belong to the NAC that the reading was taken from
-//            nacTroubleTracker |= ((activeADChannel & 0x40) >> 0x06) << (activeADChannel & 0x0F);  //Set the trouble condition bit of the trouble tracker if the condition still exists
+            channelBit = 0x01 << (activeADChannel & 0x0F);  //Bit of the NAC the reading was taken from
+            if ((activeADChannel & 0x40) == 0x40) {
+                stateStore[STATE_BUILD + STATE_CHANNELS] |= channelBit;  //Set the trouble bit of the NAC if the condition exists
+            } else if (verifyCleared == 0x01) {
+                stateStore[STATE_BUILD + STATE_CHANNELS] &= channelBit ^ 0xFF;  //Clear the trouble bit of the NAC once the condition has gone
+            }
         } else if ((activeADChannel & 0x0F) >= 0x06) {
-            slcAlarmTracker &= 0xFFFF ^ (0x01 << ((activeADChannel & 0x0F) - 0x06));                       //Clear the alarm tracker bit that belongs to the SLC that the reading was taken from
-            slcAlarmTracker |= ((activeADChannel & 0x10) >> 0x04) << ((activeADChannel & 0x0F) - 0x06);    //Set the alarm condition bit of the alarm tracker if the condition still exists
-            slcTroubleTracker &= 0xFFFF ^ (0x01 << ((activeADChannel & 0x0F) - 0x06));                     //Clear the trouble tracker bit that belongs to the SLC that the reading was taken from
-            slcTroubleTracker |= ((activeADChannel & 0x20) >> 0x05) << ((activeADChannel & 0x0F) - 0x06);  //Set the trouble condition bit of the alarm tracker if the condition still exists
+            channelBit = 0x01 << ((activeADChannel & 0x0F) - 0x06);            //Bit of the SLC the reading was taken from
+            stateStore[STATE_BUILD + STATE_SLC_ALARM] &= channelBit ^ 0xFF;  //Clear the alarm bit of the SLC
+            if ((activeADChannel & 0x10) == 0x10) {
+                stateStore[STATE_BUILD + STATE_SLC_ALARM] |= channelBit;  //Set the alarm bit of the SLC if the condition still exists
+            }
+            if ((activeADChannel & 0x20) == 0x20) {
+                stateStore[STATE_BUILD + STATE_SLC_TROUBLE] |= channelBit;  //Set the trouble bit of the SLC if the condition exists
+            } else if (verifyCleared == 0x01) {
+                stateStore[STATE_BUILD + STATE_SLC_TROUBLE] &= channelBit ^ 0xFF;  //Clear the trouble bit of the SLC once the condition has gone
+            }
+        } else if ((activeADChannel & 0x0F) == BATTERY_CHANNEL) {
+            if ((activeADChannel & 0x20) == 0x20) {
+                stateStore[STATE_BUILD + STATE_CHANNELS] |= 0x10;  //Set the low battery bit if the condition exists
+            } else if (verifyCleared == 0x01) {
+                stateStore[STATE_BUILD + STATE_CHANNELS] &= 0xEF;  //Clear the low battery bit once the condition has gone
+            }
+        }
+
+        //Hand the whole sweep over to softwareISR() in one go once its last reading is in, nothing else writes the sweep copy so it can't be read half updated
+        if ((adcScanSchedule[adcScanIndex] & 0x80) == 0x80) {
+            stateStore[STATE_SWEEP + STATE_SLC_ALARM] = stateStore[STATE_BUILD + STATE_SLC_ALARM];
+            stateStore[STATE_SWEEP + STATE_SLC_TROUBLE] = stateStore[STATE_BUILD + STATE_SLC_TROUBLE];
+            stateStore[STATE_SWEEP + STATE_CHANNELS] = stateStore[STATE_BUILD + STATE_CHANNELS];
+        }
+
+        generalInterrupt |= adcScanSchedule[adcScanIndex] & 0x80;  //Set the ADC sweep complete interrupt flag if this was the last reading of a sweep, so the trackers are processed before the next sweep starts
+        taskReady[TASK_ALARM] |= adcScanSchedule[adcScanIndex] >> 0x07;  //Make the alarm task ready to run if this was the last reading of a sweep
+
+        //Move on to the next channel in the scan schedule
+        adcScanIndex++;  //Increment the position in the scan schedule by 1
+
+        //Check to see if the end of the scan schedule has been reached
+        if (adcScanIndex >= sizeof(adcScanSchedule)) {
+            adcScanIndex = 0x00;  //Reset the position back to the start of the scan schedule to go through it again
         }
 
-        generalInterrupt |= 0x80;  //Set the start ADC conversion interrupts flag to start the ADC conversion
+        activeADChannel &= 0xF0;                                  //Clear the ADC selection bits to load the next channel
+        activeADChannel |= adcScanSchedule[adcScanIndex] & 0x0F;  //Load the next channel in the scan schedule into the ADC selection bits
+
+        //Move straight on to the next channel, unless the sweep is complete and the trackers have to be processed first
+        if ((generalInterrupt & 0x80) == 0x00) {
+            ADCON0 &= 0xC1;                              //Clear the ADC channel selection bits to write the next channel
+            ADCON0 |= (activeADChannel & 0x0F) << 0x02;  //Set ADCON0 to the new ADC channel
+            TMR2 = 0x00;                                 //Restart the acquisition delay from the beginning
+            T2CON = 0x04;                                //Turn on Timer 2, an interrupt will be created once the acquisition delay has passed
+        }
     }
+
+#ifdef CYCLE_STATS
+    recordCycles(CYCLE_ISR, isrStart);  //Record how long the ISR took to run
+#endif
 }
 
 //Software ISR Function, processes all interrupts that are controlled within software
 void softwareISR() {
+    unsigned char limit;  //ADC channel being calibrated, or the SLC channel being checked for an alarm being verified
+    unsigned char slot;   //Index of the open limit of the channel being calibrated
+
     //Process interrupts related to SLC's
     //Check to see if an SLC has detected any new alarm conditions, and then process them accordingly
     if (slcAlarmInterrupt != 0x00 && slcAlarmInterrupt != ((generalAlarmCause | preAlarmCause) & slcAlarmInterrupt)) {
         //Check to see if any general alarm conditions have occurred yet before putting the panel in pre-alarm if applicable
-        if (preAlarmCause == 0x00 && (preAlarmControl & 0x01) == 0x01) {
+        if (PANEL_PRE_ALARM == 0x01 && preAlarmCause == 0x00) {
             preAlarmCause |= slcAlarmInterrupt;  //Set the pre-alarm cause to the SLC that the pre-alarm condition occurred on
             generalInterrupt |= 0x01;            //Set the pre-alarm condition occurred flag bit of the general interrupt variable
+
+            logEvent(EVENT_PRE_ALARM, slcAlarmInterrupt);  //Log the pre-alarm condition along with the SLC it occurred on
         } else {
             generalAlarmCause |= slcAlarmInterrupt;  //Set the general alarm cause to the SLC that the general alarm condition occurred on
             generalInterrupt |= 0x02;                //Set the general alarm condition occurred flag bit of the general interrupt variable
+
+            logEvent(EVENT_GENERAL_ALARM, slcAlarmInterrupt);  //Log the general alarm condition along with the SLC it occurred on
         }
 
         slcAlarmInterrupt &= slcAlarmInterrupt ^ 0xFF;  //Clear the bit(s) that triggered the SLC alarm condition interrupt to prevent false interrupts from occurring
@@ -189,46 +1171,81 @@ void softwareISR() {
     }
 
     //Check to see if an SLC has detected any new trouble conditions, and then process them accordingly
-    if (slcTroubleInterrupt != 0x00 && slcTroubleInterrupt != (slcTroubleCause & slcTroubleInterrupt)) {
-        slcTroubleCause |= slcTroubleInterrupt;  //Set the cause of the trouble to the SLC that caused the trouble condition
-        generalInterrupt |= 0x04;                //Set the trouble condition occurred flag bit of the general interrupt variable
-
-        slcTroubleInterrupt &= slcTroubleInterrupt ^ 0xFF;  //Clear the bit(s) that triggered the SLC trouble condition interrupt to prevent false interrupts from occurring
+    if ((slcTroubleInterrupt & (slcTroubleCause ^ 0xFF)) != 0x00) {
+        generalInterrupt |= 0x04;  //Set the trouble condition occurred flag bit of the general interrupt variable
     }
 
-    //Check to see if any trouble conditions have been restored, and then process them accordingly
-    if (slcTroubleInterrupt != 0x00 && slcTroubleInterrupt != (slcTroubleCause & slcTroubleInterrupt)) {
-        slcTroubleInterrupt &= 0xFF ^ slcTroubleInterrupt;  //Clear the bit(s) that corresponds to the SLC that the trouble condition is no longer present on, as the the trouble condition no longer exists
+    //Every bit in the SLC trouble interrupt is a change in state, so new trouble conditions set their cause bit and restored ones clear it
+    if (slcTroubleInterrupt != 0x00) {
+        //Log the SLC's a trouble condition has come in on and the ones it has been restored on
+        if ((slcTroubleInterrupt & (slcTroubleCause ^ 0xFF)) != 0x00) {
+            logEvent(EVENT_SLC_TROUBLE, slcTroubleInterrupt & (slcTroubleCause ^ 0xFF));
+        }
+        if ((slcTroubleInterrupt & slcTroubleCause) != 0x00) {
+            logEvent(EVENT_SLC_RESTORE, slcTroubleInterrupt & slcTroubleCause);
+        }
 
-        slcTroubleInterrupt &= slcTroubleInterrupt ^ 0xFF;  //Clear the bit(s) that triggered the SLC trouble condition interrupt to prevent false interrupts from occurring
+        slcTroubleCause ^= slcTroubleInterrupt;  //Update the cause of the trouble to the SLC's that currently have a trouble condition
+        slcTroubleInterrupt = 0x00;              //Clear the bits that triggered the SLC trouble condition interrupt to prevent false interrupts from occurring
+        lcdDirty |= 0x03;                        //Redraw both lines of the status LCD to show the change in trouble conditions
     }
 
 
     //Process interrupts related to NAC's
     //Check to see if a NAC has detected any new trouble conditions, and then process them accordingly
-    if (nacTroubleInterrupt != 0x00 && nacTroubleInterrupt != (nacTroubleCause & nacTroubleInterrupt)) {
-        nacTroubleCause |= nacTroubleInterrupt;  //Set the cause of the trouble to the NAC that caused the trouble condition
-        generalInterrupt |= 0x04;                //Set the trouble condition occurred flag bit of the general interrupts variable
+    if ((nacTroubleInterrupt & (nacTroubleCause ^ 0xFF)) != 0x00) {
+        generalInterrupt |= 0x04;  //Set the trouble condition occurred flag bit of the general interrupts variable
+    }
 
-        nacTroubleInterrupt &= nacTroubleInterrupt ^ 0xFF;  //Clear the bit(s) that triggered the NAC trouble condition to prevent false interrupts from occurring
+    //Every bit in the NAC trouble interrupt is a change in state, so new trouble conditions set their cause bit and restored ones clear it
+    if (nacTroubleInterrupt != 0x00) {
+        //Log the NAC's a trouble condition has come in on and the ones it has been restored on
+        if ((nacTroubleInterrupt & (nacTroubleCause ^ 0xFF)) != 0x00) {
+            logEvent(EVENT_NAC_TROUBLE, nacTroubleInterrupt & (nacTroubleCause ^ 0xFF));
+        }
+        if ((nacTroubleInterrupt & nacTroubleCause) != 0x00) {
+            logEvent(EVENT_NAC_RESTORE, nacTroubleInterrupt & nacTroubleCause);
+        }
+
+        nacTroubleCause ^= nacTroubleInterrupt;  //Update the cause of the trouble to the NAC's that currently have a trouble condition
+        nacTroubleInterrupt = 0x00;              //Clear the bits that triggered the NAC trouble condition interrupt to prevent false interrupts from occurring
+        lcdDirty |= 0x03;                        //Redraw both lines of the status LCD to show the change in trouble conditions
     }
 
-    //Check to see if any trouble conditions have been restored, and then process them accordingly
-    if (nacTroubleInterrupt != 0x00 & nacTroubleInterrupt == (nacTroubleCause & nacTroubleInterrupt)) {
-        nacTroubleCause &= 0xFF ^ nacTroubleInterrupt;  //Clear the bit(s) that corresponds to the SLC that the trouble condition is no longer present on, as the trouble condition no longer exists
 
-        nacTroubleInterrupt &= nacTroubleInterrupt ^ 0xFF;  //Clear the bit(s) that triggered the NAC trouble condition to prevent false interrupts from occurring
+    //Process interrupts related to general troubles, the loss of AC power and a low battery
+    //Check to see if a general trouble has come in, the power LED follows the AC power loss bit of the cause
+    if ((generalTroubleInterrupt & (generalTroubleCause ^ 0xFF)) != 0x00) {
+        generalInterrupt |= 0x04;  //Set the trouble condition occurred flag bit of the general interrupts variable
+    }
+
+    //Every bit in the general trouble interrupt is a change in state, so new trouble conditions set their cause bit and restored ones clear it
+    if (generalTroubleInterrupt != 0x00) {
+        //Log the general troubles that have come in and the ones that have been restored
+        if ((generalTroubleInterrupt & (generalTroubleCause ^ 0xFF)) != 0x00) {
+            logEvent(EVENT_POWER_TROUBLE, generalTroubleInterrupt & (generalTroubleCause ^ 0xFF));
+        }
+        if ((generalTroubleInterrupt & generalTroubleCause) != 0x00) {
+            logEvent(EVENT_POWER_RESTORE, generalTroubleInterrupt & generalTroubleCause);
+        }
+
+        generalTroubleCause ^= generalTroubleInterrupt;  //Update the cause of the trouble to the general troubles that are currently present
+        generalTroubleInterrupt = 0x00;                  //Clear the bits that triggered the general trouble interrupt to prevent false interrupts from occurring
+        lcdDirty |= 0x01;                                //Redraw the status line of the status LCD to show the change in trouble conditions
     }
 
 
-    //Process interrupts related to general troubles
-    //Check to see if there is a loss of AC power
-    if ((generalTroubleInterrupt & 0x01) == 0x01) {
-        generalTroubleInterrupt &= 0xFE;  //Clear the AC Power Loss trouble flag to prevent false interrupts
+    //Process interrupts related to the panel network
+    //Check to see if another panel has gone into alarm, the panel goes into a general alarm without an SLC of its own so its NAC's sound along with the rest of the network
+    if (peerAlarmInterrupt == 0x01) {
+        peerAlarmInterrupt = 0x00;  //Clear the peer alarm interrupt flag to prevent false interrupts
 
-//        generalTroubleCause |= 0x01;  //Set the AC Power Loss bit to indicate that the trouble condition was caused by loss of AC power
-//        ledControl &= 0xF7;           //Turn off the power LED on the user interface as AC Power has been lost
-//        generalInterrupt |= 0x04;     //Set the general trouble interrupt bit to cause a general trouble condition on the panel
+        if (peerAlarmCause == 0x00) {
+            peerAlarmCause = 0x01;     //Latch the alarm from the network till the panel is reset
+            generalInterrupt |= 0x02;  //Set the general alarm condition occurred flag bit of the general interrupt variable
+
+            logEvent(EVENT_PEER_ALARM, 0x00);  //Log the alarm that came in from the network
+        }
     }
 
 
@@ -237,20 +1254,22 @@ void softwareISR() {
     if ((generalInterrupt & 0x01) == 0x01) {
         generalInterrupt &= 0xFE;  //Clear the pre-alarm condition interrupt flag to prevent false interrupts
 
-        nacControl |= ((nacControl & 0xF0 ^ 0xF0) & (nacTypeControl & 0xF0)) >> 0x04;  //Activate the enabled NAC's used during a pre-alarm condition
-        currentConditions |= 0x01;                                                     //Indicate that there is an unacknowledged pre-alarm condition
-        ledControl &= 0xEC;                                                            //Clear the flash disable bit for the alarm LED in the led control variable to start flashing the LED
-        ledControl |= 0x03;                                                            //Turn on the alarm LED flasher and the buzzer to indicate an un-acknowledged pre-alarm condition on the user interface
+        nacControl |= PANEL_NAC_PRESIGNAL;  //Activate the enabled NAC's used during a pre-alarm condition
+        currentConditions |= 0x01;          //Indicate that there is an unacknowledged pre-alarm condition
+        ledControl &= 0xEC;                 //Clear the flash disable bit for the alarm LED in the led control variable to start flashing the LED
+        ledControl |= 0x03;                 //Turn on the alarm LED flasher and the buzzer to indicate an un-acknowledged pre-alarm condition on the user interface
+        lcdDirty |= 0x03;                   //Redraw both lines of the status LCD to show the pre-alarm condition and the SLC it came in on
     }
 
     //Check to see if a general alarm condition has occurred
     if ((generalInterrupt & 0x02) == 0x02) {
         generalInterrupt &= 0xFD;  //Clear the general alarm condition interrupt flag to prevent false interrupts
 
-        nacControl |= (nacControl & 0xF0 ^ 0xF0) >> 0x04;  //Activate all the enabled NAC's
-        currentConditions |= 0x02;                         //Indicate that there is an un-acknowledged general alarm condition
-        ledControl &= 0xE4;                                //Clear the flash disable bit for the alarm LED in the led control variable to start flashing the alarm LED
-        ledControl |= 0x03;                                //Turn on the alarm LED flasher and the buzzer to indicate an un-acknowledged general alarm condition on the user interface
+        nacControl |= PANEL_NAC_ENABLED;  //Activate all the enabled NAC's
+        currentConditions |= 0x02;        //Indicate that there is an un-acknowledged general alarm condition
+        ledControl &= 0xE4;               //Clear the flash disable bit for the alarm LED in the led control variable to start flashing the alarm LED
+        ledControl |= 0x03;               //Turn on the alarm LED flasher and the buzzer to indicate an un-acknowledged general alarm condition on the user interface
+        lcdDirty |= 0x03;                 //Redraw both lines of the status LCD to show the general alarm condition and the SLC it came in on
     }
 
     //Check to see if a general trouble condition has occurred
@@ -260,93 +1279,75 @@ void softwareISR() {
         currentConditions |= 0x04;  //Indicate that there is an un-acknowledged general trouble condition
         ledControl &= 0xDA;         //Clear the flash disable bit for the trouble LED in the led control variable to start flashing the LED
         ledControl |= 0x05;         //Turn on the trouble LED flasher and the buzzer to indicate an un-acknowledged trouble condition on the user interface
+        lcdDirty |= 0x01;           //Redraw the status line of the status LCD to show the un-acknowledged trouble condition
     }
 
-    //Check to see if it's time to start another conversion on the ADC
+    //Check to see if the ADC has finished reading all the channels
     if ((generalInterrupt & 0x80) == 0x80) {
-        generalInterrupt &= 0x7F;  //Clear the start ADC conversion interrupt flag to prevent false interrupts
-
-        activeADChannel++;  //Increment the counter used to read all the ADC channels by 1
-
-        //Check to see if all the ADC channels have been read
-        if ((activeADChannel & 0x0F) > 0x0D) {
-            activeADChannel &= 0xF0;  //Reset the ADC selection bits back to 0 to cycle through all the channels again
-
-            //Update the interrupt trackers used for detecting interrupts from the SLC's
-            //Cause an alarm interrupt if an alarm condition has been detected
-            slcAlarmTracker ^= 0xFFFF;                                                                           //Invert the output of the tracker to trigger rising edge interrupts
-            slcAlarmInterrupt |= ((slcAlarmTracker & 0x0001 ^ 0x0001) & ((slcAlarmTracker & 0x0100) >> 0x08)) |  //Update the interrupt tracker and set the bits if an alarm condition has come in
-                                 ((slcAlarmTracker & 0x0002 ^ 0x0002) & ((slcAlarmTracker & 0x0200) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0004 ^ 0x0004) & ((slcAlarmTracker & 0x0400) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0008 ^ 0x0008) & ((slcAlarmTracker & 0x0800) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0010 ^ 0x0010) & ((slcAlarmTracker & 0x1000) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0020 ^ 0x0020) & ((slcAlarmTracker & 0x2000) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0040 ^ 0x0040) & ((slcAlarmTracker & 0x4000) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0080 ^ 0x0080) & ((slcAlarmTracker & 0x8000) >> 0x08));
-
-            //Cause an alarm interrupt if an alarm condition has been restored
-            //slcAlarmTracker ^= 0xFFFF;                                                                           //Invert the output of the tracker to trigger falling edge interrupts
-            slcAlarmInterrupt |= ((slcAlarmTracker & 0x0001 ^ 0x0001) & ((slcAlarmTracker & 0x0100) >> 0x08)) |  //Update the interrupt tracker and set the bits if an alarm condition has been restored
-                                 ((slcAlarmTracker & 0x0002 ^ 0x0002) & ((slcAlarmTracker & 0x0200) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0004 ^ 0x0004) & ((slcAlarmTracker & 0x0400) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0008 ^ 0x0008) & ((slcAlarmTracker & 0x0800) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0010 ^ 0x0010) & ((slcAlarmTracker & 0x1000) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0020 ^ 0x0020) & ((slcAlarmTracker & 0x2000) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0040 ^ 0x0040) & ((slcAlarmTracker & 0x4000) >> 0x08)) |
-                                 ((slcAlarmTracker & 0x0080 ^ 0x0080) & ((slcAlarmTracker & 0x8000) >> 0x08));
-            slcAlarmTracker = (slcAlarmTracker & 0x00FF) << 0x08;                                       //Shift the SLC alarm states from the old section to the new section
-
-            //Cause a trouble interrupt if a trouble condition has been detected
-            slcTroubleTracker ^= 0xFFFF;                                                                               //Invert the output of the tracker to trigger rising edge interrupts
-            slcTroubleInterrupt |= ((slcTroubleTracker & 0x0001 ^ 0x0001) & ((slcTroubleTracker & 0x0100) >> 0x08)) |  //Update the interrupt tracker and set the bits if an trouble condition has come in
-                                   ((slcTroubleTracker & 0x0002 ^ 0x0002) & ((slcTroubleTracker & 0x0200) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0004 ^ 0x0004) & ((slcTroubleTracker & 0x0400) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0008 ^ 0x0008) & ((slcTroubleTracker & 0x0800) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0010 ^ 0x0010) & ((slcTroubleTracker & 0x1000) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0020 ^ 0x0020) & ((slcTroubleTracker & 0x2000) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0040 ^ 0x0040) & ((slcTroubleTracker & 0x4000) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0080 ^ 0x0080) & ((slcTroubleTracker & 0x8000) >> 0x08));
-
-            //Cause a trouble interrupt if a trouble condition has been restored
-            slcTroubleTracker ^= 0xFFFF;                                                                               //Invert the output of the tracker to trigger falling edge interrupts
-            slcTroubleInterrupt |= ((slcTroubleTracker & 0x0001 ^ 0x0001) & ((slcTroubleTracker & 0x0100) >> 0x08)) |  //Update the interrupt tracker and set the bits if an trouble condition has been restored
-                                   ((slcTroubleTracker & 0x0002 ^ 0x0002) & ((slcTroubleTracker & 0x0200) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0004 ^ 0x0004) & ((slcTroubleTracker & 0x0400) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0008 ^ 0x0008) & ((slcTroubleTracker & 0x0800) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0010 ^ 0x0010) & ((slcTroubleTracker & 0x1000) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0020 ^ 0x0020) & ((slcTroubleTracker & 0x2000) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0040 ^ 0x0040) & ((slcTroubleTracker & 0x4000) >> 0x08)) |
-                                   ((slcTroubleTracker & 0x0080 ^ 0x0080) & ((slcTroubleTracker & 0x8000) >> 0x08));
-            slcTroubleTracker = (slcTroubleTracker & 0x00FF) << 0x08;                                                  //Shift the SLC trouble states from the old section to the new section
-
-            //Update the interrupt trackers used for detecting interrupts from the NAC's
-            //Cause a trouble interrupt if a trouble condition has been detected
-            nacTroubleTracker ^= 0x0F;                                                                           //Invert the output of the tracker to trigger rising edge interrupts
-            nacTroubleInterrupt |= ((nacTroubleTracker & 0x01 ^ 0x01) & ((nacTroubleTracker & 0x10) >> 0x04)) |  //Update the interrupt tracker and set the bits if an trouble condition has come in
-                                   ((nacTroubleTracker & 0x02 ^ 0x02) & ((nacTroubleTracker & 0x20) >> 0x04)) |
-                                   ((nacTroubleTracker & 0x04 ^ 0x04) & ((nacTroubleTracker & 0x40) >> 0x04)) |
-                                   ((nacTroubleTracker & 0x08 ^ 0x08) & ((nacTroubleTracker & 0x80) >> 0x04));
-
-            //Cause a trouble interrupt if a trouble condition has been restored
-            nacTroubleTracker ^= 0x0F;                                                                           //Invert the output of the tracker to trigger falling edge interrupts
-            nacTroubleInterrupt |= ((nacTroubleTracker & 0x01 ^ 0x01) & ((nacTroubleTracker & 0x10) >> 0x04)) |  //Update the interrupt tracker and set the bits if an trouble condition has been restored
-                                   ((nacTroubleTracker & 0x02 ^ 0x02) & ((nacTroubleTracker & 0x20) >> 0x04)) |
-                                   ((nacTroubleTracker & 0x04 ^ 0x04) & ((nacTroubleTracker & 0x40) >> 0x04)) |
-                                   ((nacTroubleTracker & 0x08 ^ 0x08) & ((nacTroubleTracker & 0x80) >> 0x04));
-            nacTroubleTracker = (nacTroubleTracker & 0x0F) << 0x04;                                              //Shift the NAC trouble states from the old section to the new section
-        }
-
-        //Select the new ADC channel and start the conversion
+        generalInterrupt &= 0x7F;  //Clear the ADC sweep complete interrupt flag to prevent false interrupts
+
+        //Update the interrupt trackers used for detecting interrupts from the SLC's, from the sweep handed over by the ADC interrupt
+        slcAlarmInterrupt |= RISING_EDGES(stateStore[STATE_LAST + STATE_SLC_ALARM], stateStore[STATE_SWEEP + STATE_SLC_ALARM]);        //Set the bits of the SLC's a verified alarm condition has come in on, alarm conditions stay latched until the panel is reset
+        slcTroubleInterrupt |= CHANGED_BITS(stateStore[STATE_LAST + STATE_SLC_TROUBLE], stateStore[STATE_SWEEP + STATE_SLC_TROUBLE]);  //Set the bits of the SLC's a trouble condition has come in on or been restored on
+
+        //Update the interrupt trackers used for detecting interrupts from the NAC's
+        nacTroubleInterrupt |= CHANGED_BITS(stateStore[STATE_LAST + STATE_CHANNELS], stateStore[STATE_SWEEP + STATE_CHANNELS]) & 0x0F;  //Set the bits of the NAC's a trouble condition has come in on or been restored on
+
+        //Keep the sweep to compare the next one against
+        stateStore[STATE_LAST + STATE_SLC_ALARM] = stateStore[STATE_SWEEP + STATE_SLC_ALARM];
+        stateStore[STATE_LAST + STATE_SLC_TROUBLE] = stateStore[STATE_SWEEP + STATE_SLC_TROUBLE];
+        stateStore[STATE_LAST + STATE_CHANNELS] = stateStore[STATE_SWEEP + STATE_CHANNELS];
+
+        //Count down the calibration, once it is over turn the lowest and highest readings of every channel into its limits and store them
+        if (calibrationSweeps != 0x00 && --calibrationSweeps == 0x00) {
+            for (limit = 0x00; limit < 0x0E; limit++) {
+                slot = channelLimitSlot[limit] << 0x01;  //Find the open limit of the channel, the alarm limit follows it
+
+                //A channel that is never read has no limits to set
+                if (slot == 0xFE) {
+                    continue;
+                }
+
+                //A channel that somehow never got a reading keeps its default limits, as does the battery monitor, otherwise the limits are kept a margin away from the normal band
+                if (channelLimits[slot] > channelLimits[slot + 0x01] || limit == BATTERY_CHANNEL) {
+                    channelLimits[slot] = channelDefaultLimits[limit << 0x01];                   //Use the default open limit
+                    channelLimits[slot + 0x01] = channelDefaultLimits[(limit << 0x01) + 0x01];  //Use the default alarm limit
+                } else {
+                    channelLimits[slot] = channelLimits[slot] > CALIBRATION_MARGIN ? channelLimits[slot] - CALIBRATION_MARGIN : 0x00;  //Put the open limit below the lowest reading
+                    channelLimits[slot + 0x01] = channelLimits[slot + 0x01] < channelShortLimit[limit] - CALIBRATION_MARGIN ? channelLimits[slot + 0x01] + CALIBRATION_MARGIN : channelShortLimit[limit];  //Put the alarm limit above the highest reading, without going past the short limit so the bands stay in order
+                }
+            }
+
+            logEvent(EVENT_CALIBRATION, 0x00);  //Log the calibration
+            calibrationWrite = 0x00;            //Start storing the calibration once the event queue has been written out
+            startEepromWrites();                //Start the EEPROM writes if the EEPROM is idle
+            lcdDirty |= 0x01;                   //Redraw the status line of the status LCD now the calibration is over
+        }
+
+        //Stand by on the battery while the AC power is lost, unless an alarm is in, being verified on an SLC or the panel is calibrating
+        //Only an SLC ever has alarm readings in its history, so every channel in the scan can be checked
+        for (limit = 0x00; limit < PANEL_SCANNED_CHANNELS && (channelVerifier[limit] & 0x0F) == 0x00; limit++) {
+        }
+        //Only the scan rate is switched here, the LCD task switches the clock over to match once nothing is left on its way to the status LCD
+        if ((generalTroubleCause & 0x01) == 0x01 && (generalAlarmCause | preAlarmCause | peerAlarmCause | calibrationSweeps) == 0x00 && limit == PANEL_SCANNED_CHANNELS) {
+            if (standbyMode == 0x00) {
+                standbyMode = 0x01;
+                taskReady[TASK_LCD] = 0x01;  //Wake up the LCD task to slow the clock down
+            }
+        } else if (standbyMode == 0x01) {
+            standbyMode = 0x00;
+            taskReady[TASK_LCD] = 0x01;  //Wake up the LCD task to put the clock back to full rate
+        }
+
+        //Select the first ADC channel of the next sweep and start the acquisition delay, in standby the next Timer 0 overflow starts it instead
         ADCON0 &= 0xC1;                              //Clear the ADC channel selection bits to write the next channel
         ADCON0 |= (activeADChannel & 0x0F) << 0x02;  //Set ADCON0 to the new ADC channel
-    
-        //Create a 2 microsecond delay using the no operation macro (compiles as a nop instruction in assembly)
-        __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop();
-        __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop();
-        __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop();
-        __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop();
-        __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop(); __nop();
-        ADCON0 |= 0x02;  //Start the conversion, an interrupt will be created once the conversion is done
+        if (standbyMode == 0x01) {
+            scanParked = 0x01;  //Leave the scan waiting for the next tick
+        } else {
+            TMR2 = 0x00;   //Restart the acquisition delay from the beginning
+            T2CON = 0x04;  //Turn on Timer 2, an interrupt will be created once the acquisition delay has passed
+        }
     }
 
 
@@ -356,6 +1357,16 @@ void softwareISR() {
         buttonInterrupt &= 0xFE;  //Clear the reset button pushed interrupt flag to prevent false interrupts
 
         resetCounter = 0x7F;  //Start the reset counter by setting all the bits in the register
+
+        //Power cycle the SLC's in alarm so latching smoke detectors drop out before the MCU resets, the smoke reset finishes long before the reset counter runs out
+        if (smokeResetCounter == 0x00) {
+            smokeResetSLCs = (generalAlarmCause | preAlarmCause) & PANEL_SLC_ENABLED;  //Pick the SLC's to put through the smoke reset
+            slcControl &= smokeResetSLCs ^ 0xFF;                                       //Cut the power to the SLC's
+            smokeResetCounter = SMOKE_RESET_OFF_TICKS + SMOKE_RESET_SETTLE_TICKS;      //Start the smoke reset, the Timer 0 interrupt does the rest
+            taskReady[TASK_OUTPUT] = 0x01;                                             //Make the output task ready to shift the new power state out
+        }
+
+        logEvent(EVENT_SYSTEM_RESET, generalAlarmCause);  //Log the reset along with the alarm conditions it cleared, the event queue is written out long before the reset counter runs out
     }
 
     //Check to see if the interrupt was caused by the acknowledge button being pushed
@@ -381,6 +1392,9 @@ void softwareISR() {
         if (currentConditions == 0x00) {
             ledControl &= 0xFE;  //Turn off the buzzer as all the un-acknowledged conditions are now acknowledged
         }
+
+        lcdDirty |= 0x01;                                   //Redraw the status line of the status LCD to show the acknowledged state
+        logEvent(EVENT_ACKNOWLEDGE, currentConditions);  //Log the acknowledge along with the conditions still left un-acknowledged
     }
 
     //Check to see if the interrupt was caused by the silence button being pushed
@@ -388,13 +1402,16 @@ void softwareISR() {
         buttonInterrupt &= 0xFB;  //Clear the silence button pushed interrupt flag to prevent false interrupts
 
         //Check to see if a pre-alarm condition is present
-        if (preAlarmCause != 0x00 && generalAlarmCause == 0x00 && (nacTypeControl & 0x0F) != 0x00) {
-            nacControl ^= (((nacControl & 0xF0 ^ 0xF0) & (nacTypeControl & 0xF0)) >> 0x04) & (nacTypeControl & 0x0F);  //Activate/De-Activate any NAC used for during a pre-alarm condition that is not disabled and is silence-able
-            ledControl ^= 0x08;                                                                                        //Toggle the silenced LED to indicate the state of the silenced NAC's
-        } else if (generalAlarmCause != 0x00 && (nacTypeControl & 0x0F) != 0x00){
-            nacControl ^= ((nacControl & 0xF0 ^ 0xF0) >> 0x04) & (nacTypeControl & 0x0F);  //Activate/De-Activate any NAC that is not disabled and is silence-able
-            ledControl ^= 0x08;                                                            //Toggle the silenced LED to indicate the state of the silenced NAC's
+        if (PANEL_NAC_SILENCEABLE != 0x00 && preAlarmCause != 0x00 && generalAlarmCause == 0x00) {
+            nacControl ^= PANEL_NAC_PRESIGNAL & PANEL_NAC_SILENCEABLE;  //Activate/De-Activate any NAC used for during a pre-alarm condition that is not disabled and is silence-able
+            ledControl ^= 0x08;                                         //Toggle the silenced LED to indicate the state of the silenced NAC's
+        } else if (PANEL_NAC_SILENCEABLE != 0x00 && (generalAlarmCause | peerAlarmCause) != 0x00) {
+            nacControl ^= PANEL_NAC_ENABLED & PANEL_NAC_SILENCEABLE;  //Activate/De-Activate any NAC that is not disabled and is silence-able
+            ledControl ^= 0x08;                                       //Toggle the silenced LED to indicate the state of the silenced NAC's
         }
+
+        lcdDirty |= 0x01;                                 //Redraw the status line of the status LCD to show the silenced state
+        logEvent(EVENT_SILENCE, nacControl & 0x0F);  //Log the silence along with the NAC's that are left active
     }
 
     //Check to see if the interrupt was caused by the function button being pushed
@@ -403,26 +1420,306 @@ void softwareISR() {
     }
 }
 
+/***********
+ *  Tasks  *
+ ***********/
+
+//Alarm Task Function, processes the software interrupts once an ADC sweep completes or an input changes, and wakes up the tasks that show the results
+void alarmTask() {
+    unsigned char nacSnapshot = nacControl;  //State of the NAC's before the software interrupts were processed
+    unsigned char ledSnapshot = ledControl;  //State of the LED's before the software interrupts were processed
+#ifdef CYCLE_STATS
+    unsigned short softwareStart = readTimer1();  //Timer 1 value the software interrupts started being processed at
+#endif
+
+    softwareISR();  //Process all software based interrupts
+#ifdef CYCLE_STATS
+    recordCycles(CYCLE_SOFTWARE_ISR, softwareStart);  //Record how long the software interrupts took to process
+#endif
+
+    //Start the coder over when the first NAC comes on, so every pattern starts on its first pulse and any NAC coming on later falls in step with the rest
+    if (nacSnapshot == 0x00 && nacControl != 0x00) {
+        coderPhase = 0x00;
+    }
+
+    //Update the outputs straight away if the software interrupts changed them, rather than waiting for the next period of the output task
+    if (nacControl != nacSnapshot || ledControl != ledSnapshot) {
+        taskReady[TASK_OUTPUT] = 0x01;
+    }
+
+    //Redraw the status LCD straight away if the software interrupts changed it
+    if (lcdDirty != 0x00) {
+        taskReady[TASK_LCD] = 0x01;
+    }
+}
+
+//Input Task Function, samples the buttons on the user interface and the general trouble inputs
+void inputTask() {
+    //Update the interrupt trackers used for detecting interrupts from the user interface buttons
+    buttonTracker = (buttonTracker & 0x0F) << 0x04;                                //Shift the button states from the new section to the old section
+    buttonTracker |= (PORTD & 0x0F) ^ 0x0F;                                        //Read the first 4 bits from PORTD to the first 4 bits of buttonTracker
+    buttonInterrupt |= FALLING_EDGES(buttonTracker >> 0x04, buttonTracker & 0x0F);  //Update the interrupt tracker and set bits if a button has been let go of after being pushed
+
+    //Update the interrupt trackers used for detecting general trouble conditions on the panel
+    generalTroubleTracker = (generalTroubleTracker & 0x0F) << 0x04;                                        //Shift the general trouble states from the new section to the old section
+    generalTroubleTracker |= (((PORTB & 0x80) ^ 0x80) >> 0x07) | ((stateStore[STATE_SWEEP + STATE_CHANNELS] & 0x10) >> 0x03);  //Set the AC power loss bit if PORTB7 has lost the AC power and the low battery bit if the last sweep has a verified one
+    generalTroubleInterrupt |= CHANGED_BITS(generalTroubleTracker >> 0x04, generalTroubleTracker & 0x0F);  //Update the interrupt tracker and set bits if a general trouble has come in or been restored
+
+    //Wake up the alarm task if a button has been pressed or a general trouble has come in
+    if (buttonInterrupt != 0x00 || generalTroubleInterrupt != 0x00) {
+        taskReady[TASK_ALARM] = 0x01;
+    }
+
+    //Start the update once the EUSART receive interrupt has taken in the whole firmware update key, the update hands the panel over to the bootloader
+    if (bootKeyIndex == BOOT_KEY_LENGTH) {
+        bootKeyIndex = 0x00;
+        updatePending = 0x01;
+        logEvent(EVENT_UPDATE, 0x00);  //Log the update
+        lcdDirty |= 0x01;              //Redraw the status line to show the update
+        taskReady[TASK_LCD] = 0x01;    //Wake up the LCD task to redraw it
+    }
+
+#ifdef CYCLE_STATS
+    //Mark every counter to be reported once a byte that isn't part of the key has come in
+    if (cycleRequest == 0x01) {
+        cycleRequest = 0x00;
+        cycleReport = 0x07;          //Mark every counter to be reported
+        taskReady[TASK_LCD] = 0x01;  //Wake up the LCD task to send the report
+    }
+#endif
+
+    //Restart the receiver if a byte was lost, the EUSART stops receiving until the overrun is cleared
+    if ((RCSTA & 0x02) == 0x02) {
+        RCSTA &= 0xEF;  //Clear the CREN bit to clear the overrun
+        RCSTA |= 0x10;  //Set the CREN bit to start receiving again
+    }
+
+    //Hand over to the bootloader once the status LCD shows the update and the event log has been written out, never while an alarm, a smoke reset or a calibration is in progress
+    if (updatePending == 0x01) {
+        if ((generalAlarmCause | preAlarmCause | peerAlarmCause | smokeResetCounter | calibrationSweeps) != 0x00 || calibrationWrite != CALIBRATION_WRITES) {
+            updatePending = 0x00;  //Turn the update down
+            lcdDirty |= 0x01;      //Redraw the status line
+        } else if (lcdDirty == 0x00 && lcdTail == lcdHead && (TXSTA & 0x02) == 0x02 && (PIE2 & 0x10) == 0x00) {
+            INTCON = 0x00;  //Disable every interrupt, the bootloader polls the EUSART
+            bootloader();   //Take the new image, the bootloader resets the MCU once it is done
+        }
+    }
+}
+
+//Output Task Function, writes the state of the LED's, the buzzer, the NAC's and the power of the SLC's out to the ports
+void outputTask() {
+    unsigned char slcBit;  //Bit of the SLC being shifted out to the SLC control shift register
+
+    //Update the LED's on the user interface
+    LATD &= 0x0F;                                                                                             //Clear the last 4 bits of LATD
+    LATD |= ((generalTroubleCause & 0x01) ^ 0x01) << 0x04;                                                    //Write the output state of the Power LED to LATD
+    LATD |= (((ledControl & 0x80) >> 0x02) & ((ledControl & 0x02) << 0x04)) | ((ledControl & 0x10) << 0x01);  //Write the output state of the Alarm LED to LATD
+    LATD |= (((ledControl & 0x80) >> 0x01) & ((ledControl & 0x04) << 0x04)) | ((ledControl & 0x20) << 0x01);  //Write the output state of the Trouble LED to LATD
+    LATD |= (ledControl & 0x08) << 0x04;                                                                      //Write the output state of the Silence LED to LATD
+    PORTD = LATD;                                                                                           //Write the value of LATD to PORTD
+
+    //Update the state of the buzzer on the user interface
+    LATB &= 0xBF;                                                 //Clear the last 2 bits of LATB
+    LATB |= ((ledControl & 0x01) << 0x06) & (ledControl & 0x40);                                              //Write the output state of the buzzer to LATB
+    PORTB = LATB;                                                 //Write the value of LATB to PORTB
+
+    //Update the output state of the NAC's
+    //Each NAC that is on follows its pattern through the coder table, which leaves out the disabled NAC's
+    LATA &= 0x0F;                                           //Clear the last 4 bits of LATA
+    LATA |= (nacControl & coderTable[coderPhase]) << 0x04;  //Write the output state of every NAC to LATA
+    PORTA = LATA;                                           //Write the value of LATA to PORTA
+
+    //Shift the power state of the SLC's out to the SLC control shift register, every change since the last update goes out with a single latch pulse
+    if (slcControl != slcControlLatched) {
+        slcControlLatched = slcControl;  //Take the power state being shifted out, the Timer 0 interrupt may change slcControl at any time
+
+        //Shift SLC8 in first so it ends up on the last output of the shift register and SLC1 on the first
+        for (slcBit = 0x80; slcBit != 0x00; slcBit >>= 0x01) {
+            LATC &= 0xE7;                                                //Clear the data and clock bits of LATC
+            LATC |= (slcControlLatched & slcBit) != 0x00 ? 0x08 : 0x00;  //Put the power state of the SLC onto the data bit
+            PORTC = LATC;                                                //Write the value of LATC to PORTC
+            LATC |= 0x10;                                                //Set the clock bit to shift the bit in on the rising edge
+            PORTC = LATC;                                                //Write the value of LATC to PORTC
+        }
+
+        LATC &= 0xE7;  //Clear the data and clock bits of LATC
+        LATC |= 0x20;  //Set the latch bit to move the shifted bits onto the outputs of the shift register on the rising edge
+        PORTC = LATC;  //Write the value of LATC to PORTC
+        LATC &= 0xDF;  //Clear the latch bit
+        PORTC = LATC;  //Write the value of LATC to PORTC
+    }
+}
+
+//LCD Task Function, redraws a line of the status LCD if one has changed, then sends the telemetry
+void lcdTask() {
+    unsigned char lcdColumn;  //Character of the status LCD line being written into the ring buffer
+    unsigned char lcdLine;    //Status text or cause mask used while writing a line of the status LCD into the ring buffer
+#ifdef CYCLE_STATS
+    unsigned short cycleSnapshot[0x03];  //Copy of the min, max and last of the cycle counter being reported
+#endif
+
+    //Switch the clock over to the scan rate picked by the interrupts before anything else, nothing else goes out till it has
+    //The baud rate generator changes along with the clock, so the switch waits for the last byte to leave the transmit shift register, coming straight back to check till it has
+    if (STANDBY_CLOCK_IS_SLOW() != standbyMode) {
+        if ((TXSTA & 0x02) == 0x00 || lcdTail != lcdHead) {
+            taskReady[TASK_LCD] = 0x01;
+            return;
+        }
+
+        if (standbyMode == 0x01) {
+            STANDBY_CLOCK_SLOW();
+        } else {
+            STANDBY_CLOCK_FULL();
+        }
+    }
+
+    //Send the state of the panel onto the network before anything else, nothing else goes out while a message is due or being sent
+#if PANEL_NETWORK == 0x01
+    if (sendPeerMessage() == 0x01) {
+        return;
+    }
+#endif
+
+    //Update the status LCD, a line is only redrawn after it has changed and once the whole line fits in the ring buffer, so the task never waits on the EUSART
+    if (lcdDirty != 0x00 && ((lcdTail - lcdHead - 0x01) & LCD_BUFFER_MASK) >= LCD_LINE_BYTES) {
+        //Check to see if the status line needs to be redrawn first, otherwise redraw the zone line
+        if ((lcdDirty & 0x01) == 0x01) {
+            lcdDirty &= 0xFE;  //Clear the status line dirty bit as it is being redrawn
+
+            //Pick the text of the highest priority condition present on the panel
+            lcdLine = 0x00;
+            if ((slcTroubleCause | nacTroubleCause | generalTroubleCause) != 0x00) {
+                lcdLine = 0x01;
+            }
+            if (preAlarmCause != 0x00) {
+                lcdLine = 0x02;
+            }
+            if ((generalAlarmCause | peerAlarmCause) != 0x00) {
+                lcdLine = 0x03;
+            }
+            if (calibrationSweeps != 0x00) {
+                lcdLine = 0x04;
+            }
+            if (updatePending == 0x01) {
+                lcdLine = 0x05;
+            }
+
+            LCD_PUSH(0xFE);  //Send the command prefix to the status LCD
+            LCD_PUSH(0x80);  //Move the cursor to the start of the status line
+            for (lcdColumn = 0x00; lcdColumn < 0x0E; lcdColumn++) {
+                LCD_PUSH(lcdStatusText[lcdLine][lcdColumn]);  //Write the text of the condition to the status line
+            }
+            LCD_PUSH((ledControl & 0x08) == 0x08 ? 'S' : ' ');         //Show an S if the NAC's have been silenced
+            LCD_PUSH((currentConditions & 0x07) != 0x00 ? '*' : ' ');  //Show a * if there is an un-acknowledged condition
+        } else {
+            lcdDirty &= 0xFD;  //Clear the zone line dirty bit as it is being redrawn
+
+            LCD_PUSH(0xFE);  //Send the command prefix to the status LCD
+            LCD_PUSH(0xC0);  //Move the cursor to the start of the zone line
+
+            //Write a character for each SLC, A for a general alarm, P for a pre-alarm, T for a trouble, D if it's disabled, otherwise a .
+            for (lcdLine = 0x01; lcdLine != 0x00; lcdLine <<= 0x01) {
+                LCD_PUSH((generalAlarmCause & lcdLine) != 0x00 ? 'A' : (preAlarmCause & lcdLine) != 0x00 ? 'P' : (slcTroubleCause & lcdLine) != 0x00 ? 'T' : (PANEL_SLC_DISABLED & lcdLine) != 0x00 ? 'D' : '.');
+            }
+            LCD_PUSH(' ');
+
+            //Write a character for each NAC, T for a trouble, D if it's disabled, otherwise a .
+            for (lcdLine = 0x01; lcdLine != 0x10; lcdLine <<= 0x01) {
+                LCD_PUSH((nacTroubleCause & lcdLine) != 0x00 ? 'T' : (PANEL_NAC_DISABLED & lcdLine) != 0x00 ? 'D' : '.');
+            }
+            LCD_PUSH(' ');
+            LCD_PUSH(' ');
+            LCD_PUSH(' ');
+        }
+
+        PIE1 |= 0x10;  //Enable the EUSART transmit interrupt to start sending the line out to the status LCD
+
+        //Come straight back to redraw the other line if it has changed too
+        if (lcdDirty != 0x00) {
+            taskReady[TASK_LCD] = 0x01;
+        }
+    }
+
+#ifdef CYCLE_STATS
+    //Send the report of the next cycle counter once the lines are up to date, as min, max and last in hex after the tag of the counter
+    if (lcdDirty == 0x00 && cycleReport != 0x00 && ((lcdTail - lcdHead - 0x01) & LCD_BUFFER_MASK) >= CYCLE_REPORT_BYTES) {
+        //Find the next counter waiting to be reported
+        for (lcdLine = 0x00; (cycleReport & (0x01 << lcdLine)) == 0x00; lcdLine++) {
+        }
+        cycleReport &= (0x01 << lcdLine) ^ 0xFF;  //Clear the bit of the counter as it is being reported
+
+        //Take a copy of the counter with interrupts off, so the ISR can't change it half way through being read
+        INTCON &= 0x7F;                            //Disable global interrupts
+        cycleSnapshot[0x00] = cycleMin[lcdLine];   //Copy the shortest run of the counter
+        cycleSnapshot[0x01] = cycleMax[lcdLine];   //Copy the longest run of the counter
+        cycleSnapshot[0x02] = cycleLast[lcdLine];  //Copy the latest run of the counter
+        INTCON |= 0x80;                            //Enable global interrupts
+
+        LCD_PUSH(0xFE);                      //Send the command prefix to the status LCD
+        LCD_PUSH(0x90);                      //Move the cursor past the end of the status line into hidden display RAM
+        LCD_PUSH(cycleReportTag[lcdLine]);  //Send the tag of the counter
+        for (lcdColumn = 0x00; lcdColumn < 0x0C; lcdColumn++) {
+            LCD_PUSH(cycleHexDigits[(cycleSnapshot[lcdColumn >> 0x02] >> (0x0C - ((lcdColumn & 0x03) << 0x02))) & 0x0F]);  //Send the next hex digit of the counter, highest digit first
+        }
+
+        PIE1 |= 0x10;  //Enable the EUSART transmit interrupt to start sending the report
+
+        //Come straight back to report the next counter
+        if (cycleReport != 0x00) {
+            taskReady[TASK_LCD] = 0x01;
+        }
+    }
+#endif
+
+    //Send the telemetry once the lines are up to date, nothing else is sent once a firmware update is waiting to hand over
+    if (lcdDirty == 0x00 && updatePending == 0x00) {
+        sendTelemetry();
+    }
+}
+
+/***************
+ *  Scheduler  *
+ ***************/
+
+//Task Table, indexed by task in order of priority, the first task has the highest priority
+void (*const taskTable[TASK_COUNT])() = {
+    alarmTask,   //Processes the software interrupts
+    inputTask,   //Samples the buttons and general trouble inputs
+    outputTask,  //Updates the LED's, buzzer and NAC's
+    lcdTask      //Redraws the status LCD
+};
+
 /*********************
  *  Core Processing  *
  *********************/
 
 //Main Function, called upon reset of the MCU, or whenever the panel is hard reset
 void main() {
+    unsigned char task;        //Task picked to run next by the scheduler
+    unsigned char limit;       //Byte or index of the channel limits being set up
+    unsigned char slot;        //Slot of the channel a byte of the stored calibration belongs to
+    unsigned char calibrated;  //Set if a complete calibration is stored in the data EEPROM
+#ifdef CYCLE_STATS
+    unsigned short loopStart;  //Timer 1 value the pass of the scheduler loop started at
+    unsigned short taskStart;  //Timer 1 value the task started running at
+    unsigned short taskTime;   //Instruction cycles the task took to run
+#endif
+
     //Initialize the MCU by setting the appropriate registers with the appropriate values
 
     //Timing Related Registers
     OSCCON = 0x60;      //Set the internal RC-Oscillator to run at 8MHz
     OPTION_REG = 0xD7;  //Disable the internal pull-up resistors on PORTB and enable Timer 0 to run on the internal RC-Oscillator with a pre-scale of 256
     WDTCON = 0x00;      //Disable the watchdog timer and set the pre-scale value to 32
+    T1CON = 0x01;       //Turn on Timer 1 running freely off the instruction clock with no pre-scale, used to time the bus and, with CYCLE_STATS, how long each task takes to run
 
     //IO Related Registers
     TRISA = 0x0F;   //Set TRISA0 to TRISA3 to inputs and clear the rest as outputs
     TRISB = 0xBF;   //Set all of TRISB to inputs
-    TRISC = 0xFF;   //Set all of TRISC to inputs
+    TRISC = 0xC6;   //Set TRISC0 to an output for the driver enable of the network transceiver, TRISC3 to TRISC5 to outputs for the SLC control shift register and the rest to inputs
     TRISD = 0x0F;   //Set TRISD0 to TRISD3 to inputs and clear the rest as outputs
     TRISE = 0x0F;   //Set all of TRISE to inputs
-    ANSEL = 0x0F;   //Set ANSEL0 to ANSEL3 to allow the built-in ADC to read from PORTA0 to PORTA3
+    ANSEL = 0xEF;   //Set ANSEL0 to ANSEL3 and ANSEL5 to ANSEL7 to allow the built-in ADC to read from PORTA0 to PORTA3 and PORTE0 to PORTE2
     ANSELH = 0x3F;  //Set ANSEL8 to ANSEL13 to allow the built-in ADC to read from PORTB0 to PORTB6
     LATA = 0x00;    //Clear the fake LATA register
     LATB = 0x00;    //Clear the fake LATB register
@@ -436,50 +1733,110 @@ void main() {
 
     //Interrupt Related Registers
     INTCON = 0xE0;  //Enable global interrupts, peripheral interrupts and the Timer 0 overflow interrupt
-    PIE1 = 0x40;    //Enable the ADC read complete interrupt
+    PIE1 = 0x62;    //Enable the ADC read complete interrupt, the EUSART receive interrupt and the Timer 2 match interrupt used for the ADC acquisition delay
+
+    //EUSART Related Registers
+    SPBRG = 0x19;   //Set the baud rate generator to 25 to run the EUSART at 9600 baud for the status LCD
+    TXSTA = 0x24;   //Enable the transmitter in asynchronous mode using the high speed baud rate
+    RCSTA = 0x90;   //Enable the serial port, making PORTC6 the transmit pin used to drive the status LCD and the network, and the receiver on PORTC7 for the software update port and the network
+
+    //Pick the limits the ADC readings are put into bands with, holding the silence button while the panel powers up learns new ones
+    if ((PORTD & 0x04) == 0x00) {
+        //Start the lowest and highest readings of every channel from the opposite ends, so the first reading replaces them
+        for (limit = 0x00; limit < PANEL_SCANNED_CHANNELS << 0x01; limit += 0x02) {
+            channelLimits[limit] = 0xFF;         //Start the lowest reading at the top
+            channelLimits[limit + 0x01] = 0x00;  //Start the highest reading at the bottom
+        }
+
+        calibrationSweeps = CALIBRATION_SWEEPS;  //Start the calibration
+        buttonTracker = 0x04;                    //Take the silence button as already held, so holding it for the calibration doesn't count as a push
+    } else {
+        //Load the calibration stored last time if it is complete, otherwise the default limits
+        EECON1 = 0x00;                //Select the data EEPROM
+        EEADR = CALIBRATION_ADDRESS;  //Select the marker of the calibration
+        EECON1 |= 0x01;               //Set the RD bit to read the byte, the byte is available right away
+        calibrated = EEDAT == CALIBRATION_MARKER;
+        for (limit = 0x00; limit < 0x1C; limit++) {
+            EEADR = CALIBRATION_ADDRESS + 0x01 + limit;  //Select the byte of the limits
+            EECON1 |= 0x01;                              //Set the RD bit to read the byte
+            slot = channelLimitSlot[limit >> 0x01];      //Find the slot of the channel the byte belongs to, a channel that is never read has nowhere to put it
+            if (slot != 0xFF) {
+                channelLimits[(slot << 0x01) | (limit & 0x01)] = calibrated == 0x01 ? EEDAT : channelDefaultLimits[limit];
+            }
+        }
+    }
 
     //ADC Related Registers
-    ADCON1 = 0x80;  //Set the output format to be the lowest 8 bits of the 10 bit result to be shifted into the lower end of the 16 bit register
-    ADCON0 = 0x41;  //Enable the internal ADC to run using the internal RC-Oscillator frequency divided by 8
+    ADCON1 = 0x00;  //Set the output format to be left justified, so ADRESH holds the top 8 bits of the 10 bit result
+    activeADChannel = adcScanSchedule[0x00] & 0x0F;  //Start the scan from the first channel in the scan schedule
+    ADCON0 = 0x41 | (activeADChannel << 0x02);       //Enable the internal ADC to run using the internal RC-Oscillator frequency divided by 8 on the first channel
+    PR2 = 0x13;     //Set the Timer 2 period to 20 instruction cycles, used as the acquisition delay after changing ADC channels
+    TMR2 = 0x00;    //Clear Timer 2 to start the acquisition delay for the first channel from the beginning
+    T2CON = 0x04;   //Turn on Timer 2 with no pre-scale or post-scale to start the first sweep of the ADC channels
+
+    //Find where the event log left off, the newest record is the last one in a row with the same lap bit as the first record
+    EECON1 = 0x00;                         //Select the data EEPROM
+    EEADR = EVENT_RECORD_SIZE - 0x01;      //Select the type of the first record
+    EECON1 |= 0x01;                        //Set the RD bit to read the byte, the byte is available right away
+    eventLogLap = EEDAT & 0x80;            //Take the lap bit of the first record
+    for (eventLogHead = EVENT_RECORD_SIZE; eventLogHead != EVENT_LOG_SIZE; eventLogHead += EVENT_RECORD_SIZE) {
+        EEADR = eventLogHead + EVENT_RECORD_SIZE - 0x01;  //Select the type of the record
+        EECON1 |= 0x01;                                   //Set the RD bit to read the byte
+
+        //The first record from the last lap, or a blank one, is where the next record gets written
+        if ((EEDAT & 0x80) != eventLogLap) {
+            break;
+        }
+    }
+
+    //If every record is from the same lap, the ring is full and the next lap starts at the beginning
+    if (eventLogHead == EVENT_LOG_SIZE) {
+        eventLogHead = 0x00;  //Start the next lap at the beginning
+        eventLogLap ^= 0x80;  //Flip the lap bit for the next lap
+    }
+
+    eventLogAddress = eventLogHead;  //Start writing the event queue where the event log left off
+    logEvent(EVENT_POWER_UP, 0x00);  //Log the panel powering up
 
     generalTroubleCause = 0x00;
 
-    //Run in a continuous loop till the end of time
+    //Run the scheduler in a continuous loop till the end of time
     while (0x01) {
-        //Update the interrupt trackers used for detecting interrupts from the user interface buttons
-        buttonTracker = (buttonTracker & 0x0F) << 0x04;                                          //Shift the button states from the new section to the old section
-        buttonTracker |= PORTD & 0x0F ^ 0x0F;                                                    //Read the first 4 bits from PORTD to the first 4 bits of buttonTracker
-        buttonInterrupt |= ((buttonTracker & 0x01 ^ 0x01) & ((buttonTracker & 0x10) >> 0x04)) |  //Update the interrupt tracker and set bits if a button has been pressed
-                           ((buttonTracker & 0x02 ^ 0x02) & ((buttonTracker & 0x20) >> 0x04)) |
-                           ((buttonTracker & 0x04 ^ 0x04) & ((buttonTracker & 0x40) >> 0x04)) |
-                           ((buttonTracker & 0x08 ^ 0x08) & ((buttonTracker & 0x80) >> 0x04));
-
-        //Update the interrupt trackers used for detecting general trouble conditions on the panel
-        generalTroubleTracker = (generalTroubleTracker & 0x0F) << 0x04;                                                  //Shift the general trouble states from the new section to the old section
-        generalTroubleTracker |= ((PORTB & 0x80 ^ 0x80) >> 0x07);                                                        //Set the appropriate bits if a trouble condition is present
-        generalTroubleInterrupt |= ((generalTroubleTracker & 0x01 ^ 0x01) & ((generalTroubleTracker & 0x10) >> 0x04));   //Update the interrupt tracker and set bits if a general trouble interrupt has occurred
-
-        softwareISR();  //Process all software based interrupts
-
-        //Update the LED's on the user interface
-        LATD &= 0x0F;                                                                                           //Clear the last 4 bits of LATD
-        LATD |= (generalTroubleCause & 0x01 ^ 0x01) << 0x04;                                                    //Write the output state of the Power LED to LATD
-        LATD |= ((ledControl & 0x80) >> 0x02) & ((ledControl & 0x02) << 0x04) | ((ledControl & 0x10) << 0x01);  //Write the output state of the Alarm LED to LATD
-        LATD |= ((ledControl & 0x80) >> 0x01) & ((ledControl & 0x04) << 0x04) | ((ledControl & 0x20) << 0x01);  //Write the output state of the Trouble LED to LATD
-        LATD |= (ledControl & 0x08) << 0x04;                                                                    //Write the output state of the Silence LED to LATD
-        PORTD = LATD;                                                                                           //Write the value of LATD to PORTD
-
-        //Update the state of the buzzer on the user interface
-        LATB &= 0xBF;                                                 //Clear the last 2 bits of LATB
-        LATB |= ((ledControl & 0x01) << 0x06) & (ledControl & 0x40);  //Write the output state of the buzzer to LATB
-        PORTB = LATB;                                                 //Write the value of LATB to PORTB
-
-        //Update the output state of the NAC's
-        LATA &= 0x0F;                                                                                                                                          //Clear the last 4 bits of LATA
-        LATA |= ((((coderCounter & (0x01 << (coderControl & 0x03))) >> (coderControl & 0x03)) & (nacControl & 0x01)) << 0x04) |                                //Write the output state of the NAC's to LATA
-                ((((coderCounter & (0x01 << ((coderControl & 0x0C) >> 0x02))) >> ((coderControl & 0x0C) >> 0x02)) & ((nacControl & 0x02) >> 0x01)) << 0x05) |
-                ((((coderCounter & (0x01 << ((coderControl & 0x30) >> 0x04))) >> ((coderControl & 0x30) >> 0x04)) & ((nacControl & 0x04) >> 0x02)) << 0x06) |
-                ((((coderCounter & (0x01 << ((coderControl & 0xC0) >> 0x06))) >> ((coderControl & 0xC0) >> 0x06)) & ((nacControl & 0x08) >> 0x03)) << 0x07);
-        PORTA = LATA;  //Write the value of LATA to PORTA
-    }
-}
\ No newline at end of file
+#ifdef CYCLE_STATS
+        loopStart = readTimer1();  //Take the time the pass started at, only passes that run a task are recorded
+#endif
+
+        //Find the highest priority task that is ready to run, starting from the top every time so an alarm is never stuck behind the user interface
+        for (task = 0x00; task < TASK_COUNT; task++) {
+            if (taskReady[task] != 0x00) {
+                break;
+            }
+        }
+
+        //Idle till an interrupt makes a task ready, SLEEP is only used in standby as it stops Timer 0 and Timer 2 along with the instruction clock
+        if (task == TASK_COUNT) {
+            if (standbyMode == 0x01) {
+                standbySleep();
+            } else {
+                __nop();
+            }
+            continue;
+        }
+
+        taskReady[task] = 0x00;  //Clear the ready flag before running the task, so an interrupt that makes it ready again while it runs isn't lost
+
+#ifdef CYCLE_STATS
+        //Run the task and keep track of the longest it has ever taken, the time includes any hardware interrupts that came in while it ran
+        taskStart = readTimer1();
+        taskTable[task]();
+        taskTime = readTimer1() - taskStart;
+        if (taskTime > taskWorstCase[task]) {
+            taskWorstCase[task] = taskTime;
+        }
+
+        recordCycles(CYCLE_MAIN_LOOP, loopStart);  //Record how long the pass of the scheduler loop took
+#else
+        taskTable[task]();
+#endif
+    }
+}
@@ -0,0 +1,47 @@
+/************************************************************************
+ *  Fire Alarm Panel - Panel Configuration                              *
+ *  Generated from panel.cfg by panelgen.awk, edit panel.cfg instead    *
+ ************************************************************************/
+
+#ifndef PANEL_CONFIG_H
+#define PANEL_CONFIG_H
+
+//Pre-Alarm
+#define PANEL_PRE_ALARM 0x00  //Set if the first alarm condition puts the panel into pre-alarm, otherwise it goes straight to a general alarm
+
+//Panel Network
+#define PANEL_NETWORK 0x00  //Set if the panel shares its alarms with other panels on an RS-485 bus, a panel on the network never sleeps in battery standby
+
+//SLC's, first bit is SLC1
+#define PANEL_SLC_ENABLED 0xFF   //SLC's that are in use
+#define PANEL_SLC_DISABLED 0x00  //SLC's that are disabled, they are left out of the ADC scan
+
+//NAC's, first bit is NAC1
+#define PANEL_NAC_ENABLED 0x03      //NAC's that are in use
+#define PANEL_NAC_DISABLED 0x0C     //NAC's that are disabled, they are left out of the ADC scan and never activate
+#define PANEL_NAC_SILENCEABLE 0x03  //Enabled NAC's that turn off when the silence button is pushed
+#define PANEL_NAC_PRESIGNAL 0x00    //Enabled NAC's that activate during a pre-alarm condition
+
+//NAC Coder, the pattern each NAC follows, 0 steady, 1 march120, 2 march60, 3 temporal and 4 california
+#define PANEL_NAC1_PATTERN 0x03
+#define PANEL_NAC2_PATTERN 0x00
+#define PANEL_NAC3_PATTERN 0x00
+#define PANEL_NAC4_PATTERN 0x00
+#define PANEL_CODER_PHASES 0x10  //Phases before the patterns of every enabled NAC repeat
+
+//NAC Coder Table, the NAC's that are on at each phase of the coder, first bit is NAC1, a disabled NAC is never on
+#define PANEL_CODER_TABLE \
+    0x03, 0x03, 0x02, 0x02, 0x03, 0x03, 0x02, 0x02, 0x03, 0x03, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02
+
+//ADC Scan Schedule, each enabled NAC supervision channel and the battery monitor take turns, each followed by every enabled SLC
+#define PANEL_ADC_SCAN_SCHEDULE \
+    0x00, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x8D, \
+    0x01, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x8D, \
+    0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x8D
+
+//Channel Limit Slots, the slot of each ADC channel in the channel limits, 0xFF for a channel that is never read
+#define PANEL_SCANNED_CHANNELS 0x0B  //ADC channels in the scan schedule, each has a slot
+#define PANEL_LIMIT_SLOTS \
+    0x00, 0x01, 0xFF, 0xFF, 0xFF, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A
+
+#endif
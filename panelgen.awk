@@ -0,0 +1,304 @@
+#
+#  Fire Alarm Panel - Panel Configuration Generator
+#
+#  Turns the site configuration in panel.cfg into PanelConfig.h, the
+#  constants and precomputed masks Main.c is compiled against.
+#
+#     awk -f panelgen.awk panel.cfg > PanelConfig.h
+#
+#  Only plain POSIX awk is used, so there are no bitwise operators, every
+#  mask is built up by adding the value of each bit once.
+#
+
+#Report a mistake in the configuration and stop without producing a header
+function fail(message) {
+    printf("%s:%d: %s\n", FILENAME, FNR, message) > "/dev/stderr"
+    failed = 1
+    exit 1
+}
+
+#Format a byte the way Main.c writes its constants
+function hex(value) {
+    return sprintf("0x%02X", value)
+}
+
+#Greatest common divisor, used to find the length of the coder table
+function gcd(a, b,    t) {
+    while (b != 0) {
+        t = b
+        b = a % b
+        a = t
+    }
+    return a
+}
+
+#Non-zero if the pattern is on at the given phase of the coder, a pattern is a list of on and off runs in phases that repeats
+function patternOn(pattern, phase,    runs, count, i, on) {
+    count = split(patternRuns[pattern], runs, " ")
+    phase %= patternLength[pattern]
+    on = 1
+    for (i = 1; i <= count; i++) {
+        if (phase < runs[i]) {
+            return on
+        }
+        phase -= runs[i]
+        on = !on
+    }
+    return 0
+}
+
+BEGIN {
+    #On and off runs of each pattern in coder phases of about a quarter second, along with the number written to PanelConfig.h for it
+    patternRuns["steady"] = "1"
+    patternRuns["march120"] = "1 1"
+    patternRuns["march60"] = "2 2"
+    patternRuns["temporal"] = "2 2 2 2 2 6"
+    patternRuns["california"] = "40 20"
+    patternNumber["steady"] = 0
+    patternNumber["march120"] = 1
+    patternNumber["march60"] = 2
+    patternNumber["temporal"] = 3
+    patternNumber["california"] = 4
+    for (pattern in patternRuns) {
+        count = split(patternRuns[pattern], runs, " ")
+        patternLength[pattern] = 0
+        for (i = 1; i <= count; i++) {
+            patternLength[pattern] += runs[i]
+        }
+    }
+
+    preAlarm = -1
+    network = -1
+}
+
+#Strip comments and skip blank lines
+{
+    sub(/#.*/, "")
+}
+NF == 0 {
+    next
+}
+
+$1 == "pre-alarm" {
+    if (NF != 2 || ($2 != "on" && $2 != "off")) {
+        fail("pre-alarm must be on or off")
+    }
+    if (preAlarm != -1) {
+        fail("pre-alarm is set more than once")
+    }
+    preAlarm = $2 == "on"
+    next
+}
+
+$1 == "network" {
+    if (NF != 2 || ($2 != "on" && $2 != "off")) {
+        fail("network must be on or off")
+    }
+    if (network != -1) {
+        fail("network is set more than once")
+    }
+    network = $2 == "on"
+    next
+}
+
+$1 ~ /^slc[1-8]$/ {
+    slc = substr($1, 4) + 0
+    if (NF != 2 || ($2 != "enabled" && $2 != "disabled")) {
+        fail($1 " must be enabled or disabled")
+    }
+    if (slc in slcEnabled) {
+        fail($1 " is set more than once")
+    }
+    slcEnabled[slc] = $2 == "enabled"
+    next
+}
+
+$1 ~ /^nac[1-4]$/ {
+    nac = substr($1, 4) + 0
+    if ($2 != "enabled" && $2 != "disabled") {
+        fail($1 " must be enabled or disabled")
+    }
+    if (nac in nacEnabled) {
+        fail($1 " is set more than once")
+    }
+    nacEnabled[nac] = $2 == "enabled"
+    nacSilenceable[nac] = 0
+    nacPresignal[nac] = 0
+    nacPattern[nac] = ""
+
+    for (i = 3; i <= NF; i++) {
+        if ($i == "silenceable") {
+            nacSilenceable[nac] = 1
+        } else if ($i == "presignal") {
+            nacPresignal[nac] = 1
+        } else if ($i in patternRuns) {
+            if (nacPattern[nac] != "") {
+                fail($1 " has more than one pattern")
+            }
+            nacPattern[nac] = $i
+        } else {
+            fail($1 " has an unknown option " $i)
+        }
+    }
+
+    if (nacPattern[nac] == "") {
+        fail($1 " needs a pattern, one of steady, march120, march60, temporal or california")
+    }
+    next
+}
+
+{
+    fail("unknown setting " $1)
+}
+
+END {
+    if (failed) {
+        exit 1
+    }
+
+    #Every setting has to be given, so a typo can't silently leave a zone out
+    if (preAlarm == -1) {
+        fail("pre-alarm is not set")
+    }
+    if (network == -1) {
+        fail("network is not set")
+    }
+    for (slc = 1; slc <= 8; slc++) {
+        if (!(slc in slcEnabled)) {
+            fail("slc" slc " is not set")
+        }
+        if (slcEnabled[slc]) {
+            slcMask += 2 ^ (slc - 1)
+        }
+    }
+    if (slcMask == 0) {
+        fail("at least one SLC has to be enabled")
+    }
+
+    phases = 1
+    for (nac = 1; nac <= 4; nac++) {
+        if (!(nac in nacEnabled)) {
+            fail("nac" nac " is not set")
+        }
+        if (nacEnabled[nac]) {
+            bit = 2 ^ (nac - 1)
+            nacMask += bit
+            silenceMask += nacSilenceable[nac] ? bit : 0
+            presignalMask += nacPresignal[nac] ? bit : 0
+
+            #Only the patterns of enabled NAC's set the length of the coder table, it repeats once all of them have
+            cycle = patternLength[nacPattern[nac]]
+            phases = phases * cycle / gcd(phases, cycle)
+        }
+    }
+
+    #A pre-alarm with no NAC's to signal it is almost certainly a mistake
+    if (preAlarm && presignalMask == 0) {
+        fail("pre-alarm is on but no enabled NAC is set to presignal")
+    }
+
+    print "/************************************************************************"
+    print " *  Fire Alarm Panel - Panel Configuration                              *"
+    print " *  Generated from panel.cfg by panelgen.awk, edit panel.cfg instead    *"
+    print " ************************************************************************/"
+    print ""
+    print "#ifndef PANEL_CONFIG_H"
+    print "#define PANEL_CONFIG_H"
+    print ""
+    print "//Pre-Alarm"
+    printf("#define PANEL_PRE_ALARM %s  //Set if the first alarm condition puts the panel into pre-alarm, otherwise it goes straight to a general alarm\n", hex(preAlarm))
+    print ""
+    print "//Panel Network"
+    printf("#define PANEL_NETWORK %s  //Set if the panel shares its alarms with other panels on an RS-485 bus, a panel on the network never sleeps in battery standby\n", hex(network))
+    print ""
+    print "//SLC's, first bit is SLC1"
+    printf("#define PANEL_SLC_ENABLED %s   //SLC's that are in use\n", hex(slcMask))
+    printf("#define PANEL_SLC_DISABLED %s  //SLC's that are disabled, they are left out of the ADC scan\n", hex(255 - slcMask))
+    print ""
+    print "//NAC's, first bit is NAC1"
+    printf("#define PANEL_NAC_ENABLED %s      //NAC's that are in use\n", hex(nacMask))
+    printf("#define PANEL_NAC_DISABLED %s     //NAC's that are disabled, they are left out of the ADC scan and never activate\n", hex(15 - nacMask))
+    printf("#define PANEL_NAC_SILENCEABLE %s  //Enabled NAC's that turn off when the silence button is pushed\n", hex(silenceMask))
+    printf("#define PANEL_NAC_PRESIGNAL %s    //Enabled NAC's that activate during a pre-alarm condition\n", hex(presignalMask))
+    print ""
+    print "//NAC Coder, the pattern each NAC follows, 0 steady, 1 march120, 2 march60, 3 temporal and 4 california"
+    for (nac = 1; nac <= 4; nac++) {
+        printf("#define PANEL_NAC%d_PATTERN %s\n", nac, hex(patternNumber[nacPattern[nac]]))
+    }
+    printf("#define PANEL_CODER_PHASES %s  //Phases before the patterns of every enabled NAC repeat\n", hex(phases))
+    print ""
+    print "//NAC Coder Table, the NAC's that are on at each phase of the coder, first bit is NAC1, a disabled NAC is never on"
+    print "#define PANEL_CODER_TABLE \\"
+    for (phase = 0; phase < phases; phase += 16) {
+        line = "   "
+        for (i = phase; i < phase + 16 && i < phases; i++) {
+            bits = 0
+            for (nac = 1; nac <= 4; nac++) {
+                if (nacEnabled[nac] && patternOn(nacPattern[nac], i)) {
+                    bits += 2 ^ (nac - 1)
+                }
+            }
+            line = line " " hex(bits) (i < phases - 1 ? "," : "")
+        }
+        print line (phase + 16 < phases ? " \\" : "")
+    }
+    print ""
+    print "//ADC Scan Schedule, each enabled NAC supervision channel and the battery monitor take turns, each followed by every enabled SLC"
+    print "#define PANEL_ADC_SCAN_SCHEDULE \\"
+
+    #Build the list of supervision channels that take turns at the start of each sweep
+    count = 0
+    for (nac = 1; nac <= 4; nac++) {
+        if (nacEnabled[nac]) {
+            supervision[count++] = nac - 1
+        }
+    }
+    supervision[count++] = 5
+
+    for (group = 0; group < count; group++) {
+        line = "    " hex(supervision[group])
+        last = 0
+        for (slc = 8; slc >= 1; slc--) {
+            if (slcEnabled[slc]) {
+                last = slc
+                break
+            }
+        }
+        for (slc = 1; slc <= 8; slc++) {
+            if (slcEnabled[slc]) {
+                line = line ", " hex(slc + 5 + (slc == last ? 128 : 0))
+            }
+        }
+        print line (group < count - 1 ? ", \\" : "")
+    }
+
+    #Give every channel in the scan a slot in the channel limits, in order of ADC channel, channels that are never read get none
+    slots = 0
+    for (channel = 0; channel < 14; channel++) {
+        slot[channel] = 255
+    }
+    for (group = 0; group < count; group++) {
+        slot[supervision[group]] = 0
+    }
+    for (slc = 1; slc <= 8; slc++) {
+        if (slcEnabled[slc]) {
+            slot[slc + 5] = 0
+        }
+    }
+    line = "   "
+    for (channel = 0; channel < 14; channel++) {
+        if (slot[channel] == 0) {
+            slot[channel] = slots++
+        }
+        line = line " " hex(slot[channel]) (channel < 13 ? "," : "")
+    }
+
+    print ""
+    print "//Channel Limit Slots, the slot of each ADC channel in the channel limits, 0xFF for a channel that is never read"
+    printf("#define PANEL_SCANNED_CHANNELS %s  //ADC channels in the scan schedule, each has a slot\n", hex(slots))
+    print "#define PANEL_LIMIT_SLOTS \\"
+    print line
+
+    print ""
+    print "#endif"
+}
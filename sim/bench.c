@@ -0,0 +1,244 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Alarm latency benchmark, injects an alarm reading on every SLC and  *
+ *  measures the time until the NAC outputs show up on LATA and until   *
+ *  the SLC shows up in alarm on the status LCD                         *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+
+/***************
+ *  Variables  *
+ ***************/
+
+static unsigned char slcChannel = 0x00;             //ADC channel of the SLC the alarm is injected on
+static unsigned long long injectAt = 0x00;          //Simulated cycle the alarm is injected at
+static unsigned long long injectedCycles = 0x00;    //Simulated cycle the alarm was actually applied at
+static unsigned long long injectedNanoseconds = 0x00;  //Simulated time the alarm was actually applied at
+static unsigned char injected = 0x00;               //Set once the alarm reading has been applied
+static unsigned char refreshLcd = 0x00;             //Set to force a full-screen refresh of the status LCD at the moment the alarm is applied
+static unsigned long long nacCycles = 0x00;         //Cycles from the alarm to the NACs activating, 0 until they have
+static unsigned long long nacNanoseconds = 0x00;    //Time from the alarm to the NACs activating
+
+//Names of the tasks in the scheduler task table, indexed by task
+static const char *taskNames[HARNESS_TASK_COUNT] = {"alarm", "input", "output", "lcd"};
+static unsigned long startConversions = 0x00;       //ADC conversions completed when the scan rate window started
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Observer for a trial, injects the alarm once warmed up and waits for the NACs to activate and the SLC to show up on the status LCD
+static void latencyObserver(void) {
+    if (injected == 0x00) {
+        if (simCycles() >= injectAt) {
+            simSetAnalogInput(slcChannel, HARNESS_SLC_ALARM);
+            injectedCycles = simCycles();
+            injectedNanoseconds = simNanoseconds();
+            injected = 0x01;
+
+            //Queue up both lines of the status LCD so the EUSART is busy for the whole time the alarm is being processed
+            if (refreshLcd == 0x01) {
+                lcdDirty |= 0x03;
+            }
+        }
+        return;
+    }
+
+    if (nacCycles == 0x00 && (LATA & 0xF0) != 0x00) {
+        nacCycles = simCycles() - injectedCycles;
+        nacNanoseconds = simNanoseconds() - injectedNanoseconds;
+    }
+
+    //The zone line shows an A for each SLC in general alarm
+    if (nacCycles != 0x00 && harnessLcdLine(0x01)[slcChannel - HARNESS_SLC_CHANNEL(0x00)] == 'A') {
+        harnessFinish(nacCycles, nacNanoseconds, simCycles() - injectedCycles, simNanoseconds() - injectedNanoseconds);
+    }
+    if (simCycles() - injectedCycles > HARNESS_TIMEOUT_CYCLES) {
+        harnessFinish(nacCycles != 0x00 ? nacCycles : ~0ULL, nacCycles != 0x00 ? nacNanoseconds : ~0ULL, ~0ULL, ~0ULL);
+    }
+}
+
+//Observer for the scan rate measurement, counts the conversions completed on one channel over a fixed window once warmed up
+static void scanObserver(void) {
+    if (injected == 0x00) {
+        if (simCycles() >= injectAt) {
+            injectedCycles = simCycles();
+            injectedNanoseconds = simNanoseconds();
+            startConversions = simAdcConversions(slcChannel);
+            injected = 0x01;
+        }
+    } else if (simCycles() - injectedCycles >= HARNESS_SCAN_WINDOW_CYCLES) {
+        unsigned long conversions = simAdcConversions(slcChannel) - startConversions;
+
+        //Report the average time between two readings of the channel
+        if (conversions == 0x00) {
+            harnessFinish(~0ULL, ~0ULL, 0x00, 0x00);
+        }
+        harnessFinish((simCycles() - injectedCycles) / conversions, (simNanoseconds() - injectedNanoseconds) / conversions, 0x00, 0x00);
+    }
+}
+
+//Observer for the task timing measurement, injects an alarm once warmed up and reports the worst case execution time of every task after the alarm has been handled
+static void taskObserver(void) {
+    unsigned char task;
+
+    if (injected == 0x00) {
+        if (simCycles() >= injectAt) {
+            simSetAnalogInput(slcChannel, HARNESS_SLC_ALARM);
+            injectedCycles = simCycles();
+            injected = 0x01;
+        }
+    } else if (simCycles() - injectedCycles >= HARNESS_SCAN_WINDOW_CYCLES) {
+        unsigned long long result[HARNESS_RESULT_COUNT];
+
+        for (task = 0x00; task < HARNESS_RESULT_COUNT; task++) {
+            result[task] = task < HARNESS_TASK_COUNT ? taskWorstCase[task] : 0x00;
+        }
+        harnessFinish(result[0x00], result[0x01], result[0x02], result[0x03]);
+    }
+}
+
+//Run a single trial, injecting on the given channel after the given number of warm up cycles
+static int runTrial(simObserver observer, unsigned char channel, unsigned long long warmup, unsigned long long result[HARNESS_RESULT_COUNT]) {
+
+    slcChannel = channel;
+    injectAt = warmup;
+
+    return harnessRun(observer, result);
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, runs the benchmark for every SLC and prints the results
+int main(int argc, char **argv) {
+    unsigned long trials = 0x10;           //Number of trials per SLC, each one injecting the alarm at a different point in the scan
+    unsigned long long budget = 0x00;      //Worst case latency in cycles that is considered a regression, 0 to disable the check
+    unsigned long long worstOverall = 0x00;
+    unsigned long long *samples[HARNESS_RESULT_COUNT];  //Results of every trial on an SLC, one array for each value reported by the observer
+    unsigned long long result[HARNESS_RESULT_COUNT];
+    unsigned char channel;
+    unsigned char slc;
+    unsigned char i;
+    int option;
+
+    while ((option = getopt(argc, argv, "t:b:")) != -1) {
+        switch (option) {
+            case 't':
+                trials = strtoul(optarg, 0, 0);
+                break;
+            case 'b':
+                budget = strtoull(optarg, 0, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-t trials] [-b worst case cycle budget]\n", argv[0x00]);
+                return 0x02;
+        }
+    }
+
+    if (trials == 0x00) {
+        trials = 0x01;
+    }
+
+    for (i = 0x00; i < HARNESS_RESULT_COUNT; i++) {
+        samples[i] = malloc(trials * sizeof(*samples[i]));
+        if (samples[i] == 0) {
+            return 0x02;
+        }
+    }
+
+    //Measure how often each ADC channel gets read while the panel is idle
+    printf("ADC sample interval while idle\n");
+    printf(" AN  cycles     ms\n");
+    for (channel = 0x00; channel < SIM_ADC_CHANNEL_COUNT; channel++) {
+        if (runTrial(scanObserver, channel, HARNESS_WARMUP_CYCLES, result) != 0x00) {
+            fprintf(stderr, "Scan rate measurement failed to run\n");
+            return 0x02;
+        }
+
+        if (result[0x00] == ~0ULL) {
+            printf(" %2u  not scanned\n", channel);
+        } else {
+            printf(" %2u  %6llu  %6.3f\n", channel, result[0x00], result[0x01] / 1000000.0);
+        }
+    }
+
+    //Measure the longest each task of the scheduler takes to run while an alarm comes in and gets shown
+    if (runTrial(taskObserver, HARNESS_SLC_CHANNEL(0x00), HARNESS_WARMUP_CYCLES, result) != 0x00) {
+        fprintf(stderr, "Task timing measurement failed to run\n");
+        return 0x02;
+    }
+
+    printf("\nTask worst case execution time with an alarm on SLC1, including interrupts\n");
+    printf("task    cycles  ms at 4MHz\n");
+    for (i = 0x00; i < HARNESS_TASK_COUNT; i++) {
+        printf("%-6s  %6llu  %10.3f\n", taskNames[i], result[i], result[i] / 1000.0);
+    }
+
+    //Measure the alarm latency with the status LCD idle, then again with a full-screen refresh being sent out while the alarm is processed
+    for (refreshLcd = 0x00; refreshLcd <= 0x01; refreshLcd++) {
+        printf("\nAlarm to NAC latency, %lu trials per SLC, %s\n", trials, refreshLcd == 0x00 ? "status LCD idle" : "full-screen LCD refresh in flight");
+        printf("SLC  AN  median cycles  worst cycles  median ms  worst ms  LCD median ms  LCD worst ms\n");
+
+        for (slc = 0x00; slc < HARNESS_SLC_COUNT; slc++) {
+            unsigned long trial;
+
+            for (trial = 0x00; trial < trials; trial++) {
+                //Spread the injection point over several Timer 0 periods so every phase of the scan gets hit
+                unsigned long long warmup = HARNESS_WARMUP_CYCLES + (trial * 0x9E37ULL + slc * 0x1F3ULL) % 0x40000ULL;
+
+                if (runTrial(latencyObserver, HARNESS_SLC_CHANNEL(slc), warmup, result) != 0x00) {
+                    fprintf(stderr, "Trial %lu on SLC%u failed to run\n", trial, slc + 0x01);
+                    return 0x02;
+                }
+
+                for (i = 0x00; i < HARNESS_RESULT_COUNT; i++) {
+                    samples[i][trial] = result[i];
+                }
+            }
+
+            for (i = 0x00; i < HARNESS_RESULT_COUNT; i++) {
+                qsort(samples[i], trials, sizeof(*samples[i]), harnessCompareSamples);
+            }
+
+            if (samples[0x00][trials - 0x01] == ~0ULL) {
+                printf("%3u  %2u  timed out after %llu cycles\n", slc + 0x01, HARNESS_SLC_CHANNEL(slc), (unsigned long long) HARNESS_TIMEOUT_CYCLES);
+                worstOverall = ~0ULL;
+                continue;
+            }
+
+            printf("%3u  %2u  %13llu  %12llu  %9.3f  %8.3f", slc + 0x01, HARNESS_SLC_CHANNEL(slc),
+                   samples[0x00][trials / 0x02], samples[0x00][trials - 0x01],
+                   samples[0x01][trials / 0x02] / 1000000.0, samples[0x01][trials - 0x01] / 1000000.0);
+
+            if (samples[0x03][trials - 0x01] == ~0ULL) {
+                printf("  LCD never showed the alarm\n");
+            } else {
+                printf("  %13.3f  %12.3f\n", samples[0x03][trials / 0x02] / 1000000.0, samples[0x03][trials - 0x01] / 1000000.0);
+            }
+
+            if (samples[0x00][trials - 0x01] > worstOverall) {
+                worstOverall = samples[0x00][trials - 0x01];
+            }
+        }
+    }
+
+    for (i = 0x00; i < HARNESS_RESULT_COUNT; i++) {
+        free(samples[i]);
+    }
+
+    //Fail the run if the worst case latency has regressed past the budget
+    if (budget != 0x00 && worstOverall > budget) {
+        printf("Worst case latency of %llu cycles exceeds the budget of %llu cycles\n", worstOverall, budget);
+        return 0x01;
+    }
+
+    return 0x00;
+}
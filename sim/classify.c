@@ -0,0 +1,189 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  ADC classifier test, drives an SLC and a NAC into every band to     *
+ *  check the condition each band produces, then learns a calibration   *
+ *  and checks that it is stored and used                               *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+#define CLASSIFY_WINDOW_CYCLES 0x100000ULL  //Cycles each band is held for, long enough for a trouble to be verified
+
+//Conditions the panel can report for a band
+#define CLASSIFY_NONE 0x00         //No condition
+#define CLASSIFY_ALARM 0x01        //General alarm
+#define CLASSIFY_SLC_TROUBLE 0x02  //SLC trouble
+#define CLASSIFY_NAC_TROUBLE 0x04  //NAC trouble
+
+//Calibration Layout, must match the calibration in Main.c
+#define CLASSIFY_CALIBRATION_ADDRESS 0xC0  //Data EEPROM address of the marker byte, followed by the limits
+#define CLASSIFY_CALIBRATION_MARKER 0x5A   //Value of the marker byte once a complete calibration has been stored
+#define CLASSIFY_CALIBRATION_MARGIN 0x18   //Distance kept between the learnt normal band and the open and alarm limits, in the top 8 bits of a reading
+#define CLASSIFY_CALIBRATED_READING 0x0280 //Normal reading of the SLC during the calibration, higher than the harness normal reading
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Band readings fed into each channel and the condition each must produce
+struct band {
+    const char *name;
+    unsigned char channel;
+    unsigned short reading;
+    unsigned char expected;
+};
+
+static const struct band bands[] = {
+    {"NAC1 open",   0x00, 0x0008, CLASSIFY_NAC_TROUBLE},
+    {"NAC1 normal", 0x00, HARNESS_NAC_NORMAL, CLASSIFY_NONE},
+    {"NAC1 short",  0x00, 0x03F0, CLASSIFY_NAC_TROUBLE},
+    {"SLC1 open",   HARNESS_SLC_CHANNEL(0x00), 0x0040, CLASSIFY_SLC_TROUBLE},
+    {"SLC1 normal", HARNESS_SLC_CHANNEL(0x00), HARNESS_SLC_NORMAL, CLASSIFY_NONE},
+    {"SLC1 alarm",  HARNESS_SLC_CHANNEL(0x00), 0x0360, CLASSIFY_ALARM},
+    {"SLC1 short",  HARNESS_SLC_CHANNEL(0x00), 0x03F0, CLASSIFY_ALARM}
+};
+
+//Defined in Main.c
+extern unsigned char slcTroubleCause;
+extern unsigned char nacTroubleCause;
+extern unsigned char channelLimits[];
+extern const unsigned char channelLimitSlot[];
+
+static const struct band *band = 0;                 //Band being fed in
+static unsigned long startConversions = 0x00;       //ADC conversions completed on the channel when the band was first fed in
+static unsigned char calibrationStep = 0x00;        //Step of the calibration scenario
+static unsigned long long stepAt = 0x00;            //Cycle the current step of the calibration scenario started at
+static unsigned long long storedAt = 0x00;          //Simulated time the calibration finished being stored
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Conditions the panel is reporting
+static unsigned char conditions(void) {
+    return (generalAlarmCause != 0x00 ? CLASSIFY_ALARM : 0x00) | (slcTroubleCause != 0x00 ? CLASSIFY_SLC_TROUBLE : 0x00) | (nacTroubleCause != 0x00 ? CLASSIFY_NAC_TROUBLE : 0x00);
+}
+
+//Observer feeding a band into a channel, reports the conditions the panel came up with and the readings taken of the channel
+static void bandObserver(void) {
+    if (simCycles() < HARNESS_WARMUP_CYCLES) {
+        startConversions = simAdcConversions(band->channel);
+        return;
+    }
+
+    simSetAnalogInput(band->channel, band->reading);
+
+    if (simCycles() >= HARNESS_WARMUP_CYCLES + CLASSIFY_WINDOW_CYCLES) {
+        harnessFinish(conditions(), simAdcConversions(band->channel) - startConversions, 0x00, 0x00);
+    }
+}
+
+//Observer holding the silence button while the panel powers up, then checking the learnt limits are stored and used
+static void calibrationObserver(void) {
+    unsigned char *eeprom = simEeprom();
+    unsigned char slot = channelLimitSlot[HARNESS_SLC_CHANNEL(0x00)] << 0x01;
+    unsigned char i;
+
+    switch (calibrationStep) {
+        case 0x00:
+            //Hold the silence button and raise the normal reading of SLC1 before the firmware looks at them
+            simSetDigitalInputs(SIM_PORTD, 0x0B);
+            simSetAnalogInput(HARNESS_SLC_CHANNEL(0x00), CLASSIFY_CALIBRATED_READING);
+            calibrationStep++;
+            break;
+
+        case 0x01:
+            //Wait for the calibration to be written out, the firmware turns off the EEPROM write complete interrupt once it is done
+            if (eeprom[CLASSIFY_CALIBRATION_ADDRESS] == CLASSIFY_CALIBRATION_MARKER && (simPeek(SIM_PIE2) & 0x10) == 0x00) {
+                simSetDigitalInputs(SIM_PORTD, 0x0F);
+
+                //The stored limits of every channel in the scan must match the ones in use
+                for (i = 0x00; i < 0x0E; i++) {
+                    if (channelLimitSlot[i] != 0xFF && memcmp(&eeprom[CLASSIFY_CALIBRATION_ADDRESS + 0x01 + (i << 0x01)], &channelLimits[channelLimitSlot[i] << 0x01], 0x02) != 0x00) {
+                        harnessFinish(0x01, 0x00, 0x00, 0x00);
+                    }
+                }
+
+                //Drop SLC1 back to the harness normal reading, which is below the learnt open limit
+                simSetAnalogInput(HARNESS_SLC_CHANNEL(0x00), HARNESS_SLC_NORMAL);
+                stepAt = simCycles();
+                storedAt = simNanoseconds();
+                calibrationStep++;
+            }
+            if (simCycles() > HARNESS_TIMEOUT_CYCLES) {
+                harnessFinish(0x02, 0x00, 0x00, 0x00);
+            }
+            break;
+
+        default:
+            //The learnt limits must be in use, the old normal reading is now an open SLC
+            if ((slcTroubleCause & 0x01) == 0x01) {
+                harnessFinish(0x00, channelLimits[slot], channelLimits[slot + 0x01], storedAt);
+            }
+            if (simCycles() - stepAt > CLASSIFY_WINDOW_CYCLES) {
+                harnessFinish(0x03, channelLimits[slot], channelLimits[slot + 0x01], storedAt);
+            }
+            break;
+    }
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, runs every band and the calibration, returns non-zero if the classifier misbehaved
+int main(void) {
+    static const char *conditionNames[] = {"none", "alarm", "SLC trouble", "alarm, SLC trouble", "NAC trouble"};
+    unsigned long long result[HARNESS_RESULT_COUNT];
+    unsigned char failed = 0x00;
+    unsigned char i;
+
+    printf("ADC classifier, each band held for %llu cycles\n", CLASSIFY_WINDOW_CYCLES);
+    printf("band         reading  condition     readings  result\n");
+    for (i = 0x00; i < sizeof(bands) / sizeof(bands[0x00]); i++) {
+        const char *outcome = "pass";
+
+        band = &bands[i];
+        if (harnessRun(bandObserver, result) != 0x00) {
+            fprintf(stderr, "Band %s failed to run\n", bands[i].name);
+            return 0x02;
+        }
+
+        if (result[0x00] != bands[i].expected) {
+            outcome = "FAIL, wrong condition";
+        } else if (result[0x01] == 0x00) {
+            outcome = "FAIL, channel never read";
+        }
+
+        printf("%-11s  0x%03X    %-12s  %8llu  %s\n", bands[i].name, bands[i].reading, result[0x00] < 0x05 ? conditionNames[result[0x00]] : "several", result[0x01], outcome);
+        failed |= strcmp(outcome, "pass") != 0x00;
+    }
+
+    //Learn a calibration with SLC1 reading higher than usual, then check it was stored and is used
+    printf("\nCalibration with SLC1 at 0x%03X\n", CLASSIFY_CALIBRATED_READING);
+    if (harnessRun(calibrationObserver, result) != 0x00) {
+        fprintf(stderr, "Calibration failed to run\n");
+        return 0x02;
+    }
+
+    if (result[0x00] == 0x00 && (result[0x01] != (CLASSIFY_CALIBRATED_READING >> 0x02) - CLASSIFY_CALIBRATION_MARGIN || result[0x02] != (CLASSIFY_CALIBRATED_READING >> 0x02) + CLASSIFY_CALIBRATION_MARGIN)) {
+        result[0x00] = 0x04;
+    }
+
+    printf("SLC1 open limit 0x%02llX, alarm limit 0x%02llX, stored after %.1f ms, %s\n", result[0x01], result[0x02], result[0x03] / 1000000.0,
+           result[0x00] == 0x00 ? "pass" :
+           result[0x00] == 0x01 ? "FAIL, stored limits don't match" :
+           result[0x00] == 0x02 ? "FAIL, never stored" :
+           result[0x00] == 0x03 ? "FAIL, learnt limits not used" : "FAIL, wrong limits learnt");
+    failed |= result[0x00] != 0x00;
+
+    return failed;
+}
@@ -0,0 +1,186 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Cycle statistics report, runs the panel built with CYCLE_STATS      *
+ *  through an alarm, asks for a report over the software update port   *
+ *  and decodes the report the panel sends back out of the EUSART       *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Cycle Report Layout, must match the cycle statistics in Main.c
+#define CYCLES_COUNTERS 0x03       //Number of cycle counters
+#define CYCLES_REPORT_CURSOR 0x90  //Command byte the panel moves the cursor with before every report
+#define CYCLES_REPORT_TEXT 0x0D    //Characters in the report of a single counter, the tag and 12 hex digits
+
+//Scenario Timing
+#define CYCLES_LOAD_CYCLES 0x80000ULL  //Cycles the alarm is left to run for before the report is asked for
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Counters in the order the panel reports them, along with the tag it sends for each
+static const char cycleTags[CYCLES_COUNTERS] = {'I', 'S', 'L'};
+static const char *cycleNames[CYCLES_COUNTERS] = {"hardwareInterruptISR", "softwareISR", "main loop pass"};
+
+//Defined in Main.c, only when it is built with CYCLE_STATS
+extern unsigned short cycleMin[];
+extern unsigned short cycleMax[];
+extern unsigned short cycleLast[];
+
+static unsigned char scenarioStep = 0x00;                   //Step of the scenario the simulated panel is on
+static unsigned long long stepAt = 0x00;                    //Cycle the current step of the scenario started at
+static unsigned char receiveState = 0x00;                   //Progress through a report, 1 after the command prefix, 2 while reading the text
+static char reportText[CYCLES_REPORT_TEXT];                 //Text of the report being received
+static unsigned char reportLength = 0x00;                   //Characters of the report received so far
+static unsigned short reports[CYCLES_COUNTERS][0x03];       //Min, max and last of every counter as reported by the panel
+static unsigned char reported = 0x00;                       //Counters reported so far, one bit per counter
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Decode a finished report, returns 0 if it was understood
+static int decodeReport(void) {
+    unsigned char counter;
+    unsigned char i;
+
+    for (counter = 0x00; counter < CYCLES_COUNTERS && cycleTags[counter] != reportText[0x00]; counter++) {
+    }
+    if (counter == CYCLES_COUNTERS) {
+        return -1;
+    }
+
+    for (i = 0x00; i < 0x0C; i++) {
+        const char *digits = "0123456789ABCDEF";
+        const char *digit = reportText[0x01 + i] != 0x00 ? strchr(digits, reportText[0x01 + i]) : 0;
+
+        if (digit == 0) {
+            return -1;
+        }
+        if ((i & 0x03) == 0x00) {
+            reports[counter][i >> 0x02] = 0x00;
+        }
+        reports[counter][i >> 0x02] = (reports[counter][i >> 0x02] << 0x04) | (digit - digits);
+    }
+
+    reported |= 0x01 << counter;
+    return 0x00;
+}
+
+//Receive every byte the EUSART sends, picking the reports out of the stream and passing everything on to the simulated status LCD
+static void cyclesReceive(unsigned char data) {
+    harnessLcdReceive(data);
+
+    if (receiveState == 0x02) {
+        reportText[reportLength++] = data;
+        if (reportLength == CYCLES_REPORT_TEXT) {
+            receiveState = 0x00;
+            if (decodeReport() != 0x00) {
+                fprintf(stderr, "Report %.13s could not be decoded\n", reportText);
+                _exit(0x01);
+            }
+        }
+    } else if (receiveState == 0x01) {
+        receiveState = data == CYCLES_REPORT_CURSOR ? 0x02 : 0x00;
+        reportLength = 0x00;
+    } else if (data == 0xFE) {
+        receiveState = 0x01;
+    }
+}
+
+//Print the decoded reports and check them against the statistics in RAM, returns non-zero if anything doesn't add up
+static unsigned char printReports(void) {
+    double cyclesPerMs = simOscillatorFrequency() / 4000.0;
+    unsigned char failed = 0x00;
+    unsigned char counter;
+
+    printf("Cycle statistics reported over the EUSART after %llu cycles of general alarm\n", CYCLES_LOAD_CYCLES);
+    printf("counter               min cycles  max cycles  last cycles  max ms  result\n");
+    for (counter = 0x00; counter < CYCLES_COUNTERS; counter++) {
+        unsigned short *report = reports[counter];
+        const char *result = "pass";
+
+        //The counters only ever widen, so the statistics in RAM must still cover what was reported
+        if (report[0x00] > report[0x02] || report[0x02] > report[0x01]) {
+            result = "FAIL, last is outside of min and max";
+        } else if (cycleMin[counter] > report[0x00] || cycleMax[counter] < report[0x01]) {
+            result = "FAIL, report doesn't match RAM";
+        }
+
+        printf("%-20s  %10u  %10u  %11u  %6.3f  %s\n", cycleNames[counter], report[0x00], report[0x01], report[0x02], report[0x01] / cyclesPerMs, result);
+        failed |= strcmp(result, "pass") != 0x00;
+    }
+
+    //The report goes into hidden display RAM, so the status LCD must still show the alarm
+    printf("Status LCD: [%s] [%s]\n", harnessLcdLine(0x00), harnessLcdLine(0x01));
+    if (strncmp(harnessLcdLine(0x00), "GENERAL ALARM", 0x0D) != 0x00) {
+        printf("FAIL, the report showed up on the status LCD\n");
+        failed = 0x01;
+    }
+
+    return failed;
+}
+
+//Observer running the scenario, an alarm on SLC1 left to run for a while before the report is asked for
+static void scenarioObserver(void) {
+    switch (scenarioStep) {
+        case 0x00:
+            if (simCycles() >= HARNESS_WARMUP_CYCLES) {
+                simSetAnalogInput(HARNESS_SLC_CHANNEL(0x00), HARNESS_SLC_ALARM);
+                scenarioStep++;
+            }
+            break;
+
+        case 0x01:
+            if (generalAlarmCause != 0x00) {
+                stepAt = simCycles();
+                scenarioStep++;
+            }
+            break;
+
+        case 0x02:
+            //Ask for the report once the alarm has been running for a while, any byte will do
+            if (simCycles() - stepAt >= CYCLES_LOAD_CYCLES) {
+                simReceive('?');
+                stepAt = simCycles();
+                scenarioStep++;
+            }
+            break;
+
+        default:
+            if (reported == (0x01 << CYCLES_COUNTERS) - 0x01) {
+                unsigned char failed = printReports();
+
+                fflush(stdout);
+                _exit(failed);
+            }
+            if (simCycles() - stepAt > HARNESS_TIMEOUT_CYCLES) {
+                fprintf(stderr, "Only got the reports of counters 0x%02X\n", reported);
+                _exit(0x01);
+            }
+            break;
+    }
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, runs the scenario, the observer prints the report and ends the program
+int main(void) {
+    harnessPowerUp();
+    simSetTransmitter(cyclesReceive);
+    simSetObserver(scenarioObserver);
+    firmwareMain();
+    return 0x03;
+}
@@ -0,0 +1,285 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Event log decoder, prints the records of a data EEPROM dump oldest  *
+ *  first along with the stored calibration, or runs the simulated      *
+ *  panel through a scenario and decodes the event log it leaves behind *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Event Log Layout, must match the event log in Main.c
+#define EVENTLOG_RECORD_SIZE 0x04                                      //Bytes in a single record, data, timestamp high byte, timestamp low byte and type
+#define EVENTLOG_SIZE 0xC0                                             //Bytes of data EEPROM taken by the ring
+#define EVENTLOG_RECORD_COUNT (EVENTLOG_SIZE / EVENTLOG_RECORD_SIZE)    //Records in the ring
+#define EVENTLOG_BLANK_TYPE 0x7F                                       //Type of a record that has never been written, an erased byte reads 0xFF
+#define EVENTLOG_TICKS_PER_SECOND (4000000.0 / 4.0 / 256.0 / 256.0)    //Rate of the utility counter, Timer 0 overflows at 4MHz with a pre-scale of 256
+
+//Calibration Layout, must match the calibration in Main.c
+#define EVENTLOG_CALIBRATION_ADDRESS 0xC0  //Data EEPROM address of the marker byte, followed by the open and alarm limits of every channel, a byte each compared against the top 8 bits of a reading
+#define EVENTLOG_CALIBRATION_MARKER 0x5A   //Value of the marker byte once a complete calibration has been stored
+#define EVENTLOG_CHANNEL_COUNT 0x0E        //Channels with limits in the calibration
+
+//Intel HEX Layout, XC8 places the data EEPROM at word address 0x2100 with every byte taking up a whole word
+#define EVENTLOG_HEX_EEPROM_ADDRESS 0x4200UL  //Byte address of the data EEPROM in a HEX file
+
+//Scenario Timing
+#define EVENTLOG_BUTTON_CYCLES 0x30000ULL  //Cycles a button is held down for, long enough for the input task to sample it a few times
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Names of the event types, indexed by type
+static const char *eventNames[] = {
+    "unknown", "power up", "general alarm", "pre-alarm", "SLC trouble", "SLC restore",
+    "NAC trouble", "NAC restore", "acknowledge", "silence", "system reset", "calibration", "firmware update",
+    "power trouble", "power restore", "peer alarm"
+};
+
+//Names of the ADC channels, indexed by channel
+static const char *channelNames[EVENTLOG_CHANNEL_COUNT] = {
+    "NAC1", "NAC2", "NAC3", "NAC4", "AN4", "battery", "SLC1", "SLC2", "SLC3", "SLC4", "SLC5", "SLC6", "SLC7", "SLC8"
+};
+
+static const char *outputPath = 0;           //File the data EEPROM is saved to after the scenario, if any
+static unsigned char scenarioStep = 0x00;    //Step of the scenario the simulated panel is on
+static unsigned long long stepAt = 0x00;     //Cycle the current step of the scenario started at
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Print every record in the event log, starting from the oldest one
+static void decode(const unsigned char *eeprom) {
+    unsigned char lap = eeprom[EVENTLOG_RECORD_SIZE - 0x01] & 0x80;
+    unsigned short head;
+    unsigned short i;
+
+    //Find the newest record the same way the firmware does, the first record from another lap is where the ring continues
+    for (head = 0x01; head < EVENTLOG_RECORD_COUNT; head++) {
+        if ((eeprom[head * EVENTLOG_RECORD_SIZE + EVENTLOG_RECORD_SIZE - 0x01] & 0x80) != lap) {
+            break;
+        }
+    }
+    head %= EVENTLOG_RECORD_COUNT;
+
+    printf("slot  lap  timestamp  seconds  event          data\n");
+    for (i = 0x00; i < EVENTLOG_RECORD_COUNT; i++) {
+        unsigned short slot = (head + i) % EVENTLOG_RECORD_COUNT;
+        const unsigned char *record = &eeprom[slot * EVENTLOG_RECORD_SIZE];
+        unsigned char type = record[0x03] & 0x7F;
+        unsigned short timestamp = (record[0x01] << 0x08) | record[0x02];
+
+        if (type == EVENTLOG_BLANK_TYPE) {
+            continue;
+        }
+
+        printf("%4u  %3u  %9u  %7.1f  %-13s  0x%02X\n", slot, record[0x03] >> 0x07, timestamp, timestamp / EVENTLOG_TICKS_PER_SECOND,
+               type < sizeof(eventNames) / sizeof(eventNames[0x00]) ? eventNames[type] : eventNames[0x00], record[0x00]);
+    }
+}
+
+//Print the calibration stored after the event log, if a complete one is there
+static void decodeCalibration(const unsigned char *eeprom) {
+    const unsigned char *limits = &eeprom[EVENTLOG_CALIBRATION_ADDRESS + 0x01];
+    unsigned char channel;
+
+    if (eeprom[EVENTLOG_CALIBRATION_ADDRESS] != EVENTLOG_CALIBRATION_MARKER) {
+        printf("\nNo calibration stored, the default limits are in use\n");
+        return;
+    }
+
+    printf("\nchannel  open limit  alarm limit\n");
+    for (channel = 0x00; channel < EVENTLOG_CHANNEL_COUNT; channel++) {
+        printf("%-7s  %10u  %11u\n", channelNames[channel], limits[channel * 0x02] << 0x02, limits[channel * 0x02 + 0x01] << 0x02);
+    }
+}
+
+//Convert a hex digit pair into a byte, returns -1 if either character is not a hex digit
+static int hexByte(const char *text) {
+    char digits[0x03];
+    char *end;
+    long value;
+
+    digits[0x00] = text[0x00];
+    digits[0x01] = text[0x01];
+    digits[0x02] = 0x00;
+
+    value = strtol(digits, &end, 0x10);
+    return end == &digits[0x02] ? (int) value : -1;
+}
+
+//Load a data EEPROM dump, either the raw 256 bytes or an Intel HEX file read back from the panel, returns 0 on success
+static int load(const char *path, unsigned char *eeprom) {
+    char line[0x0200];
+    unsigned long base = 0x00;
+    FILE *file = fopen(path, "rb");
+    int first;
+
+    if (file == 0) {
+        return -1;
+    }
+
+    memset(eeprom, 0xFF, SIM_EEPROM_SIZE);
+
+    //A raw dump is taken as is
+    first = fgetc(file);
+    if (first != ':') {
+        size_t size;
+
+        ungetc(first, file);
+        size = fread(eeprom, 0x01, SIM_EEPROM_SIZE, file);
+        fclose(file);
+        return size == SIM_EEPROM_SIZE ? 0x00 : -1;
+    }
+    ungetc(first, file);
+
+    //Pick the data EEPROM bytes out of the data records of the HEX file
+    while (fgets(line, sizeof(line), file) != 0) {
+        int count;
+        int type;
+        int i;
+        unsigned long address;
+
+        if (line[0x00] != ':' || strlen(line) < 0x0B) {
+            continue;
+        }
+
+        count = hexByte(&line[0x01]);
+        address = (hexByte(&line[0x03]) << 0x08) | hexByte(&line[0x05]);
+        type = hexByte(&line[0x07]);
+        if (count < 0x00 || type < 0x00 || strlen(line) < (size_t) (0x0B + count * 0x02)) {
+            continue;
+        }
+
+        if (type == 0x04 && count == 0x02) {
+            base = (unsigned long) ((hexByte(&line[0x09]) << 0x08) | hexByte(&line[0x0B])) << 0x10;
+        } else if (type == 0x00) {
+            for (i = 0x00; i < count; i++) {
+                unsigned long byteAddress = base + address + i;
+
+                //Only the low byte of every word carries data
+                if (byteAddress >= EVENTLOG_HEX_EEPROM_ADDRESS && byteAddress < EVENTLOG_HEX_EEPROM_ADDRESS + SIM_EEPROM_SIZE * 0x02 && (byteAddress & 0x01) == 0x00) {
+                    eeprom[(byteAddress - EVENTLOG_HEX_EEPROM_ADDRESS) / 0x02] = hexByte(&line[0x09 + i * 0x02]);
+                }
+            }
+        }
+    }
+
+    fclose(file);
+    return 0x00;
+}
+
+//Observer running the scenario, an alarm on SLC3 followed by an acknowledge and a silence, then decodes the event log once it has been written out
+static void scenarioObserver(void) {
+    switch (scenarioStep) {
+        case 0x00:
+            if (simCycles() >= HARNESS_WARMUP_CYCLES) {
+                simSetAnalogInput(HARNESS_SLC_CHANNEL(0x02), HARNESS_SLC_ALARM);
+                scenarioStep++;
+            }
+            break;
+
+        case 0x01:
+        case 0x03:
+            //Push the acknowledge button, then the silence button, once the alarm has come in
+            if (generalAlarmCause != 0x00) {
+                simSetDigitalInputs(SIM_PORTD, scenarioStep == 0x01 ? 0x0D : 0x0B);
+                stepAt = simCycles();
+                scenarioStep++;
+            }
+            break;
+
+        case 0x02:
+        case 0x04:
+            //Let go of the button
+            if (simCycles() - stepAt >= EVENTLOG_BUTTON_CYCLES) {
+                simSetDigitalInputs(SIM_PORTD, 0x0F);
+                stepAt = simCycles();
+                scenarioStep++;
+            }
+            break;
+
+        default:
+            //Wait for the event queue to be written out, the firmware turns off the EEPROM write complete interrupt once it is empty
+            if (simCycles() - stepAt >= EVENTLOG_BUTTON_CYCLES && (simPeek(SIM_PIE2) & 0x10) == 0x00) {
+                printf("Event log after an alarm on SLC3, an acknowledge and a silence, %lu EEPROM writes\n", simEepromWrites());
+                decode(simEeprom());
+
+                if (outputPath != 0) {
+                    FILE *file = fopen(outputPath, "wb");
+
+                    if (file == 0 || fwrite(simEeprom(), 0x01, SIM_EEPROM_SIZE, file) != SIM_EEPROM_SIZE) {
+                        fprintf(stderr, "Failed to save the data EEPROM to %s\n", outputPath);
+                        _exit(0x02);
+                    }
+                    fclose(file);
+                }
+
+                fflush(stdout);
+                _exit(0x00);
+            }
+            if (simCycles() - stepAt > HARNESS_TIMEOUT_CYCLES) {
+                fprintf(stderr, "Event queue was never written out\n");
+                _exit(0x01);
+            }
+            break;
+    }
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, decodes the given dump or runs the scenario
+int main(int argc, char **argv) {
+    unsigned char eeprom[SIM_EEPROM_SIZE];
+    unsigned char simulate = 0x00;
+    int option;
+
+    while ((option = getopt(argc, argv, "so:")) != -1) {
+        switch (option) {
+            case 's':
+                simulate = 0x01;
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s <dump.bin | dump.hex>\n       %s -s [-o dump.bin]\n", argv[0x00], argv[0x00]);
+                return 0x02;
+        }
+    }
+
+    //Run the scenario on the simulated panel, the observer decodes the event log and ends the program
+    if (simulate == 0x01) {
+        harnessPowerUp();
+        simSetObserver(scenarioObserver);
+        firmwareMain();
+        return 0x03;
+    }
+
+    if (optind >= argc) {
+        fprintf(stderr, "Usage: %s <dump.bin | dump.hex>\n       %s -s [-o dump.bin]\n", argv[0x00], argv[0x00]);
+        return 0x02;
+    }
+
+    if (load(argv[optind], eeprom) != 0x00) {
+        fprintf(stderr, "Failed to load %s\n", argv[optind]);
+        return 0x02;
+    }
+
+    decode(eeprom);
+    decodeCalibration(eeprom);
+    return 0x00;
+}
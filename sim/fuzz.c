@@ -0,0 +1,353 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Replay fuzzer, powers the panel up once under the simulated clock,  *
+ *  then runs random or recorded traces on copies of the fuzz core,     *
+ *  one with a firmware of its own for every worker thread              *
+ ************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "xc.h"
+#include "harness.h"
+#include "fuzz.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+#define FUZZ_CORE "fuzzcore.so"  //Shared object of the fuzz core, found next to the fuzzer
+#define FUZZ_MAX_WORKERS 0x40    //Most worker threads, glibc runs out of room for more copies long before this
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Every variable of Main.c, the fuzz firmware object has them moved into sections of their own, one for those with a starting value and one for the rest
+extern unsigned char __start_firmware_data[];
+extern unsigned char __stop_firmware_data[];
+extern unsigned char __start_firmware_bss[];
+extern unsigned char __stop_firmware_bss[];
+
+//A copy of the fuzz core, loaded into a link map namespace of its own so its firmware, register file and C library are its own
+struct core {
+    void *handle;                                                                                          //Handle of the copy
+    void (*run)(unsigned long long, unsigned long, unsigned long, unsigned long, struct report *);  //fuzzRun() of the copy
+    unsigned char (*replay)(const struct trace *, unsigned short *);                                      //fuzzReplay() of the copy
+};
+
+//A worker thread and what it was given to do
+struct worker {
+    pthread_t thread;          //Thread running the worker
+    struct core core;          //Copy of the fuzz core it runs on
+    unsigned long long seed;   //Seed the traces are made up from
+    unsigned long scenarios;   //Random traces run across every worker
+    unsigned long index;       //Worker number, it takes every n-th scenario from here
+    unsigned long workers;     //Workers the scenarios are split across
+    struct report report;      //What the worker found
+};
+
+static const char *kindNames[FUZZ_KINDS] = {"reading", "button", "ac", "power"};
+static const char *invariantNames[FUZZ_INVARIANTS] = {"pass", "phantom alarm", "alarm missed", "NAC state", "NAC pins", "buzzer", "buzzer pin", "SLC trouble", "NAC trouble", "unacknowledged", "smoke reset"};
+
+//Power Up
+static jmp_buf booted;                 //Where the boot observer jumps to once the panel is idle
+static unsigned long bootNops = 0x00;  //Number of __nop() seen by the boot observer
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Stop the firmware once it has powered up and gone idle, the jump leaves firmwareMain() for good
+static void bootObserver(void) {
+    if (simCycles() >= HARNESS_WARMUP_CYCLES && simNops() != bootNops && simInIsr() == 0x00) {
+        longjmp(booted, 0x01);
+    }
+    bootNops = simNops();
+}
+
+//Print a trace in the form the fuzzer reads back in
+static void writeTrace(FILE *file, const struct trace *trace) {
+    unsigned char i;
+
+    fprintf(file, "ticks %u\n", trace->ticks);
+    for (i = 0x00; i < trace->count; i++) {
+        fprintf(file, "%u %s %u 0x%03X\n", trace->events[i].tick, kindNames[trace->events[i].kind], trace->events[i].index, trace->events[i].value);
+    }
+}
+
+//Read a recorded trace, a line of ticks followed by a line for each event in order, lines starting with # are left out, returns 0 on success
+static unsigned char readTrace(const char *path, struct trace *trace) {
+    FILE *file = fopen(path, "r");
+    char line[0x80];
+    char kind[0x10];
+    unsigned int tick;
+    unsigned int index;
+    unsigned int value;
+    unsigned char i;
+
+    if (file == 0) {
+        return 0x01;
+    }
+
+    trace->ticks = 0x00;
+    trace->count = 0x00;
+    while (fgets(line, sizeof(line), file) != 0) {
+        if (line[0x00] == '#' || line[0x00] == '\n') {
+            continue;
+        }
+
+        if (trace->ticks == 0x00) {
+            if (sscanf(line, "ticks %u", &tick) != 0x01 || tick == 0x00 || tick > 0xFFFF) {
+                break;
+            }
+            trace->ticks = tick;
+            continue;
+        }
+
+        if (trace->count == FUZZ_EVENTS || sscanf(line, "%u %15s %u %i", &tick, kind, &index, &value) != 0x04) {
+            break;
+        }
+        for (i = 0x00; i < FUZZ_KINDS && strcmp(kind, kindNames[i]) != 0x00; i++) {
+        }
+
+        //Events have to be in order and point at a channel or button that exists
+        if (i == FUZZ_KINDS || (trace->count != 0x00 && tick < trace->events[trace->count - 0x01].tick) || (i == FUZZ_READING && (index >= SIM_ADC_CHANNEL_COUNT || value > 0x03FF)) ||
+            (i == FUZZ_BUTTON && index >= 0x04)) {
+            break;
+        }
+
+        trace->events[trace->count].tick = tick;
+        trace->events[trace->count].kind = i;
+        trace->events[trace->count].index = index;
+        trace->events[trace->count].value = value;
+        trace->count++;
+    }
+
+    i = feof(file) != 0x00 && trace->ticks != 0x00 ? 0x00 : 0x01;
+    fclose(file);
+    return i;
+}
+
+//Load a copy of the fuzz core and hand it the panel as it was once it had powered up, returns 0 on success
+//The variables are only handed over if the copy's firmware lays them out in as many bytes, both are built from the same object
+static int loadCore(const char *path, const unsigned char *variables, unsigned long size, const unsigned char *registers, struct core *core) {
+    unsigned long (*variablesSize)(void);
+    int (*load)(const unsigned char *, const unsigned char *);
+
+    core->handle = dlmopen(LM_ID_NEWLM, path, RTLD_NOW | RTLD_LOCAL);
+    if (core->handle == 0) {
+        return -1;
+    }
+
+    variablesSize = (unsigned long (*)(void)) dlsym(core->handle, "fuzzVariablesSize");
+    load = (int (*)(const unsigned char *, const unsigned char *)) dlsym(core->handle, "fuzzLoad");
+    core->run = (void (*)(unsigned long long, unsigned long, unsigned long, unsigned long, struct report *)) dlsym(core->handle, "fuzzRun");
+    core->replay = (unsigned char (*)(const struct trace *, unsigned short *)) dlsym(core->handle, "fuzzReplay");
+    if (variablesSize == 0 || load == 0 || core->run == 0 || core->replay == 0 || variablesSize() != size || load(variables, registers) != 0x00) {
+        dlclose(core->handle);
+        return -1;
+    }
+
+    return 0x00;
+}
+
+//Run a worker's share of the scenarios on its own copy of the fuzz core
+static void *runWorker(void *argument) {
+    struct worker *worker = argument;
+
+    worker->core.run(worker->seed, worker->scenarios, worker->index, worker->workers, &worker->report);
+    return 0;
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, powers the panel up once, then runs the scenarios across worker threads or replays a recorded trace
+int main(int argc, char **argv) {
+    static struct worker pool[FUZZ_MAX_WORKERS];
+    unsigned long scenarios = FUZZ_SCENARIOS;   //Random traces to run
+    unsigned long workers = 0x00;               //Worker threads to run them across, 0 for one per CPU
+    unsigned long long seed = 0x01;             //Seed the traces are made up from
+    const char *replay = 0;                     //Recorded trace to run in place of the random ones
+    const char *output = 0;                     //File to write the shrunk trace of a failure to
+    unsigned char registers[SIM_REGISTER_COUNT];
+    unsigned char *variables;
+    unsigned long size;
+    char path[PATH_MAX];
+    char *slash;
+    ssize_t length;
+    struct report report;
+    struct report failure;
+    struct timespec start;
+    struct timespec end;
+    unsigned long long ticks = 0x00;
+    unsigned long done = 0x00;
+    unsigned long asked;
+    unsigned short failTick;
+    unsigned long i;
+    double seconds;
+    int option;
+    FILE *file;
+
+    while ((option = getopt(argc, argv, "n:j:s:r:o:")) != -1) {
+        switch (option) {
+            case 'n':
+                scenarios = strtoul(optarg, 0, 0);
+                break;
+            case 'j':
+                workers = strtoul(optarg, 0, 0);
+                break;
+            case 's':
+                seed = strtoull(optarg, 0, 0);
+                break;
+            case 'r':
+                replay = optarg;
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n scenarios] [-j workers] [-s seed] [-o failure.trace]\n       %s -r recorded.trace\n", argv[0x00], argv[0x00]);
+                return 0x02;
+        }
+    }
+
+    if (workers == 0x00) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        workers = cpus > 0x00 ? cpus : 0x01;
+    }
+    if (workers > FUZZ_MAX_WORKERS) {
+        workers = FUZZ_MAX_WORKERS;
+    }
+
+    //The fuzz core sits next to the fuzzer
+    length = readlink("/proc/self/exe", path, sizeof(path) - sizeof(FUZZ_CORE));
+    slash = length > 0x00 ? memrchr(path, '/', length) : 0;
+    if (slash == 0) {
+        fprintf(stderr, "Failed to find the fuzzer's own directory\n");
+        return 0x02;
+    }
+    strcpy(slash + 0x01, FUZZ_CORE);
+
+    //Power the panel up under the simulated clock, then keep its variables and registers to start every copy of the fuzz core from
+    size = (__stop_firmware_data - __start_firmware_data) + (__stop_firmware_bss - __start_firmware_bss);
+    variables = malloc(size);
+    if (variables == 0) {
+        return 0x02;
+    }
+    if (setjmp(booted) == 0x00) {
+        harnessPowerUp();
+        simSetObserver(bootObserver);
+        firmwareMain();
+        return 0x03;
+    }
+    simSetObserver(0);
+    memcpy(variables, __start_firmware_data, __stop_firmware_data - __start_firmware_data);
+    memcpy(variables + (__stop_firmware_data - __start_firmware_data), __start_firmware_bss, __stop_firmware_bss - __start_firmware_bss);
+    for (i = 0x00; i < SIM_REGISTER_COUNT; i++) {
+        registers[i] = simPeek(i);
+    }
+
+    if (replay != 0) {
+        if (readTrace(replay, &report.trace) != 0x00) {
+            fprintf(stderr, "Failed to read the trace in %s\n", replay);
+            return 0x02;
+        }
+        if (loadCore(path, variables, size, registers, &pool[0x00].core) != 0x00) {
+            fprintf(stderr, "Failed to load %s\n", path);
+            return 0x02;
+        }
+
+        report.invariant = pool[0x00].core.replay(&report.trace, &failTick);
+        if (report.invariant != FUZZ_PASS) {
+            printf("Broke \"%s\" at tick %u\nFAIL\n", invariantNames[report.invariant], failTick);
+            return 0x01;
+        }
+
+        printf("Every invariant held over %u ticks\nPASS\n", report.trace.ticks);
+        return 0x00;
+    }
+
+    //Every worker gets its own copy of the fuzz core, so they run side by side without sharing anything, there are only so many link map namespaces so run on the copies there is room for
+    asked = workers;
+    for (i = 0x00; i < asked; i++) {
+        if (loadCore(path, variables, size, registers, &pool[i].core) != 0x00) {
+            break;
+        }
+    }
+    workers = i;
+    if (workers == 0x00) {
+        fprintf(stderr, "Failed to load %s\n", path);
+        return 0x02;
+    }
+
+    printf("Replay fuzzer, %lu scenarios from seed 0x%llX across %lu worker threads", scenarios, seed, workers);
+    if (workers != asked) {
+        printf(" (%lu asked for, there was only room for %lu copies of the fuzz core)", asked, workers);
+    }
+    printf(", %u ADC sweeps per Timer 0 overflow\n", FUZZ_SWEEPS_PER_TICK);
+    fflush(stdout);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0x00; i < workers; i++) {
+        pool[i].seed = seed;
+        pool[i].scenarios = scenarios;
+        pool[i].index = i;
+        pool[i].workers = workers;
+        if (pthread_create(&pool[i].thread, 0, runWorker, &pool[i]) != 0x00) {
+            return 0x02;
+        }
+    }
+
+    //Gather the reports, the failure of the earliest scenario is the one shown, so the result doesn't depend on the number of workers
+    failure.invariant = FUZZ_PASS;
+    for (i = 0x00; i < workers; i++) {
+        pthread_join(pool[i].thread, 0);
+        report = pool[i].report;
+
+        done += report.scenarios;
+        ticks += report.ticks;
+        if (report.invariant != FUZZ_PASS && (failure.invariant == FUZZ_PASS || report.failed < failure.failed)) {
+            failure = report;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+
+    printf("%lu scenarios, %llu ticks in %.2f s, %.0f scenarios/s, %.0f ticks/s\n", done, ticks, seconds, done / seconds, ticks / seconds);
+
+    if (failure.invariant != FUZZ_PASS) {
+        printf("Scenario %lu broke \"%s\", shrunk from %u events over %u ticks to %u events breaking it at tick %u:\n", failure.failed, invariantNames[failure.invariant], failure.originalCount,
+               failure.originalTicks, failure.trace.count, failure.failTick);
+        writeTrace(stdout, &failure.trace);
+
+        if (output != 0) {
+            file = fopen(output, "w");
+            if (file == 0) {
+                fprintf(stderr, "Failed to write the trace to %s\n", output);
+                return 0x02;
+            }
+            fprintf(file, "# Scenario %lu from seed 0x%llX, breaks \"%s\" at tick %u\n", failure.failed, seed, invariantNames[failure.invariant], failure.failTick);
+            writeTrace(file, &failure.trace);
+            fclose(file);
+        }
+
+        printf("FAIL\n");
+        return 0x01;
+    }
+
+    printf("PASS\n");
+    return 0x00;
+}
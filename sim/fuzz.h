@@ -0,0 +1,83 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Replay fuzzer, shared by the fuzzer program and the fuzz core it    *
+ *  loads a copy of for every worker thread                             *
+ ************************************************************************/
+
+#ifndef FUZZ_H
+#define FUZZ_H
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Model, the clock is frozen and every trace tick runs a few ADC sweeps followed by a Timer 0 overflow, the real panel gets through many more sweeps but only their order matters to the logic
+#define FUZZ_SWEEPS_PER_TICK 0x02  //ADC sweeps run before every Timer 0 overflow
+#define FUZZ_MIN_TICKS 0x40        //Shortest random trace in Timer 0 overflows
+#define FUZZ_TICKS 0x0180          //Longest random trace, long enough for a reset to run out and the watchdog to reset the panel
+#define FUZZ_EVENTS 0x30           //Most events in a trace
+#define FUZZ_SCENARIOS 0x4000      //Random traces run when no count is given
+
+//Events
+#define FUZZ_READING 0x00  //An ADC channel reads a new value, the index is the channel and the value the 10 bit reading
+#define FUZZ_BUTTON 0x01   //A button is pushed, the index is the button (reset, acknowledge, silence, function) and the value the ticks it is held for
+#define FUZZ_AC 0x02       //AC power is lost with a value of 0 and comes back with a value of 1
+#define FUZZ_POWER 0x03    //The panel loses power and comes back up, everything outside the panel stays as it is
+#define FUZZ_KINDS 0x04
+
+//Invariants
+#define FUZZ_PASS 0x00           //Every invariant held
+#define FUZZ_PHANTOM_ALARM 0x01  //An alarm latched on an SLC that never read as an alarm
+#define FUZZ_ALARM_MISSED 0x02   //An SLC held in alarm never latched
+#define FUZZ_NAC_STATE 0x03      //The NAC's don't match the latched alarms and the silenced LED
+#define FUZZ_NAC_PINS 0x04       //The NAC pins don't follow the NAC's through their coder patterns
+#define FUZZ_BUZZER 0x05         //The buzzer doesn't match the un-acknowledged conditions, an acknowledge of the last one has to quiet it
+#define FUZZ_BUZZER_PIN 0x06     //The buzzer pin is on while the buzzer is off
+#define FUZZ_SLC_TROUBLE 0x07    //An SLC trouble didn't come in or restore once the SLC was held open or held clear
+#define FUZZ_NAC_TROUBLE 0x08    //A NAC trouble didn't come in or restore once the NAC was held in trouble or held clear
+#define FUZZ_UNACKNOWLEDGED 0x09 //A new alarm or trouble came in without being un-acknowledged, while the acknowledge button wasn't let go of
+#define FUZZ_SMOKE_RESET 0x0A    //A smoke reset took in an SLC that wasn't in alarm, or the power is cut to an SLC that isn't going through one
+#define FUZZ_INVARIANTS 0x0B
+
+/***************
+ *  Variables  *
+ ***************/
+
+//A single change to the world outside the panel
+struct event {
+    unsigned short tick;   //Timer 0 overflow the event happens before
+    unsigned char kind;    //What happens
+    unsigned char index;   //Channel or button it happens to
+    unsigned short value;  //Reading, ticks held or AC power state
+};
+
+//Events in the order they happen
+struct trace {
+    unsigned short ticks;                //Timer 0 overflows the trace runs for
+    unsigned char count;                 //Events in the trace
+    struct event events[FUZZ_EVENTS];  //Events, in order of their tick
+};
+
+//What a worker reports back once it is done
+struct report {
+    unsigned long scenarios;     //Scenarios run
+    unsigned long long ticks;    //Timer 0 overflows run, shrinking included
+    unsigned long failed;        //Index of the scenario that broke an invariant, only valid if invariant isn't FUZZ_PASS
+    unsigned char invariant;     //Invariant broken
+    unsigned short failTick;     //Tick of the shrunk trace the invariant broke on
+    unsigned char originalCount; //Events in the trace before it was shrunk
+    unsigned short originalTicks;  //Ticks of the trace before it was shrunk
+    struct trace trace;          //Shrunk trace
+};
+
+/***************
+ *  Functions  *
+ ***************/
+
+//Fuzz core, every copy of it carries a firmware and a register file of its own, found by name once the copy is loaded
+unsigned long fuzzVariablesSize(void);                                                                                 //Bytes taken by the variables of Main.c
+int fuzzLoad(const unsigned char *variables, const unsigned char *registers);                                          //Take the panel as it was once it had powered up, returns 0 on success
+void fuzzRun(unsigned long long seed, unsigned long scenarios, unsigned long worker, unsigned long workers, struct report *report);  //Run a worker's share of the scenarios
+unsigned char fuzzReplay(const struct trace *trace, unsigned short *failTick);                                         //Run a trace printing the state of the panel as it changes, returns the first invariant broken
+
+#endif
@@ -0,0 +1,660 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Fuzz core, feeds traces of ADC readings, button pushes and power    *
+ *  cuts straight into the interrupt and the tasks, checks the          *
+ *  invariants of the panel after every Timer 0 overflow and shrinks a  *
+ *  failing trace down to a minimal one, built into a shared object so  *
+ *  every worker thread of the fuzzer loads a firmware of its own       *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xc.h"
+#include "harness.h"
+#include "fuzz.h"
+#include "../PanelConfig.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Invariant Windows, in Timer 0 overflows, each is the most a correct panel can take and a tick to spare
+#define FUZZ_ALARM_TICKS 0x03        //An SLC held in alarm has to be latched with the NAC's driven, 3 of 4 readings at 2 sweeps a tick
+#define FUZZ_SLC_TROUBLE_TICKS 0x04  //An SLC held open or held clear has to have its trouble come in or restore, 4 readings at 2 sweeps a tick
+#define FUZZ_NAC_TROUBLE_TICKS (0x04 * FUZZ_SUPERVISION_TURNS / FUZZ_SWEEPS_PER_TICK + 0x02)  //A NAC held in trouble or held clear has to have its trouble come in or restore, 4 readings with the NAC's taking turns
+#define FUZZ_SUPERVISION_TURNS ((PANEL_NAC_ENABLED & 0x01) + ((PANEL_NAC_ENABLED >> 0x01) & 0x01) + ((PANEL_NAC_ENABLED >> 0x02) & 0x01) + (PANEL_NAC_ENABLED >> 0x03) + 0x01)  //Sweeps between readings of a NAC, every enabled NAC and the battery monitor take turns
+
+//Bands of a reading, in the order the limits of a channel put them in
+#define FUZZ_OPEN 0x00
+#define FUZZ_NORMAL 0x01
+#define FUZZ_ALARM 0x02
+#define FUZZ_SHORT 0x03
+
+//Coder Patterns, in the order panelgen.awk numbers them
+#define FUZZ_PATTERNS 0x05     //Patterns a NAC can follow
+#define FUZZ_PATTERN_RUNS 0x06 //Most on and off runs in a pattern
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Defined in Main.c
+void hardwareInterruptISR(void);
+extern void (*const taskTable[])(void);
+extern unsigned char taskReady[];
+extern unsigned char generalInterrupt;
+extern unsigned char activeADChannel;
+extern unsigned char lcdHead;
+extern unsigned char lcdTail;
+extern unsigned char eventQueueHead;
+extern unsigned char eventQueueTail;
+extern unsigned char preAlarmCause;
+extern unsigned char slcTroubleCause;
+extern unsigned char nacTroubleCause;
+extern unsigned char nacControl;
+extern unsigned char ledControl;
+extern unsigned char currentConditions;
+extern unsigned char coderPhase;
+extern unsigned char smokeResetSLCs;
+extern unsigned char slcControl;
+extern unsigned char LATB;
+extern unsigned char channelLimits[];
+extern const unsigned char channelShortLimit[];
+extern const unsigned char channelLimitSlot[];
+
+//Every variable of Main.c, the fuzz firmware object has them moved into sections of their own, one for those with a starting value and one for the rest
+extern unsigned char __start_firmware_data[];
+extern unsigned char __stop_firmware_data[];
+extern unsigned char __start_firmware_bss[];
+extern unsigned char __stop_firmware_bss[];
+
+static const unsigned char scanSchedule[] = {PANEL_ADC_SCAN_SCHEDULE};
+static const unsigned char nacPattern[HARNESS_NAC_COUNT] = {PANEL_NAC1_PATTERN, PANEL_NAC2_PATTERN, PANEL_NAC3_PATTERN, PANEL_NAC4_PATTERN};
+
+//On and off runs of each pattern in coder phases, written out apart from the generated coder table so the table gets checked rather than copied
+static const unsigned char patternRuns[FUZZ_PATTERNS][FUZZ_PATTERN_RUNS] = {
+    {0x01},                                //Steady
+    {0x01, 0x01},                          //120 BPM March-Time
+    {0x02, 0x02},                          //60 BPM March-Time
+    {0x02, 0x02, 0x02, 0x02, 0x02, 0x06},  //Temporal
+    {0x28, 0x14}                           //California, 10 seconds on and 5 seconds off
+};
+
+//Firmware State
+static unsigned char *snapshot = 0;  //Variables of Main.c as they were once the panel had powered up, those with a starting value first
+
+//World Outside the Panel
+static unsigned short readings[SIM_ADC_CHANNEL_COUNT];  //Reading each ADC channel gives
+static unsigned short buttonRelease[0x04];              //Tick each button is let go at
+static unsigned char buttons = 0x00;                    //Buttons being held, first bit is the reset button
+static unsigned char acPower = 0x01;                    //Set while AC power is present
+
+//Invariant Tracking
+static unsigned char everAlarm = 0x00;                        //SLC's that have read as an alarm since the panel powered up
+static unsigned char causes[0x04];                            //General alarm, pre-alarm, SLC trouble and NAC trouble causes at the end of the last tick
+static unsigned short heldAlarm[HARNESS_SLC_COUNT];           //Ticks each SLC has been held in alarm
+static unsigned short heldTrouble[SIM_ADC_CHANNEL_COUNT];     //Ticks each channel has been held in trouble
+static unsigned short heldClear[SIM_ADC_CHANNEL_COUNT];       //Ticks each channel has been held clear of trouble
+static unsigned long long ticksRun = 0x00;                    //Timer 0 overflows run by this copy
+static unsigned long long rng = 0x01;                         //State of the random number generator
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Next 32 random bits, xorshift64*
+static unsigned long random32(void) {
+    rng ^= rng >> 0x0C;
+    rng ^= rng << 0x19;
+    rng ^= rng >> 0x1B;
+    return (rng * 0x2545F4914F6CDD1DULL) >> 0x20;
+}
+
+//Seed the random number generator for a scenario, every scenario gets its own stream so it can be run again on its own
+static void seedScenario(unsigned long long seed, unsigned long scenario) {
+    rng = seed + (scenario + 0x01) * 0x9E3779B97F4A7C15ULL;
+    rng = (rng ^ (rng >> 0x1E)) * 0xBF58476D1CE4E5B9ULL;
+    rng = (rng ^ (rng >> 0x1B)) * 0x94D049BB133111EBULL;
+    rng ^= rng >> 0x1F;
+    rng |= 0x01;
+}
+
+//Band a reading falls into on a channel, using the limits the firmware is using on the top 8 bits of the reading, a channel that is never read stays normal
+static unsigned char bandOf(unsigned char channel, unsigned short reading) {
+    unsigned char slot = channelLimitSlot[channel];
+    unsigned char level = reading >> 0x02;
+    unsigned char band = FUZZ_OPEN;
+
+    if (slot == 0xFF) {
+        return FUZZ_NORMAL;
+    }
+
+    band += level >= channelLimits[slot << 0x01];
+    band += level >= channelLimits[(slot << 0x01) + 0x01];
+    band += level >= channelShortLimit[channel];
+    return band;
+}
+
+//Reading in the middle of a band on a channel, a band with no room at all gives a reading in the next one up
+static unsigned short bandReading(unsigned char channel, unsigned char band) {
+    unsigned short open = channelLimits[channelLimitSlot[channel] << 0x01];
+    unsigned short alarm = channelLimits[(channelLimitSlot[channel] << 0x01) + 0x01];
+    unsigned short shorted = channelShortLimit[channel];
+
+    switch (band) {
+        case FUZZ_OPEN:
+            return (open / 0x02) << 0x02;
+        case FUZZ_NORMAL:
+            return ((open + alarm) / 0x02) << 0x02;
+        case FUZZ_ALARM:
+            return ((alarm + shorted) / 0x02) << 0x02;
+        default:
+            return shorted >= 0xFF ? 0x03FF : ((shorted + 0x0100) / 0x02) << 0x02;
+    }
+}
+
+//1 if the pattern is on at the given coder phase, the runs start with an on run and repeat
+static unsigned char patternOn(unsigned char pattern, unsigned char phase) {
+    unsigned short length = 0x00;
+    unsigned char i;
+
+    for (i = 0x00; i < FUZZ_PATTERN_RUNS; i++) {
+        length += patternRuns[pattern][i];
+    }
+
+    phase %= length;
+    for (i = 0x00; phase >= patternRuns[pattern][i]; i++) {
+        phase -= patternRuns[pattern][i];
+    }
+
+    return (i & 0x01) ^ 0x01;
+}
+
+//Run every task that is ready in order of priority, the same way the scheduler does, then take the status LCD and the data EEPROM as done with what they were given
+static void runTasks(void) {
+    unsigned char task = 0x00;
+
+    while (task < HARNESS_TASK_COUNT) {
+        if (taskReady[task] == 0x00) {
+            task++;
+            continue;
+        }
+
+        taskReady[task] = 0x00;
+        taskTable[task]();
+        task = 0x00;
+    }
+
+    lcdTail = lcdHead;
+    PIE1 &= 0xEF;
+    eventQueueTail = eventQueueHead;
+    PIR2 = 0x00;
+    PIE2 = 0x00;
+}
+
+//Put the firmware back the way it was once it had powered up, the inputs stay as they are
+static void powerUp(void) {
+    memcpy(__start_firmware_data, snapshot, __stop_firmware_data - __start_firmware_data);
+    memcpy(__start_firmware_bss, snapshot + (__stop_firmware_data - __start_firmware_data), __stop_firmware_bss - __start_firmware_bss);
+    INTCON = 0x00;
+    PIR1 = 0x00;
+    WDTCON = 0x00;
+    runTasks();
+
+    everAlarm = 0x00;
+    memset(causes, 0x00, sizeof(causes));
+    memset(heldAlarm, 0x00, sizeof(heldAlarm));
+    memset(heldTrouble, 0x00, sizeof(heldTrouble));
+    memset(heldClear, 0x00, sizeof(heldClear));
+}
+
+//Run the ADC through a whole sweep, every reading goes through the interrupt left justified just like a finished conversion, then let the alarm task process it
+static void sweep(void) {
+    unsigned char readingsLeft = sizeof(scanSchedule);
+
+    do {
+        ADRESH = readings[activeADChannel & 0x0F] >> 0x02;
+        ADRESL = (readings[activeADChannel & 0x0F] << 0x06) & 0xFF;
+        PIR1 = 0x40;
+        hardwareInterruptISR();
+    } while ((generalInterrupt & 0x80) == 0x00 && --readingsLeft != 0x00);
+
+    runTasks();
+}
+
+//Overflow Timer 0 through the interrupt and run the tasks it makes ready
+static void timerOverflow(void) {
+    PIR1 = 0x00;
+    INTCON = 0x04;
+    hardwareInterruptISR();
+    runTasks();
+}
+
+//Bring an event about
+static void applyEvent(const struct event *event) {
+    switch (event->kind) {
+        case FUZZ_READING:
+            readings[event->index] = event->value;
+            break;
+
+        case FUZZ_BUTTON:
+            buttons |= 0x01 << event->index;
+            buttonRelease[event->index] = event->tick + event->value;
+            break;
+
+        case FUZZ_AC:
+            acPower = event->value;
+            break;
+
+        default:
+            powerUp();
+            break;
+    }
+}
+
+//Update the invariant tracking with how the tick went and check every invariant, returns the first one broken
+static unsigned char checkInvariants(unsigned char nacBefore, unsigned char smokeBefore, unsigned char acknowledged) {
+    unsigned char latched = generalAlarmCause | preAlarmCause;
+    unsigned char unacknowledged = 0x00;
+    unsigned char silenced = ledControl & 0x08;
+    unsigned char nacs;
+    unsigned char pins = 0x00;
+    unsigned char channel;
+    unsigned char band;
+    unsigned char bit;
+    unsigned char i;
+
+    //Follow the SLC's, an SLC going through a smoke reset has its readings thrown away so it starts over
+    for (i = 0x00; i < HARNESS_SLC_COUNT; i++) {
+        channel = HARNESS_SLC_CHANNEL(i);
+        band = bandOf(channel, readings[channel]);
+        bit = 0x01 << i;
+
+        if ((PANEL_SLC_ENABLED & bit) == 0x00) {
+            continue;
+        }
+
+        if (band >= FUZZ_ALARM) {
+            everAlarm |= bit;
+        }
+
+        if (((smokeBefore | smokeResetSLCs) & bit) != 0x00) {
+            heldAlarm[i] = 0x00;
+            heldTrouble[channel] = 0x00;
+            heldClear[channel] = 0x00;
+        } else {
+            heldAlarm[i] = band >= FUZZ_ALARM ? heldAlarm[i] + 0x01 : 0x00;
+            heldTrouble[channel] = band == FUZZ_OPEN ? heldTrouble[channel] + 0x01 : 0x00;
+            heldClear[channel] = band != FUZZ_OPEN ? heldClear[channel] + 0x01 : 0x00;
+        }
+    }
+
+    //Follow the NAC's, a NAC being driven reads as clear as it is only supervised while it is off, one that changed over during the tick starts over
+    //An alarm latching during the tick may have driven a NAC for part of it even if it was silenced again before the tick ended, so that starts every NAC over too
+    for (i = 0x00; i < HARNESS_NAC_COUNT; i++) {
+        band = bandOf(i, readings[i]);
+        bit = 0x01 << i;
+
+        if ((PANEL_NAC_ENABLED & bit) == 0x00) {
+            continue;
+        }
+
+        if (((nacBefore ^ nacControl) & bit) != 0x00 || latched != (causes[0x00] | causes[0x01])) {
+            heldTrouble[i] = 0x00;
+            heldClear[i] = 0x00;
+        } else {
+            heldTrouble[i] = band != FUZZ_NORMAL && (nacControl & bit) == 0x00 ? heldTrouble[i] + 0x01 : 0x00;
+            heldClear[i] = band == FUZZ_NORMAL || (nacControl & bit) != 0x00 ? heldClear[i] + 0x01 : 0x00;
+        }
+    }
+
+    //An alarm only ever latches on an SLC that has read as one, and always does once it has been held long enough
+    if ((latched & (everAlarm ^ 0xFF)) != 0x00) {
+        return FUZZ_PHANTOM_ALARM;
+    }
+    for (i = 0x00; i < HARNESS_SLC_COUNT; i++) {
+        if (heldAlarm[i] >= FUZZ_ALARM_TICKS && (latched & (0x01 << i)) == 0x00) {
+            return FUZZ_ALARM_MISSED;
+        }
+    }
+
+    //A latched alarm drives the NAC's that go with it, less the silenceable ones while the silenced LED is on, and nothing is driven or silenced without one
+    nacs = generalAlarmCause != 0x00 ? PANEL_NAC_ENABLED : (preAlarmCause != 0x00 ? PANEL_NAC_PRESIGNAL : 0x00);
+    if (silenced != 0x00) {
+        nacs &= PANEL_NAC_SILENCEABLE ^ 0xFF;
+    }
+    if ((nacControl & 0x0F) != nacs || (silenced != 0x00 && latched == 0x00)) {
+        return FUZZ_NAC_STATE;
+    }
+
+    //Every enabled NAC that is on follows its coder pattern out to its pin
+    for (i = 0x00; i < HARNESS_NAC_COUNT; i++) {
+        if ((PANEL_NAC_ENABLED & nacControl & (0x01 << i)) != 0x00 && patternOn(nacPattern[i], coderPhase) == 0x01) {
+            pins |= 0x01 << i;
+        }
+    }
+    if ((LATA >> 0x04) != pins) {
+        return FUZZ_NAC_PINS;
+    }
+
+    //The buzzer sounds while there is an un-acknowledged condition and only then
+    if (((ledControl & 0x01) == 0x01) != ((currentConditions & 0x07) != 0x00)) {
+        return FUZZ_BUZZER;
+    }
+    if ((LATB & 0x40) == 0x40 && (ledControl & 0x01) == 0x00) {
+        return FUZZ_BUZZER_PIN;
+    }
+
+    //Every new alarm or trouble comes in un-acknowledged, unless the acknowledge button could have taken it straight away
+    if ((generalAlarmCause & (causes[0x00] ^ 0xFF)) != 0x00) {
+        unacknowledged |= 0x02;
+    }
+    if ((preAlarmCause & (causes[0x01] ^ 0xFF)) != 0x00) {
+        unacknowledged |= 0x01;
+    }
+    if ((slcTroubleCause & (causes[0x02] ^ 0xFF)) != 0x00 || (nacTroubleCause & (causes[0x03] ^ 0xFF)) != 0x00) {
+        unacknowledged |= 0x04;
+    }
+    causes[0x00] = generalAlarmCause;
+    causes[0x01] = preAlarmCause;
+    causes[0x02] = slcTroubleCause;
+    causes[0x03] = nacTroubleCause;
+    if (acknowledged == 0x00 && (currentConditions & unacknowledged) != unacknowledged) {
+        return FUZZ_UNACKNOWLEDGED;
+    }
+
+    //A smoke reset only takes in SLC's in alarm, and only the SLC's it takes in have their power cut
+    if ((smokeResetSLCs & (latched ^ 0xFF)) != 0x00 || ((slcControl ^ PANEL_SLC_ENABLED) & (smokeResetSLCs ^ 0xFF)) != 0x00) {
+        return FUZZ_SMOKE_RESET;
+    }
+
+    //Troubles come in on channels held in trouble and restore on channels held clear
+    for (channel = 0x00; channel < SIM_ADC_CHANNEL_COUNT; channel++) {
+        if (channel < HARNESS_NAC_COUNT) {
+            bit = (nacTroubleCause >> channel) & 0x01;
+            if ((heldTrouble[channel] >= FUZZ_NAC_TROUBLE_TICKS && bit == 0x00) || (heldClear[channel] >= FUZZ_NAC_TROUBLE_TICKS && bit == 0x01)) {
+                return FUZZ_NAC_TROUBLE;
+            }
+        } else if (channel >= HARNESS_SLC_CHANNEL(0x00)) {
+            bit = (slcTroubleCause >> (channel - HARNESS_SLC_CHANNEL(0x00))) & 0x01;
+            if ((heldTrouble[channel] >= FUZZ_SLC_TROUBLE_TICKS && bit == 0x00) || (heldClear[channel] >= FUZZ_SLC_TROUBLE_TICKS && bit == 0x01)) {
+                return FUZZ_SLC_TROUBLE;
+            }
+        }
+    }
+
+    return FUZZ_PASS;
+}
+
+//Run a trace from power up, returns the first invariant broken along with the tick it broke on, printing the state of the panel as it changes if asked to
+static unsigned char runTrace(const struct trace *trace, unsigned short *failTick, unsigned char verbose) {
+    unsigned char next = 0x00;
+    unsigned char nacBefore;
+    unsigned char smokeBefore;
+    unsigned char buttonsBefore;
+    unsigned char invariant;
+    unsigned char shown[0x07];
+    unsigned char state[0x07];
+    unsigned short tick;
+    unsigned char i;
+
+    //Start every scenario from a healthy panel with nothing pushed
+    for (i = 0x00; i < SIM_ADC_CHANNEL_COUNT; i++) {
+        readings[i] = 0x0000;
+    }
+    for (i = 0x00; i < HARNESS_NAC_COUNT; i++) {
+        readings[i] = HARNESS_NAC_NORMAL;
+    }
+    for (i = 0x00; i < HARNESS_SLC_COUNT; i++) {
+        readings[HARNESS_SLC_CHANNEL(i)] = HARNESS_SLC_NORMAL;
+    }
+    readings[HARNESS_BATTERY_CHANNEL] = HARNESS_BATTERY_NORMAL;
+    buttons = 0x00;
+    acPower = 0x01;
+    powerUp();
+    memset(shown, 0xFF, sizeof(shown));
+
+    if (verbose == 0x01) {
+        printf("tick  alarm  pre  slc trouble  nac trouble  nacs  pins  leds  unack\n");
+    }
+
+    for (tick = 0x00; tick < trace->ticks; tick++) {
+        //Let go of the buttons that have been held long enough, then bring about the events of the tick
+        buttonsBefore = buttons;
+        for (i = 0x00; i < 0x04; i++) {
+            if ((buttons & (0x01 << i)) != 0x00 && buttonRelease[i] <= tick) {
+                buttons &= 0xFF ^ (0x01 << i);
+            }
+        }
+        while (next < trace->count && trace->events[next].tick <= tick) {
+            applyEvent(&trace->events[next++]);
+        }
+        simSetDigitalInputs(SIM_PORTD, buttons ^ 0x0F);
+        simSetDigitalInputs(SIM_PORTB, acPower << 0x07);
+
+        nacBefore = nacControl;
+        smokeBefore = smokeResetSLCs;
+        for (i = 0x00; i < FUZZ_SWEEPS_PER_TICK; i++) {
+            sweep();
+        }
+        timerOverflow();
+        ticksRun++;
+
+        invariant = checkInvariants(nacBefore, smokeBefore, buttonsBefore & (buttons ^ 0xFF) & 0x02);  //The panel acts on a button as it is let go of
+
+        if (verbose == 0x01) {
+            state[0x00] = generalAlarmCause;
+            state[0x01] = preAlarmCause;
+            state[0x02] = slcTroubleCause;
+            state[0x03] = nacTroubleCause;
+            state[0x04] = nacControl;
+            state[0x05] = ledControl & 0x3F;
+            state[0x06] = currentConditions;
+            if (memcmp(state, shown, sizeof(state)) != 0x00 || invariant != FUZZ_PASS) {
+                printf("%4u     %02X   %02X           %02X           %02X     %X     %X    %02X      %X\n", tick, state[0x00], state[0x01], state[0x02], state[0x03], state[0x04] & 0x0F, LATA >> 0x04,
+                       state[0x05], state[0x06]);
+                memcpy(shown, state, sizeof(state));
+            }
+        }
+
+        if (invariant != FUZZ_PASS) {
+            *failTick = tick;
+            return invariant;
+        }
+
+        //The reset button ends with the watchdog resetting the panel
+        if ((simPeek(SIM_WDTCON) & 0x01) == 0x01) {
+            powerUp();
+        }
+    }
+
+    return FUZZ_PASS;
+}
+
+//Make up a random trace
+static void randomTrace(struct trace *trace) {
+    struct event event;
+    unsigned char channel;
+    unsigned char i;
+    unsigned char j;
+
+    trace->ticks = FUZZ_MIN_TICKS + random32() % (FUZZ_TICKS - FUZZ_MIN_TICKS + 0x01);
+    trace->count = random32() % (FUZZ_EVENTS + 0x01);
+
+    for (i = 0x00; i < trace->count; i++) {
+        unsigned long pick = random32() % 0x64;
+
+        event.tick = random32() % trace->ticks;
+        event.index = 0x00;
+        event.value = 0x00;
+
+        //Most events are readings, a quarter of those anywhere at all and the rest in the middle of a band, so verified conditions come about often
+        if (pick < 0x3C) {
+            event.kind = FUZZ_READING;
+            channel = scanSchedule[random32() % sizeof(scanSchedule)] & 0x0F;
+            event.index = channel;
+            event.value = random32() % 0x04 == 0x00 ? random32() % 0x0400 : bandReading(channel, random32() % 0x04);
+        } else if (pick < 0x5A) {
+            event.kind = FUZZ_BUTTON;
+            event.index = random32() % 0x04;
+            event.value = 0x01 + random32() % 0x03;
+        } else if (pick < 0x61) {
+            event.kind = FUZZ_AC;
+            event.value = random32() % 0x02;
+        } else {
+            event.kind = FUZZ_POWER;
+        }
+
+        //Keep the events in order of their tick
+        for (j = i; j != 0x00 && trace->events[j - 0x01].tick > event.tick; j--) {
+            trace->events[j] = trace->events[j - 0x01];
+        }
+        trace->events[j] = event;
+    }
+}
+
+//Cut a trace off after the tick it broke on, the events after it have nothing to do with it
+static void truncateTrace(struct trace *trace, unsigned short failTick) {
+    trace->ticks = failTick + 0x01;
+    while (trace->count != 0x00 && trace->events[trace->count - 0x01].tick > failTick) {
+        trace->count--;
+    }
+}
+
+//Try a smaller trace in place of the failing one, taking it if it breaks the same invariant
+static unsigned char tryTrace(struct trace *trace, struct trace *candidate, unsigned char invariant, unsigned short *failTick) {
+    unsigned short tick;
+
+    if (runTrace(candidate, &tick, 0x00) != invariant) {
+        return 0x00;
+    }
+
+    truncateTrace(candidate, tick);
+    *trace = *candidate;
+    *failTick = tick;
+    return 0x01;
+}
+
+//Shrink a failing trace, taking out runs of events that get smaller till no single event can go, then simplifying the events left and moving them to the start
+static void shrinkTrace(struct trace *trace, unsigned char invariant, unsigned short *failTick) {
+    struct trace candidate;
+    unsigned char chunk;
+    unsigned char shrunk;
+    unsigned char i;
+
+    truncateTrace(trace, *failTick);
+
+    do {
+        shrunk = 0x00;
+
+        //Take out runs of events, halving the run each time
+        for (chunk = trace->count; chunk != 0x00; chunk /= 0x02) {
+            i = 0x00;
+            while (i + chunk <= trace->count) {
+                candidate = *trace;
+                memmove(&candidate.events[i], &candidate.events[i + chunk], (candidate.count - i - chunk) * sizeof(struct event));
+                candidate.count -= chunk;
+
+                if (tryTrace(trace, &candidate, invariant, failTick) == 0x01) {
+                    shrunk = 0x01;
+                } else {
+                    i++;
+                }
+            }
+        }
+
+        //Hold the buttons for a single tick and put the readings in the middle of their band
+        for (i = 0x00; i < trace->count; i++) {
+            candidate = *trace;
+            if (candidate.events[i].kind == FUZZ_BUTTON && candidate.events[i].value != 0x01) {
+                candidate.events[i].value = 0x01;
+            } else if (candidate.events[i].kind == FUZZ_READING) {
+                candidate.events[i].value = bandReading(candidate.events[i].index, bandOf(candidate.events[i].index, candidate.events[i].value));
+                if (candidate.events[i].value == trace->events[i].value) {
+                    continue;
+                }
+            } else {
+                continue;
+            }
+
+            shrunk |= tryTrace(trace, &candidate, invariant, failTick);
+        }
+
+        //Move every event towards the start by the gap before the first one, leaving the length alone as the invariant may break a little later in the sweep pattern
+        if (trace->count != 0x00 && trace->events[0x00].tick != 0x00) {
+            unsigned short gap = trace->events[0x00].tick;
+
+            candidate = *trace;
+            for (i = 0x00; i < candidate.count; i++) {
+                candidate.events[i].tick -= gap;
+            }
+            shrunk |= tryTrace(trace, &candidate, invariant, failTick);
+        }
+    } while (shrunk == 0x01);
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Bytes taken by the variables of Main.c, the fuzzer only hands its power up over to a copy of the same firmware
+unsigned long fuzzVariablesSize(void) {
+    return (__stop_firmware_data - __start_firmware_data) + (__stop_firmware_bss - __start_firmware_bss);
+}
+
+//Take the panel as it was once it had powered up in the fuzzer, variables with a starting value first, then freeze it there to start every scenario from, returns 0 on success
+int fuzzLoad(const unsigned char *variables, const unsigned char *registers) {
+    unsigned char i;
+
+    snapshot = malloc(fuzzVariablesSize());
+    if (snapshot == 0) {
+        return -1;
+    }
+
+    memcpy(__start_firmware_data, variables, __stop_firmware_data - __start_firmware_data);
+    memcpy(__start_firmware_bss, variables + (__stop_firmware_data - __start_firmware_data), __stop_firmware_bss - __start_firmware_bss);
+    for (i = 0x00; i < SIM_REGISTER_COUNT; i++) {
+        *simRegister(i) = registers[i];
+    }
+    simSetDigitalInputs(SIM_PORTE, 0x08);  //The hard reset button is not pushed
+
+    INTCON = 0x00;
+    runTasks();
+    memcpy(snapshot, __start_firmware_data, __stop_firmware_data - __start_firmware_data);
+    memcpy(snapshot + (__stop_firmware_data - __start_firmware_data), __start_firmware_bss, __stop_firmware_bss - __start_firmware_bss);
+    return 0x00;
+}
+
+//Run a worker's share of the scenarios, every worker takes every n-th scenario and stops at the first one that fails
+void fuzzRun(unsigned long long seed, unsigned long scenarios, unsigned long worker, unsigned long workers, struct report *report) {
+    unsigned long scenario;
+
+    memset(report, 0x00, sizeof(*report));
+    for (scenario = worker; scenario < scenarios; scenario += workers) {
+        seedScenario(seed, scenario);
+        randomTrace(&report->trace);
+        report->scenarios++;
+
+        report->invariant = runTrace(&report->trace, &report->failTick, 0x00);
+        if (report->invariant != FUZZ_PASS) {
+            report->failed = scenario;
+            report->originalCount = report->trace.count;
+            report->originalTicks = report->trace.ticks;
+            shrinkTrace(&report->trace, report->invariant, &report->failTick);
+            break;
+        }
+    }
+
+    report->ticks = ticksRun;
+}
+
+//Run a trace printing the state of the panel as it changes, returns the first invariant broken along with the tick it broke on
+//This copy has a C library of its own, so what it prints is flushed before handing back to the fuzzer
+unsigned char fuzzReplay(const struct trace *trace, unsigned short *failTick) {
+    unsigned char invariant = runTrace(trace, failTick, 0x01);
+
+    fflush(stdout);
+    return invariant;
+}
@@ -0,0 +1,183 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Shared harness used by the simulator programs, describes the panel  *
+ *  wiring and the firmware symbols the harnesses look at               *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+
+static int resultPipe = -1;  //Pipe used by the child process to report the result of a run back to the parent process
+
+//Simulated Status LCD
+static char lcdScreen[HARNESS_LCD_LINES][HARNESS_LCD_COLUMNS + 0x01];  //Characters shown on each line of the status LCD
+static unsigned char lcdCursor = 0x00;                                 //Address the next character is written to, 0x00 for the first line and 0x40 for the second
+static unsigned char lcdCommand = 0x00;                                //Set when the last byte received was the command prefix
+
+//Simulated SLC Control Shift Register, a 74HC595 with its data, clock and latch inputs on PORTC3, PORTC4 and PORTC5
+static unsigned char slcShift = 0x00;  //Bits clocked into the shift register, the first bit clocked in ends up on the last output
+static unsigned char slcPower = 0x00;  //Bits on the outputs of the storage register, a set bit powers an SLC, first bit is SLC1
+static unsigned char slcPins = 0x00;   //Level last seen on PORTC, used to spot the rising edges of the clock and latch
+
+//Receive a byte sent by the EUSART into the simulated status LCD, 0xFE starts a command and 0x80 plus an address moves the cursor
+void harnessLcdReceive(unsigned char data) {
+    unsigned char line = lcdCursor >> 0x06;
+    unsigned char column = lcdCursor & 0x3F;
+
+    if (lcdCommand == 0x01) {
+        lcdCommand = 0x00;
+        if ((data & 0x80) == 0x80) {
+            lcdCursor = data & 0x7F;
+        }
+    } else if (data == 0xFE) {
+        lcdCommand = 0x01;
+    } else {
+        //Characters written past the end of a line are dropped, just like on the real LCD where they land in hidden display RAM
+        if (line < HARNESS_LCD_LINES && column < HARNESS_LCD_COLUMNS) {
+            lcdScreen[line][column] = data;
+        }
+        lcdCursor++;
+    }
+}
+
+//Follow the output pins of the MCU into the parts of the board outside of it, clocking the SLC control shift register on rising edges
+static void boardPins(enum simRegisterIndex port, unsigned char outputs) {
+    unsigned char rising = outputs & (slcPins ^ 0xFF);
+
+    if (port != SIM_PORTC) {
+        return;
+    }
+
+    if ((rising & 0x10) == 0x10) {
+        slcShift = (slcShift << 0x01) | ((outputs & 0x08) >> 0x03);
+    }
+    if ((rising & 0x20) == 0x20) {
+        slcPower = slcShift;
+    }
+    slcPins = outputs;
+}
+
+//Reset the simulated MCU and drive every input to the idle state of a healthy panel
+void harnessPowerUp(void) {
+    unsigned char i;
+
+    simReset();
+    simSetTransmitter(harnessLcdReceive);
+    simSetPinWatcher(boardPins);
+
+    //The SLC control shift register powers up with its outputs off
+    slcShift = 0x00;
+    slcPower = 0x00;
+    slcPins = 0x00;
+
+    //The status LCD powers up blank with the cursor at the start of the first line
+    for (i = 0x00; i < HARNESS_LCD_LINES; i++) {
+        memset(lcdScreen[i], ' ', HARNESS_LCD_COLUMNS);
+        lcdScreen[i][HARNESS_LCD_COLUMNS] = 0x00;
+    }
+    lcdCursor = 0x00;
+    lcdCommand = 0x00;
+
+    //Every SLC and NAC only has its EOL resistor present and the battery is charged
+    for (i = 0x00; i < HARNESS_NAC_COUNT; i++) {
+        simSetAnalogInput(i, HARNESS_NAC_NORMAL);
+    }
+    for (i = 0x00; i < HARNESS_SLC_COUNT; i++) {
+        simSetAnalogInput(HARNESS_SLC_CHANNEL(i), HARNESS_SLC_NORMAL);
+    }
+    simSetAnalogInput(HARNESS_BATTERY_CHANNEL, HARNESS_BATTERY_NORMAL);
+
+    simSetDigitalInputs(SIM_PORTB, 0x80);  //AC power is present
+    simSetDigitalInputs(SIM_PORTD, 0x0F);  //None of the buttons are pushed, they pull the pins LOW
+    simSetDigitalInputs(SIM_PORTE, 0x08);  //The hard reset button is not pushed
+}
+
+//Run the firmware from power up in a child process until the observer finishes it, so the firmware globals start from their initial values every time
+int harnessRun(simObserver observer, unsigned long long result[HARNESS_RESULT_COUNT]) {
+    int fds[0x02];
+    pid_t child;
+    int status;
+
+    if (pipe(fds) != 0x00) {
+        return -1;
+    }
+
+    child = fork();
+    if (child == 0x00) {
+        close(fds[0x00]);
+        resultPipe = fds[0x01];
+
+        harnessPowerUp();
+        simSetObserver(observer);
+        firmwareMain();
+        _exit(0x03);
+    }
+
+    close(fds[0x01]);
+    if (child < 0x00 || read(fds[0x00], result, sizeof(unsigned long long) * HARNESS_RESULT_COUNT) != sizeof(unsigned long long) * HARNESS_RESULT_COUNT) {
+        close(fds[0x00]);
+        return -1;
+    }
+    close(fds[0x00]);
+    waitpid(child, &status, 0x00);
+
+    return 0x00;
+}
+
+//Called by an observer to report its result and end the run
+void harnessFinish(unsigned long long first, unsigned long long second, unsigned long long third, unsigned long long fourth) {
+    unsigned long long result[HARNESS_RESULT_COUNT];
+
+    result[0x00] = first;
+    result[0x01] = second;
+    result[0x02] = third;
+    result[0x03] = fourth;
+
+    if (write(resultPipe, result, sizeof(result)) != sizeof(result)) {
+        _exit(0x02);
+    }
+
+    _exit(0x00);
+}
+
+//Print the outcome of a check as a line of the result table, returns 1 if it failed so the caller can remember it
+unsigned char harnessCheck(const char *name, unsigned char passed, const char *detail) {
+    printf("%-18s  %-6s  %s\n", name, passed == 0x01 ? "pass" : "FAIL", detail);
+    return passed ^ 0x01;
+}
+
+//Comparison function used to sort samples of cycles or times with qsort()
+int harnessCompareSamples(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *) a;
+    unsigned long long y = *(const unsigned long long *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+//Produce the next pseudo random number, using a xorshift generator so runs can be reproduced from their seed
+unsigned long long harnessRandom(unsigned long long *state) {
+    *state ^= *state << 0x0D;
+    *state ^= *state >> 0x07;
+    *state ^= *state << 0x11;
+    return *state;
+}
+
+//Produce a pseudo random number between two limits, inclusive
+unsigned long long harnessRandomBetween(unsigned long long *state, unsigned long long low, unsigned long long high) {
+    return low + harnessRandom(state) % (high - low + 0x01);
+}
+
+//SLC's currently powered by the SLC control shift register, first bit is SLC1
+unsigned char harnessSlcPower(void) {
+    return slcPower;
+}
+
+//Text currently shown on a line of the simulated status LCD
+const char *harnessLcdLine(unsigned char line) {
+    return line < HARNESS_LCD_LINES ? lcdScreen[line] : "";
+}
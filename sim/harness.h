@@ -0,0 +1,70 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Shared harness used by the simulator programs, describes the panel  *
+ *  wiring and the firmware symbols the harnesses look at               *
+ ************************************************************************/
+
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include "pic16f884.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Firmware Layout
+#define HARNESS_TASK_COUNT 0x04  //Number of tasks in the scheduler task table
+
+//Panel Wiring
+#define HARNESS_SLC_COUNT 0x08                   //Number of SLC's on the panel
+#define HARNESS_SLC_CHANNEL(slc) ((slc) + 0x06)  //ADC channel of an SLC, SLC1 to SLC8 are wired to AN6 to AN13
+#define HARNESS_NAC_COUNT 0x04                   //Number of NAC's on the panel
+#define HARNESS_BATTERY_CHANNEL 0x05             //ADC channel of the battery monitor on PORTE0
+
+//Analog Readings
+#define HARNESS_SLC_NORMAL 0x0200    //Reading of an SLC with only its EOL resistor present
+#define HARNESS_SLC_ALARM 0x03FF     //Reading of an SLC with a detector in alarm shorting the loop
+#define HARNESS_NAC_NORMAL 0x0100    //Reading of a NAC with only its EOL resistor present
+#define HARNESS_BATTERY_NORMAL 0x0300  //Reading of a charged battery
+
+//Timing
+#define HARNESS_WARMUP_CYCLES 0x30000ULL     //Cycles to run after power up before injecting anything, lets the scan settle
+#define HARNESS_TIMEOUT_CYCLES 0x2000000ULL  //Cycles to wait for the firmware to react before giving up
+#define HARNESS_SCAN_WINDOW_CYCLES 0x100000ULL  //Cycles to count ADC conversions over when measuring the scan rate
+
+//Status LCD
+#define HARNESS_LCD_LINES 0x02    //Number of lines on the status LCD
+#define HARNESS_LCD_COLUMNS 0x10  //Number of characters on each line of the status LCD
+
+//Results
+#define HARNESS_RESULT_COUNT 0x04  //Number of values an observer reports at the end of a run
+
+/***********************
+ *  Firmware Symbols   *
+ ***********************/
+
+//Defined in Main.c, main() is renamed when building for the host so the harness can provide its own
+void firmwareMain(void);
+extern unsigned char LATA;
+extern unsigned char generalAlarmCause;
+extern unsigned char lcdDirty;
+extern const unsigned char channelVerifyCount[];  //Verification counts of each ADC channel, first 4 bits for alarms
+extern unsigned short taskWorstCase[];  //Only in the firmware built with CYCLE_STATS
+
+/***************
+ *  Functions  *
+ ***************/
+
+void harnessPowerUp(void);                                                     //Reset the simulated MCU and drive every input to the idle state of a healthy panel
+int harnessRun(simObserver observer, unsigned long long result[HARNESS_RESULT_COUNT]);  //Run the firmware from power up in a child process until the observer finishes it, returns 0 on success
+void harnessFinish(unsigned long long first, unsigned long long second, unsigned long long third, unsigned long long fourth);  //Called by an observer to report its result and end the run
+void harnessLcdReceive(unsigned char data);                                    //Receive a byte sent by the EUSART into the simulated status LCD, for programs that watch the EUSART themselves
+const char *harnessLcdLine(unsigned char line);                                //Text currently shown on a line of the simulated status LCD
+unsigned char harnessSlcPower(void);                                           //SLC's currently powered by the SLC control shift register, first bit is SLC1
+unsigned char harnessCheck(const char *name, unsigned char passed, const char *detail);  //Print the outcome of a check as a line of the result table, returns 1 if it failed
+int harnessCompareSamples(const void *a, const void *b);                       //Comparison function used to sort samples of cycles or times with qsort()
+unsigned long long harnessRandom(unsigned long long *state);                   //Produce the next pseudo random number from a xorshift generator
+unsigned long long harnessRandomBetween(unsigned long long *state, unsigned long long low, unsigned long long high);  //Produce a pseudo random number between two limits, inclusive
+
+#endif
@@ -0,0 +1,252 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Telemetry loopback test, decodes the telemetry frames sent along    *
+ *  with the status LCD in place of a receiver, checks the decoded      *
+ *  state against the panel and measures the link it takes up           *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+#include "../telemetry/telemetry.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Timing, in nanoseconds of simulated time
+#define LOOPBACK_SETTLE_NS 1000000000ULL   //Time the panel is left to send its first frames after power up
+#define LOOPBACK_IDLE_NS 12000000000ULL    //Time the link is measured over while nothing changes, long enough for every reading to be sent whole by the heartbeats
+#define LOOPBACK_TIMEOUT_NS 60000000000ULL //Longest the test may run for
+#define LOOPBACK_CHANGE_BUDGET_NS 300000000ULL  //Longest a change may take to be decoded, 2 runs of the LCD task and a frame
+#define LOOPBACK_RECOVER_BUDGET_NS 12000000000ULL  //Longest every reading may take to be known again after a lost frame, 5 heartbeats and a bit
+
+//Readings changed while the panel is steady
+#define LOOPBACK_DELTA_CHANNEL HARNESS_SLC_CHANNEL(0x02)        //Channel changed by a little, sent as a delta item
+#define LOOPBACK_DELTA_READING (HARNESS_SLC_NORMAL + 0x1C)      //Reading it is changed to, the frames carry the top 8 bits so the bottom 2 are left clear
+#define LOOPBACK_WHOLE_CHANNEL HARNESS_BATTERY_CHANNEL           //Channel changed by a lot, sent as a whole reading
+#define LOOPBACK_WHOLE_READING (HARNESS_BATTERY_NORMAL + 0xC8)  //Reading it is changed to
+
+//Byte of a frame after the command that is lost on the line
+#define LOOPBACK_LOST_BYTE 0x04
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Defined in Main.c
+extern unsigned char preAlarmCause;
+extern unsigned char slcTroubleCause;
+extern unsigned char nacTroubleCause;
+extern unsigned char generalTroubleCause;
+extern unsigned char channelLevels[];
+extern unsigned char telemetryLevels[];
+extern const unsigned char channelLimitSlot[];
+
+static struct telemetry telemetry;                //Decoder standing in for the receiver
+static unsigned char step = 0x00;                 //Step of the test the panel is on
+static unsigned long long stepAt = 0x00;          //Time the current step started at
+static unsigned char failed = 0x00;               //Set once any check has failed
+static unsigned char lastByte = 0x00;             //Last byte sent by the EUSART
+static unsigned char frameByte = 0x00;            //Bytes sent since the last telemetry command
+static unsigned char loseByte = 0x00;             //Set while the next frame should lose a byte on the line
+static unsigned long long alarmLatchedAt = 0x00;  //Time the panel latched the general alarm
+
+//Results
+static unsigned long idleBytes = 0x00;        //Bytes of frames at the start of the idle measurement
+static unsigned long idleFrames = 0x00;       //Frames at the start of the idle measurement
+static unsigned long idleHeartbeats = 0x00;   //Heartbeats at the start of the idle measurement
+static unsigned long lostBefore = 0x00;       //Frames lost before the byte was dropped
+static unsigned long long lostAt = 0x00;      //Time the decoder spotted the lost frame
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Receive every byte the EUSART sends into the simulated status LCD and the decoder, dropping a byte of a frame when asked to
+static void loopbackReceive(unsigned char data) {
+    harnessLcdReceive(data);
+
+    frameByte = lastByte == TELEMETRY_PREFIX && data == TELEMETRY_CURSOR ? 0x00 : frameByte + 0x01;
+    lastByte = data;
+    if (loseByte == 0x01 && frameByte == LOOPBACK_LOST_BYTE) {
+        loseByte = 0x00;
+        return;
+    }
+
+    telemetryReceive(&telemetry, data);
+}
+
+//Non-zero if the decoded causes match the panel
+static unsigned char causesMatch(void) {
+    return telemetry.knownCauses == 0x1F && telemetry.causes[0x00] == generalAlarmCause && telemetry.causes[0x01] == preAlarmCause && telemetry.causes[0x02] == slcTroubleCause &&
+           telemetry.causes[0x03] == nacTroubleCause && telemetry.causes[0x04] == generalTroubleCause;
+}
+
+//Channels the panel sends readings for, only the ones in its ADC scan
+static unsigned short scannedChannels(void) {
+    unsigned short channels = 0x00;
+    unsigned char channel;
+
+    for (channel = 0x00; channel < TELEMETRY_CHANNEL_COUNT; channel++) {
+        if (channelLimitSlot[channel] != 0xFF) {
+            channels |= 0x01 << channel;
+        }
+    }
+
+    return channels;
+}
+
+//Number of known readings that don't match what the panel last sent, a delta applied wrong shows up here
+static unsigned char readingMismatches(void) {
+    unsigned char mismatches = 0x00;
+    unsigned char channel;
+
+    for (channel = 0x00; channel < TELEMETRY_CHANNEL_COUNT; channel++) {
+        if ((telemetry.knownChannels & (0x01 << channel)) != 0x00 && (channelLimitSlot[channel] == 0xFF || telemetry.readings[channel] != telemetryLevels[channelLimitSlot[channel]])) {
+            mismatches++;
+        }
+    }
+
+    return mismatches;
+}
+
+//Check the status LCD was left alone by the frames and end the test
+static void finish(void) {
+    char detail[0x80];
+    const char *status = harnessLcdLine(0x00);
+    const char *zones = harnessLcdLine(0x01);
+    unsigned char printable = 0x01;
+    unsigned char i;
+
+    for (i = 0x00; i < HARNESS_LCD_COLUMNS; i++) {
+        if (status[i] < 0x20 || status[i] > 0x7E || zones[i] < 0x20 || zones[i] > 0x7E) {
+            printable = 0x00;
+        }
+    }
+
+    snprintf(detail, sizeof(detail), "\"%s\" / \"%s\"", status, zones);
+    failed |= harnessCheck("status LCD", printable == 0x01 && strncmp(status, "GENERAL ALARM", 0x0D) == 0x00, detail);
+
+    printf("%lu frames, %lu heartbeats, %lu bytes, %lu lost, %lu damaged, LCD task worst case %u cycles\n%s\n", telemetry.frames, telemetry.heartbeats, telemetry.bytes, telemetry.lost, telemetry.damaged,
+           taskWorstCase[0x03], failed == 0x00 ? "PASS" : "FAIL");
+    fflush(stdout);
+    _exit(failed);
+}
+
+//Observer running the test, lets the panel settle, measures the idle link, changes a few readings, brings in an alarm and loses a frame
+static void loopbackObserver(void) {
+    unsigned long long now = simNanoseconds();
+    char detail[0x80];
+
+    if (alarmLatchedAt == 0x00 && generalAlarmCause != 0x00) {
+        alarmLatchedAt = now;
+    }
+
+    switch (step) {
+        case 0x00:
+            //The first frame is a heartbeat, so every cause is known once the panel has settled
+            if (now >= LOOPBACK_SETTLE_NS) {
+                snprintf(detail, sizeof(detail), "%lu frames, causes %s, %u readings off", telemetry.frames, causesMatch() == 0x01 ? "match" : "don't match", readingMismatches());
+                failed |= harnessCheck("first frames", telemetry.synced == 0x01 && causesMatch() == 0x01 && readingMismatches() == 0x00, detail);
+
+                idleBytes = telemetry.bytes;
+                idleFrames = telemetry.frames;
+                idleHeartbeats = telemetry.heartbeats;
+                stepAt = now;
+                step++;
+            }
+            break;
+
+        case 0x01:
+            //Nothing changes, so only heartbeats go out and they send every reading whole in turn
+            if (now - stepAt >= LOOPBACK_IDLE_NS) {
+                unsigned char channel;
+                unsigned char exact = 0x01;
+
+                for (channel = 0x00; channel < TELEMETRY_CHANNEL_COUNT; channel++) {
+                    if (channelLimitSlot[channel] != 0xFF && telemetry.readings[channel] != channelLevels[channelLimitSlot[channel]]) {
+                        exact = 0x00;
+                    }
+                }
+
+                snprintf(detail, sizeof(detail), "%.1f bytes/s, %lu heartbeats, %lu other frames, readings %s", (telemetry.bytes - idleBytes) / (LOOPBACK_IDLE_NS / 1000000000.0),
+                         telemetry.heartbeats - idleHeartbeats, telemetry.frames - idleFrames - (telemetry.heartbeats - idleHeartbeats),
+                         telemetry.knownChannels == scannedChannels() && exact == 0x01 ? "all known" : "not all known");
+                failed |= harnessCheck("idle link", telemetry.frames - idleFrames == telemetry.heartbeats - idleHeartbeats && telemetry.knownChannels == scannedChannels() && exact == 0x01, detail);
+
+                simSetAnalogInput(LOOPBACK_DELTA_CHANNEL, LOOPBACK_DELTA_READING);
+                simSetAnalogInput(LOOPBACK_WHOLE_CHANNEL, LOOPBACK_WHOLE_READING);
+                stepAt = now;
+                step++;
+            }
+            break;
+
+        case 0x02:
+            if (telemetry.readings[LOOPBACK_DELTA_CHANNEL] == LOOPBACK_DELTA_READING >> 0x02 && telemetry.readings[LOOPBACK_WHOLE_CHANNEL] == LOOPBACK_WHOLE_READING >> 0x02) {
+                snprintf(detail, sizeof(detail), "SLC3 change and whole battery reading decoded after %.1f ms", (now - stepAt) / 1000000.0);
+                failed |= harnessCheck("reading change", now - stepAt <= LOOPBACK_CHANGE_BUDGET_NS, detail);
+
+                simSetAnalogInput(HARNESS_SLC_CHANNEL(0x00), HARNESS_SLC_ALARM);
+                stepAt = now;
+                step++;
+            }
+            break;
+
+        case 0x03:
+            if (generalAlarmCause != 0x00 && causesMatch() == 0x01) {
+                snprintf(detail, sizeof(detail), "decoded %.1f ms after the panel latched it", (now - alarmLatchedAt) / 1000000.0);
+                failed |= harnessCheck("general alarm", now - alarmLatchedAt <= LOOPBACK_CHANGE_BUDGET_NS, detail);
+
+                lostBefore = telemetry.lost;
+                loseByte = 0x01;
+                stepAt = now;
+                step++;
+            }
+            break;
+
+        case 0x04:
+            //The frame after the damaged one shows the gap and every reading becomes unknown
+            if (telemetry.lost > lostBefore) {
+                lostAt = now;
+                step++;
+            }
+            break;
+
+        case 0x05:
+            if (telemetry.knownChannels == scannedChannels()) {
+                snprintf(detail, sizeof(detail), "%lu damaged, spotted %.1f ms later, every reading known again after %.1f s, %u readings off", telemetry.damaged, (lostAt - stepAt) / 1000000.0,
+                         (now - lostAt) / 1000000000.0, readingMismatches());
+                failed |= harnessCheck("lost frame", telemetry.damaged != 0x00 && now - lostAt <= LOOPBACK_RECOVER_BUDGET_NS && readingMismatches() == 0x00 && causesMatch() == 0x01, detail);
+                finish();
+            }
+            break;
+    }
+
+    if (now > LOOPBACK_TIMEOUT_NS) {
+        printf("Test never finished, stuck at step %u\nFAIL\n", step);
+        fflush(stdout);
+        _exit(0x01);
+    }
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, runs the test on the simulated panel, the observer ends the program
+int main(void) {
+    printf("Telemetry loopback, frames decoded from the EUSART along with the status LCD\n");
+    printf("check               result  detail\n");
+    fflush(stdout);
+
+    telemetryStart(&telemetry);
+    harnessPowerUp();
+    simSetTransmitter(loopbackReceive);
+    simSetObserver(loopbackObserver);
+    firmwareMain();
+    return 0x03;
+}
@@ -0,0 +1,431 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Panel network test, runs several panels side by side on a virtual   *
+ *  RS-485 bus, measures the load the messages put on the bus and the   *
+ *  interrupts, and how long an alarm takes to sound every other panel  *
+ ************************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Timing, in nanoseconds of simulated time
+#define NETWORK_QUANTUM_NS 250000ULL           //Time every panel runs for before they all wait for each other and exchange the bytes on the bus
+#define NETWORK_SETTLE_NS 2000000000ULL        //Time the panels are left to settle after power up
+#define NETWORK_WINDOW_NS 4000000000ULL        //Time the bus is measured over, while idle and again while in alarm
+#define NETWORK_ALARM_BUDGET_NS 1000000000ULL  //Longest an alarm on the first panel may take to sound the NAC's of every other panel
+
+//Panels
+#define NETWORK_MAX_PANELS 0x08           //Most panels on the bus
+#define NETWORK_MAX_BYTES 0x1000          //Most bytes a panel may send over the whole test
+#define NETWORK_OSCILLATOR_SPREAD 0x0FA0  //Difference between the oscillator errors of neighbouring panels in parts per million, the internal RC-Oscillator is good to about 1%
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Defined in Main.c
+extern unsigned char peerAlarmCause;
+
+//Byte sent onto the bus
+struct busByte {
+    unsigned long long start;  //Time the start bit went out
+    unsigned long long end;    //Time the stop bit finished, when the receivers get the byte
+    unsigned char data;        //Byte sent
+};
+
+//What a panel did over a measurement window
+struct window {
+    unsigned long long isrCycles;  //Instruction cycles spent in the interrupts
+    unsigned long long cycles;     //Instruction cycles run
+    unsigned long long loneCycles; //Instruction cycles spent in the runs of the interrupts taken for a received byte alone
+    unsigned long lone;            //Runs of the interrupts taken for a received byte alone
+    unsigned long sent;            //Bytes sent onto the bus
+    unsigned long heard;           //Bytes received off the bus
+    unsigned long collided;        //Bytes sent that overlapped a byte from another panel
+};
+
+//Panel on the bus, shared between every panel process
+struct panel {
+    struct busByte bytes[NETWORK_MAX_BYTES];  //Bytes sent onto the bus, in order
+    unsigned long count;                      //Bytes sent onto the bus, written last so the other panels only ever see whole bytes
+    unsigned long heard;                      //Bytes received off the bus
+    unsigned long collided;                   //Bytes sent that overlapped a byte from another panel
+    unsigned long long nacsAt;                //Time the NAC's came on, 0 if they haven't
+    unsigned char falseAlarm;                 //Set if the panel went into alarm over the network while every panel was idle
+    unsigned char passedOn;                   //Set if the panel sent an alarm that came in over the network
+    struct window idle;                       //Measurement while every panel is idle
+    struct window alarm;                      //Measurement while the first panel is in alarm
+};
+
+//Bus shared between every panel process
+struct bus {
+    pthread_barrier_t barrier;               //Every panel waits here at the end of each quantum
+    unsigned char panels;                    //Panels on the bus
+    unsigned long long alarmAt;              //Time the alarm reading was put on SLC1 of the first panel
+    unsigned long long byteTime;             //Time a byte takes on the bus
+    struct panel panel[NETWORK_MAX_PANELS];  //Every panel on the bus
+};
+
+static struct bus *bus = 0;                        //Bus in memory shared with every panel process
+static struct panel *self = 0;                     //Panel this process runs
+static unsigned char selfIndex = 0x00;             //Index of the panel this process runs
+static unsigned long long nextQuantum = NETWORK_QUANTUM_NS;  //Time the panel waits for the others next
+static unsigned long long byteTime = 0x00;         //Time a byte takes on the bus
+static unsigned long delivered[NETWORK_MAX_PANELS];  //Bytes from each panel dealt with so far
+static unsigned long long lastHeardEnd = 0x00;     //End of the last byte received, a byte starting before it was part of the same garbled byte
+static unsigned long checked = 0x00;               //Own bytes checked for collisions so far
+static unsigned char messageByte = 0x00;           //Bytes of a message sent so far, 0 while waiting for the command prefix
+static unsigned char step = 0x00;                  //Step of the test the panel is on
+static struct window start;                        //Readings at the start of the window being measured
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Put every byte the EUSART sends into the status LCD, and onto the bus while the driver of the transceiver is on
+static void networkTransmit(unsigned char data) {
+    unsigned long long now = simNanoseconds();
+
+    harnessLcdReceive(data);
+
+    if ((simPeek(SIM_PORTC) & 0x01) == 0x01 && self->count < NETWORK_MAX_BYTES) {
+        //Bytes sent back to back follow straight on from each other, whatever the rounding of the byte time
+        self->bytes[self->count].start = self->count != 0x00 && self->bytes[self->count - 0x01].end > now - byteTime ? self->bytes[self->count - 0x01].end : now - byteTime;
+        self->bytes[self->count].end = now;
+        self->bytes[self->count].data = data;
+        __atomic_store_n(&self->count, self->count + 0x01, __ATOMIC_RELEASE);
+
+        //Only the panel where the alarm started may send it, an alarm that came in over the network is never passed on
+        if (messageByte == 0x02) {
+            self->passedOn |= (data & 0x01) == 0x01 && generalAlarmCause == 0x00;
+            messageByte = 0x00;
+        } else {
+            messageByte = data == 0xFE ? 0x01 : messageByte == 0x01 && data == 0xA0 ? 0x02 : 0x00;
+        }
+    }
+}
+
+//Find a byte sent by a panel that overlaps the given time, returns 0 if there isn't one
+static struct busByte *overlapping(unsigned char panel, unsigned long long from, unsigned long long to) {
+    struct panel *sender = &bus->panel[panel];
+    unsigned long i;
+
+    for (i = __atomic_load_n(&sender->count, __ATOMIC_ACQUIRE); i-- != 0x00 && sender->bytes[i].end > from;) {
+        if (sender->bytes[i].start < to) {
+            return &sender->bytes[i];
+        }
+    }
+
+    return 0;
+}
+
+//Hand over every byte from the other panels that nothing can overlap anymore, a byte is only known to be clean once every byte that may overlap it has ended
+//The receiver is off while the panel sends, and bytes from several panels that overlap reach the receiver as a single garbled byte
+static void deliverBytes(unsigned long long now) {
+    unsigned char panel;
+
+    for (;;) {
+        struct busByte *next = 0;
+        unsigned char from = 0x00;
+        unsigned char data;
+        unsigned long long end;
+
+        //Pick the byte that ended first among those old enough
+        for (panel = 0x00; panel < bus->panels; panel++) {
+            struct panel *sender = &bus->panel[panel];
+
+            if (panel != selfIndex && delivered[panel] < __atomic_load_n(&sender->count, __ATOMIC_ACQUIRE) && sender->bytes[delivered[panel]].end + byteTime <= now &&
+                (next == 0 || sender->bytes[delivered[panel]].end < next->end)) {
+                next = &sender->bytes[delivered[panel]];
+                from = panel;
+            }
+        }
+
+        if (next == 0) {
+            break;
+        }
+        delivered[from]++;
+
+        //A byte that started before the last one received ended was part of it, and a byte sent while the panel was sending itself is never heard
+        if (next->start < lastHeardEnd || overlapping(selfIndex, next->start, next->end) != 0) {
+            continue;
+        }
+
+        //Every other byte overlapping this one garbles it, the line is pulled low by any driver sending a 0
+        data = next->data;
+        end = next->end;
+        for (panel = 0x00; panel < bus->panels; panel++) {
+            struct busByte *other = panel != from ? overlapping(panel, next->start, next->end) : 0;
+
+            if (other != 0) {
+                data &= other->data;
+                end = other->end > end ? other->end : end;
+            }
+        }
+
+        lastHeardEnd = end;
+        self->heard++;
+        simReceive(data);
+    }
+
+    //Count the bytes the panel sent that overlapped a byte from another panel
+    while (checked < self->count && self->bytes[checked].end + byteTime <= now) {
+        for (panel = 0x00; panel < bus->panels; panel++) {
+            if (panel != selfIndex && overlapping(panel, self->bytes[checked].start, self->bytes[checked].end) != 0) {
+                self->collided++;
+                break;
+            }
+        }
+        checked++;
+    }
+}
+
+//Take the readings a measurement window starts from, or the difference from them once it ends
+static void takeWindow(struct window *window) {
+    window->isrCycles = simIsrCycles() - window->isrCycles;
+    window->cycles = simCycles() - window->cycles;
+    window->loneCycles = simReceiveIsrCycles() - window->loneCycles;
+    window->lone = simReceiveIsrs() - window->lone;
+    window->sent = self->count - window->sent;
+    window->heard = self->heard - window->heard;
+    window->collided = self->collided - window->collided;
+}
+
+//Observer running every panel, keeps the panels in step a quantum at a time, moves the bytes between them and brings in an alarm on the first panel
+static void networkObserver(void) {
+    unsigned long long now = simNanoseconds();
+
+    if (self->nacsAt == 0x00 && (LATA & 0xF0) != 0x00) {
+        self->nacsAt = now;
+    }
+
+    if (now < nextQuantum) {
+        return;
+    }
+    nextQuantum += NETWORK_QUANTUM_NS;
+
+    //Wait for every other panel to finish the quantum, so every byte that ended in it is on the bus
+    byteTime = SIM_EUSART_BITS_PER_BYTE * 1000000000ULL / simEusartBaud();
+    pthread_barrier_wait(&bus->barrier);
+    deliverBytes(now);
+
+    switch (step) {
+        case 0x00:
+            if (now >= NETWORK_SETTLE_NS) {
+                memset(&start, 0x00, sizeof(start));
+                takeWindow(&start);
+                step++;
+            }
+            break;
+
+        case 0x01:
+            //Every panel is idle, so none of them should have gone into alarm, then the first panel gets an alarm on SLC1
+            if (now >= NETWORK_SETTLE_NS + NETWORK_WINDOW_NS) {
+                takeWindow(&start);
+                self->idle = start;
+                self->falseAlarm = (generalAlarmCause | peerAlarmCause) != 0x00;
+
+                if (selfIndex == 0x00) {
+                    simSetAnalogInput(HARNESS_SLC_CHANNEL(0x00), HARNESS_SLC_ALARM);
+                    bus->alarmAt = now;  //Every NAC is timed from the reading, the scan and the verification of the first panel included
+                }
+                memset(&start, 0x00, sizeof(start));
+                takeWindow(&start);
+                step++;
+            }
+            break;
+
+        case 0x02:
+            if (now >= NETWORK_SETTLE_NS + NETWORK_WINDOW_NS * 0x02) {
+                takeWindow(&start);
+                self->alarm = start;
+                bus->byteTime = byteTime;
+                _exit(0x00);
+            }
+            break;
+    }
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Run a panel in a process of its own, so every panel has its own copy of the firmware globals, the observer ends the process
+static void runPanel(unsigned char index) {
+    selfIndex = index;
+    self = &bus->panel[index];
+
+    harnessPowerUp();
+    simSetOscillatorError(((long) index * 0x02 - (bus->panels - 0x01)) * NETWORK_OSCILLATOR_SPREAD / 0x02);
+    simSetTransmitter(networkTransmit);
+    simSetObserver(networkObserver);
+    firmwareMain();
+    _exit(0x03);
+}
+
+//Main Function, runs the network with more and more panels on the bus and prints how it scales
+int main(int argc, char **argv) {
+    unsigned long maxPanels = NETWORK_MAX_PANELS;  //Most panels to run on the bus, the count doubles from a single panel up to it
+    unsigned char failed = 0x00;
+    unsigned char panels;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:")) != -1) {
+        switch (option) {
+            case 'n':
+                maxPanels = strtoul(optarg, 0, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n most panels, up to %u]\n", argv[0x00], NETWORK_MAX_PANELS);
+                return 0x02;
+        }
+    }
+
+    if (maxPanels == 0x00 || maxPanels > NETWORK_MAX_PANELS) {
+        fprintf(stderr, "Between 1 and %u panels can be run\n", NETWORK_MAX_PANELS);
+        return 0x02;
+    }
+
+    bus = mmap(0, sizeof(*bus), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0x00);
+    if (bus == MAP_FAILED) {
+        return 0x02;
+    }
+
+    printf("Panel network, panels on a virtual RS-485 bus, %.1f s idle then %.1f s with an alarm on the first panel\n", NETWORK_WINDOW_NS / 1000000000.0, NETWORK_WINDOW_NS / 1000000000.0);
+    printf("panels  idle bytes/s  idle bus %%  alarm bytes/s  alarm bus %%  collided  idle ISR %%  bus ISR %%  ISR cycles/byte  local NAC ms  worst remote NAC ms\n");
+    fflush(stdout);
+
+    for (panels = 0x01; panels <= maxPanels; panels *= 0x02) {
+        pthread_barrierattr_t attributes;
+        unsigned long long worstRemote = 0x00;
+        unsigned long idleSent = 0x00;
+        unsigned long alarmSent = 0x00;
+        unsigned long heard = 0x00;
+        unsigned long collided = 0x00;
+        unsigned char falseAlarms = 0x00;
+        unsigned char passedOn = 0x00;
+        unsigned char missed = 0x00;
+        double idleShare = 0.0;
+        double busShare = 0.0;
+        double byteCycles = 0.0;
+        double worstLeft = 0.0;
+        unsigned long long loneCycles = 0x00;
+        unsigned long lone = 0x00;
+        unsigned char crashed = 0x00;
+        unsigned char panel;
+        char detail[0x80];
+        int status;
+
+        memset(bus, 0x00, sizeof(*bus));
+        bus->panels = panels;
+        pthread_barrierattr_init(&attributes);
+        pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_barrier_init(&bus->barrier, &attributes, panels);
+
+        for (panel = 0x00; panel < panels; panel++) {
+            pid_t child = fork();
+
+            if (child == 0x00) {
+                runPanel(panel);
+            }
+            if (child < 0x00) {
+                return 0x02;
+            }
+        }
+        for (panel = 0x00; panel < panels; panel++) {
+            if (wait(&status) < 0x00 || !WIFEXITED(status) || WEXITSTATUS(status) != 0x00) {
+                crashed = 0x01;
+            }
+        }
+        pthread_barrier_destroy(&bus->barrier);
+        pthread_barrierattr_destroy(&attributes);
+
+        if (crashed == 0x01) {
+            printf("%6u  a panel failed to run\nFAIL\n", panels);
+            return 0x01;
+        }
+
+        for (panel = 0x00; panel < panels; panel++) {
+            struct panel *current = &bus->panel[panel];
+
+            idleSent += current->idle.sent;
+            alarmSent += current->alarm.sent;
+            heard += current->idle.heard;
+            collided += current->idle.collided + current->alarm.collided;
+            idleShare += (double) current->idle.isrCycles / current->idle.cycles / panels;
+            loneCycles += current->idle.loneCycles;
+            lone += current->idle.lone;
+            falseAlarms += current->falseAlarm;
+            passedOn += current->passedOn;
+
+            if (panel != 0x00) {
+                if (current->nacsAt == 0x00 || current->nacsAt < bus->alarmAt) {
+                    missed++;
+                } else if (current->nacsAt - bus->alarmAt > worstRemote) {
+                    worstRemote = current->nacsAt - bus->alarmAt;
+                }
+            }
+        }
+
+        //Every byte heard is charged what an interrupt taken for a received byte alone costs, the most a byte can cost, as most bytes come in while the interrupt is already running for the scan
+        if (lone != 0x00) {
+            byteCycles = (double) loneCycles / lone;
+        }
+        for (panel = 0x00; panel < panels; panel++) {
+            struct panel *current = &bus->panel[panel];
+            double left = (double) current->idle.isrCycles - byteCycles * current->idle.heard;
+
+            busShare += byteCycles * current->idle.heard / current->idle.cycles / panels;
+            worstLeft = left < worstLeft ? left : worstLeft;
+        }
+
+        printf("%6u  %12.1f  %10.2f  %13.1f  %11.2f  %8lu  %10.3f  %9.3f  ", panels, idleSent / (NETWORK_WINDOW_NS / 1000000000.0), idleSent * 100.0 * bus->byteTime / NETWORK_WINDOW_NS,
+               alarmSent / (NETWORK_WINDOW_NS / 1000000000.0), alarmSent * 100.0 * bus->byteTime / NETWORK_WINDOW_NS, collided, idleShare * 100.0, busShare * 100.0);
+        if (lone != 0x00) {
+            printf("%15.1f", byteCycles);
+        } else {
+            printf("%15s", "-");
+        }
+        printf("  %12.1f  ", (bus->panel[0x00].nacsAt - bus->alarmAt) / 1000000.0);
+        if (panels == 0x01) {
+            printf("%19s\n", "-");
+        } else {
+            printf("%19.1f\n", worstRemote / 1000000.0);
+        }
+
+        //The bytes heard can never cost more than every cycle the interrupts ran for, a negative remainder means the cost per byte is wrong
+        if (worstLeft < 0.0) {
+            snprintf(detail, sizeof(detail), "%lu bytes at %.1f cycles each cost %.0f cycles more than the interrupts ran for", heard, byteCycles, -worstLeft);
+            printf("%6u  ", panels);
+            failed |= harnessCheck("bus overhead", 0x00, detail);
+        }
+
+        //An idle network must never sound an alarm, and only the panel where the alarm started may send it
+        if (falseAlarms != 0x00 || passedOn != 0x00) {
+            snprintf(detail, sizeof(detail), "%u panels went into alarm while idle, %u passed on an alarm from the network", falseAlarms, passedOn);
+            printf("%6u  ", panels);
+            failed |= harnessCheck("no false alarm", 0x00, detail);
+        }
+        if (missed != 0x00 || worstRemote > NETWORK_ALARM_BUDGET_NS) {
+            snprintf(detail, sizeof(detail), "%u panels never sounded, worst %.1f ms against a budget of %.1f ms", missed, worstRemote / 1000000.0, NETWORK_ALARM_BUDGET_NS / 1000000.0);
+            printf("%6u  ", panels);
+            failed |= harnessCheck("alarm propagation", 0x00, detail);
+        }
+        fflush(stdout);
+    }
+
+    printf("%s\n", failed == 0x00 ? "PASS" : "FAIL");
+    return failed;
+}
@@ -0,0 +1,233 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Noisy waveform test, checks that transient spikes on the SLC's are  *
+ *  rejected and that a real but noisy alarm is still confirmed in time *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+#define NOISE_TRANSIENT_CYCLES 0x400000ULL  //Cycles each SLC is fed transient spikes for
+#define NOISE_SPIKE_MIN_CYCLES 0x14         //Shortest transient spike
+#define NOISE_SPIKE_MAX_CYCLES 0x05DC       //Longest transient spike, shorter than the time between two readings of an SLC so a spike lands on one reading at most
+#define NOISE_GAP_MIN_CYCLES 0x0E00         //Shortest quiet time between two spikes, a little over two readings of an SLC
+#define NOISE_GAP_MAX_CYCLES 0x8000         //Longest quiet time between two spikes
+#define NOISE_JITTER 0x80                   //Largest amount a normal reading wanders away from its nominal value
+#define NOISE_JITTER_CYCLES 0xC8            //Cycles between changes of the jitter on a normal reading
+#define NOISE_DROPOUT_PERCENT 0x19          //Chance of each reading of a real alarm dropping back to a normal reading, with nothing keeping the dropouts apart
+#define NOISE_VERIFY_WINDOW 0x04            //Readings in the alarm history of a channel, VERIFY_WINDOW in Main.c
+#define NOISE_CONFIRM_READINGS 0x02         //Readings of the SLC the panel may take past the one that completes N of the last M before the alarm has to be latched, the sweep has to end and the alarm task run
+
+/***************
+ *  Variables  *
+ ***************/
+
+static unsigned long long randomState = 0x00;      //State of the pseudo random generator, seeded differently for every run
+static unsigned char slc = 0x00;                   //SLC the waveform is fed into
+static unsigned long long injectAt = 0x00;         //Cycle the real alarm starts at
+static unsigned long long injectedNanoseconds = 0x00;  //Simulated time the real alarm started at
+static unsigned long long nextEvent = 0x00;        //Cycle the waveform changes next
+static unsigned long long nextJitter = 0x00;       //Cycle the jitter on the other SLC's changes next
+static unsigned char spikeActive = 0x00;           //Set while a transient spike is being applied
+static unsigned long lastConversions = 0x00;       //ADC conversions completed on the SLC when the observer last looked
+static unsigned long readingsTaken = 0x00;         //Readings of the SLC taken since the real alarm started
+static unsigned char alarmHistory = 0x00;          //Whether each of the last readings of the SLC was fed an alarm, first bit is the newest
+static unsigned long boundReading = 0x00;          //Reading that first completed N alarms out of the last M, the alarm has to be latched soon after it, 0 until then
+static unsigned char alarmStarted = 0x00;          //Set once the real alarm has started
+static unsigned char alarmFed = 0x00;              //Set if the reading being fed into the SLC is the alarm rather than a dropout
+static unsigned long long spikes = 0x00;           //Number of transient spikes applied so far
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Jitter the normal readings of every SLC the waveform is not being fed into
+static void jitterOtherSLCs(void) {
+    unsigned char i;
+
+    if (simCycles() < nextJitter) {
+        return;
+    }
+    nextJitter = simCycles() + NOISE_JITTER_CYCLES;
+
+    for (i = 0x00; i < HARNESS_SLC_COUNT; i++) {
+        if (i != slc) {
+            simSetAnalogInput(HARNESS_SLC_CHANNEL(i), HARNESS_SLC_NORMAL - NOISE_JITTER + harnessRandomBetween(&randomState, 0x00, NOISE_JITTER * 0x02));
+        }
+    }
+}
+
+//Observer feeding isolated transient spikes into an SLC on top of a jittery normal reading, the panel must never go into alarm
+static void transientObserver(void) {
+    jitterOtherSLCs();
+
+    if (generalAlarmCause != 0x00) {
+        harnessFinish(0x01, spikes, 0x00, 0x00);
+    }
+    if (simCycles() >= NOISE_TRANSIENT_CYCLES) {
+        harnessFinish(0x00, spikes, 0x00, 0x00);
+    }
+
+    if (simCycles() < nextEvent) {
+        return;
+    }
+
+    //Toggle between a spike and a quiet jittery normal reading
+    if (spikeActive == 0x00) {
+        simSetAnalogInput(HARNESS_SLC_CHANNEL(slc), HARNESS_SLC_ALARM);
+        nextEvent = simCycles() + harnessRandomBetween(&randomState, NOISE_SPIKE_MIN_CYCLES, NOISE_SPIKE_MAX_CYCLES);
+        spikeActive = 0x01;
+        spikes++;
+    } else {
+        simSetAnalogInput(HARNESS_SLC_CHANNEL(slc), HARNESS_SLC_NORMAL - NOISE_JITTER + harnessRandomBetween(&randomState, 0x00, NOISE_JITTER * 0x02));
+        nextEvent = simCycles() + harnessRandomBetween(&randomState, NOISE_GAP_MIN_CYCLES, NOISE_GAP_MAX_CYCLES);
+        spikeActive = 0x00;
+    }
+}
+
+//Feed the next reading of a real alarm into the SLC, either the alarm or a dropout back to the normal reading
+static void feedAlarmReading(void) {
+    alarmFed = harnessRandomBetween(&randomState, 0x00, 0x63) >= NOISE_DROPOUT_PERCENT;
+    simSetAnalogInput(HARNESS_SLC_CHANNEL(slc), alarmFed == 0x01 ? HARNESS_SLC_ALARM : HARNESS_SLC_NORMAL);
+}
+
+//Observer feeding a real alarm with random dropouts into an SLC reading by reading, the panel must latch the alarm within a couple of readings of N of the last M readings being alarms, and not before
+static void noisyAlarmObserver(void) {
+    unsigned long conversions = simAdcConversions(HARNESS_SLC_CHANNEL(slc));
+    unsigned char count = 0x00;
+    unsigned char i;
+
+    jitterOtherSLCs();
+
+    //Start the alarm straight after a reading of the SLC, so every reading taken from then on was fed by the observer
+    if (alarmStarted == 0x00) {
+        if (simCycles() >= injectAt && conversions != lastConversions) {
+            injectedNanoseconds = simNanoseconds();
+            alarmStarted = 0x01;
+            feedAlarmReading();
+        }
+        lastConversions = conversions;
+        return;
+    }
+
+    if ((generalAlarmCause & (0x01 << slc)) != 0x00) {
+        harnessFinish(boundReading == 0x00, simNanoseconds() - injectedNanoseconds, boundReading == 0x00 ? 0x00 : readingsTaken - boundReading, 0x00);
+    }
+    if (boundReading != 0x00 && readingsTaken > boundReading + NOISE_CONFIRM_READINGS) {
+        harnessFinish(0x01, simNanoseconds() - injectedNanoseconds, readingsTaken - boundReading, 0x00);
+    }
+    if (simCycles() - injectAt > HARNESS_TIMEOUT_CYCLES) {
+        harnessFinish(0x01, ~0ULL, 0x00, 0x00);
+    }
+
+    //Keep track of which readings were fed an alarm, the bound on the confirmation starts once N of the last M were
+    if (conversions != lastConversions) {
+        lastConversions = conversions;
+        readingsTaken++;
+        alarmHistory = (alarmHistory << 0x01) | alarmFed;
+
+        for (i = 0x00; i < NOISE_VERIFY_WINDOW; i++) {
+            count += (alarmHistory >> i) & 0x01;
+        }
+        if (boundReading == 0x00 && count >= (channelVerifyCount[HARNESS_SLC_CHANNEL(slc)] & 0x0F)) {
+            boundReading = readingsTaken;
+        }
+
+        feedAlarmReading();
+    }
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, runs both waveforms on every SLC and returns non-zero if the firmware misbehaved on any of them
+int main(int argc, char **argv) {
+    unsigned long trials = 0x10;  //Number of noisy alarms fed into each SLC
+    unsigned long long result[HARNESS_RESULT_COUNT];
+    unsigned long long *samples;
+    unsigned char failed = 0x00;
+    unsigned long trial;
+    int option;
+
+    while ((option = getopt(argc, argv, "t:")) != -1) {
+        switch (option) {
+            case 't':
+                trials = strtoul(optarg, 0, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-t trials]\n", argv[0x00]);
+                return 0x02;
+        }
+    }
+
+    if (trials == 0x00) {
+        trials = 0x01;
+    }
+
+    samples = malloc(trials * sizeof(*samples));
+    if (samples == 0) {
+        return 0x02;
+    }
+
+    //Transient spikes must never put the panel into alarm
+    printf("Transient rejection, %llu cycles per SLC\n", NOISE_TRANSIENT_CYCLES);
+    printf("SLC  spikes  result\n");
+    for (slc = 0x00; slc < HARNESS_SLC_COUNT; slc++) {
+        randomState = 0x9E3779B97F4A7C15ULL + slc;
+        nextEvent = HARNESS_WARMUP_CYCLES;
+
+        if (harnessRun(transientObserver, result) != 0x00) {
+            fprintf(stderr, "Transient run on SLC%u failed to run\n", slc + 0x01);
+            return 0x02;
+        }
+
+        printf("%3u  %6llu  %s\n", slc + 0x01, result[0x01], result[0x00] == 0x00 ? "pass" : "FAIL, alarm latched");
+        failed |= result[0x00] != 0x00;
+    }
+
+    //Real alarms must be confirmed through the dropouts as soon as N of the last M readings were alarms
+    printf("\nNoisy alarm confirmation, %lu trials per SLC, %u%% of readings dropped out, latched within %u readings of %u of %u readings being alarms\n", trials, NOISE_DROPOUT_PERCENT,
+           NOISE_CONFIRM_READINGS, channelVerifyCount[HARNESS_SLC_CHANNEL(0x00)] & 0x0F, NOISE_VERIFY_WINDOW);
+    printf("SLC  median ms  worst ms  worst readings past  result\n");
+    for (slc = 0x00; slc < HARNESS_SLC_COUNT; slc++) {
+        unsigned char slcFailed = 0x00;
+        unsigned long long pastBound = 0x00;
+
+        for (trial = 0x00; trial < trials; trial++) {
+            randomState = 0xD1B54A32D192ED03ULL + slc * 0x10000ULL + trial;
+            injectAt = HARNESS_WARMUP_CYCLES + harnessRandomBetween(&randomState, 0x00, 0x10000);
+            alarmStarted = 0x00;
+            lastConversions = 0x00;
+            readingsTaken = 0x00;
+            alarmHistory = 0x00;
+            boundReading = 0x00;
+
+            if (harnessRun(noisyAlarmObserver, result) != 0x00) {
+                fprintf(stderr, "Noisy alarm run on SLC%u failed to run\n", slc + 0x01);
+                return 0x02;
+            }
+
+            samples[trial] = result[0x01];
+            slcFailed |= result[0x00] != 0x00;
+            if (result[0x02] > pastBound) {
+                pastBound = result[0x02];
+            }
+        }
+
+        qsort(samples, trials, sizeof(*samples), harnessCompareSamples);
+        printf("%3u  %9.3f  %8.3f  %19llu  %s\n", slc + 0x01, samples[trials / 0x02] / 1000000.0, samples[trials - 0x01] / 1000000.0, pastBound, slcFailed == 0x00 ? "pass" : "FAIL, latched too soon or too late");
+        failed |= slcFailed;
+    }
+
+    free(samples);
+    return failed;
+}
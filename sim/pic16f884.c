@@ -0,0 +1,723 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Simulated PIC16F884 register file and peripherals, used to run      *
+ *  Main.c natively on a Linux host for benchmarking and testing        *
+ ************************************************************************/
+
+#include "pic16f884.h"
+
+//Firmware entry point for interrupts, defined in Main.c
+void hardwareInterruptISR(void);
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Oscillator frequencies selected by the IRCF bits of OSCCON
+static const unsigned long oscillatorFrequencies[0x08] = {31000, 125000, 250000, 500000, 1000000, 2000000, 4000000, 8000000};
+
+//Register File
+static unsigned char registers[SIM_REGISTER_COUNT];  //The simulated special function registers
+static unsigned char digitalInputs[0x05];            //Logic level driven onto the pins of PORTA to PORTE by the outside world
+static unsigned char pinOutputs[0x05];               //Level last driven onto the output pins of PORTA to PORTE, used to spot changes
+static unsigned short analogInputs[SIM_ADC_CHANNEL_COUNT];  //Reading each analog channel would produce, as a 10 bit value
+static unsigned char eeprom[SIM_EEPROM_SIZE];        //The data EEPROM, starts erased and is not touched by a reset
+static unsigned char eepromBlank = 0x01;             //Set until the data EEPROM has been erased for the first time
+static unsigned short flash[SIM_FLASH_WORDS];        //Program memory, starts erased and is not touched by a reset
+static unsigned char flashBlank = 0x01;              //Set until program memory has been erased for the first time
+
+//Clock Tracking
+static unsigned long long cycleCount = 0x00;   //Instruction cycles executed since the last reset
+static unsigned long long nanoseconds = 0x00;  //Time elapsed since the last reset
+static unsigned short timer0Prescaler = 0x00;  //Instruction cycles counted by the Timer 0 prescaler
+static unsigned char timer2Prescaler = 0x00;   //Instruction cycles counted by the Timer 2 prescaler
+static unsigned char timer2Postscaler = 0x00;  //Period matches counted by the Timer 2 postscaler
+static unsigned char timer1Prescaler = 0x00;   //Instruction cycles counted by the Timer 1 prescaler
+static unsigned char clockFrozen = 0x00;       //Set while register accesses leave the clock alone, the program calls the interrupts and tasks itself
+static unsigned long nops = 0x00;              //Number of __nop() executed since the last reset
+static unsigned long long runNanoseconds[0x08];  //Time spent awake at each oscillator frequency since the last reset, indexed by the IRCF bits of OSCCON
+static unsigned long long sleepNanoseconds = 0x00;  //Time spent asleep since the last reset
+static unsigned long sleeps = 0x00;            //Number of times SLEEP put the MCU to sleep since the last reset
+static unsigned long long isrCycles = 0x00;    //Instruction cycles spent in hardwareInterruptISR() since the last reset
+static unsigned long receiveIsrs = 0x00;       //Runs of hardwareInterruptISR() taken for a received byte with no other interrupt pending since the last reset
+static unsigned long long receiveIsrCycles = 0x00;  //Instruction cycles spent in those runs since the last reset
+static long oscillatorError = 0x00;            //Error of the oscillator in parts per million, positive runs fast, not touched by a reset
+static unsigned long picoseconds = 0x00;       //Fraction of a nanosecond carried over to the next cycle while the oscillator has an error
+
+//Peripheral State
+static unsigned char adcBusy = 0x00;           //Set while a conversion is in progress
+static unsigned long adcRemaining = 0x00;      //Instruction cycles left before the conversion in progress completes
+static unsigned short adcSample = 0x00;        //Value held by the sampling capacitor for the conversion in progress
+static unsigned long adcConversions[SIM_ADC_CHANNEL_COUNT];  //Conversions completed on each channel since the last reset
+static unsigned char adcSampleChannel = 0x00;  //Channel the conversion in progress was sampled from
+static unsigned char isrActive = 0x00;         //Set while hardwareInterruptISR() is running
+static unsigned char watchdogArmed = 0x00;     //Set once the watchdog timer has timed out while the MCU was awake, the real thing would reset the MCU
+static unsigned long long watchdogNanoseconds = 0x00;  //Time the watchdog timer has been counting since it was enabled or last cleared
+static unsigned char txregWritten = 0x00;      //Set when the firmware accessed TXREG, the write lands once the access returns
+static unsigned char txregFull = 0x00;         //Set while TXREG holds a byte that has not been moved into the transmit shift register
+static unsigned char txShift = 0x00;           //Byte being sent out of the transmit shift register
+static unsigned long txRemaining = 0x00;       //Instruction cycles left before the byte in the transmit shift register has been sent
+static unsigned long txBytes = 0x00;           //Bytes sent by the EUSART since the last reset
+static unsigned char eecon2Written = 0x00;     //Set when the firmware accessed EECON2, the write lands once the access returns
+static unsigned char eepromUnlock = 0x00;      //Progress through the 0x55, 0xAA unlock sequence written to EECON2
+static unsigned long eepromRemaining = 0x00;   //Instruction cycles left before the data EEPROM write in progress completes
+static unsigned char eepromWriteAddress = 0x00;  //Address of the data EEPROM write in progress
+static unsigned char eepromWriteData = 0x00;   //Byte being written by the data EEPROM write in progress
+static unsigned long eepromWrites = 0x00;      //Data EEPROM writes completed since the last reset
+static unsigned short flashLatches[SIM_FLASH_BLOCK_WORDS];  //Words loaded into the block being written to program memory
+static unsigned short flashWriteAddress = 0x00;  //Address of the first word of the program memory block being written
+static unsigned long flashRemaining = 0x00;    //Instruction cycles left before the program memory write in progress completes, the CPU stalls till then
+static unsigned long flashWrites = 0x00;       //Program memory blocks written since the last reset
+static unsigned char rxFifo[0x02];             //Bytes waiting in the receive FIFO, the first one is read out of RCREG first
+static unsigned char rxCount = 0x00;           //Bytes waiting in the receive FIFO
+static simObserver observer = 0;               //Callback used by the harness to watch the simulation
+static simTransmitter transmitter = 0;         //Callback used by the harness to receive the bytes sent by the EUSART
+static simPinWatcher pinWatcher = 0;           //Callback used by the harness to follow the output pins, for the parts of the board outside the MCU
+
+/*************
+ *  Helpers  *
+ *************/
+
+static void step(unsigned long cycles);
+
+//Determine the number of instruction cycles a single ADC conversion takes with the current ADCON0 clock selection
+static unsigned long adcConversionCycles(void) {
+    static const unsigned char clockDividers[0x03] = {0x02, 0x08, 0x20};
+
+    //The dedicated RC-Oscillator has a TAD of roughly 4 microseconds no matter what the system clock is
+    if ((registers[SIM_ADCON0] & 0xC0) == 0xC0) {
+        return SIM_ADC_TAD_PER_CONVERSION * (oscillatorFrequencies[(registers[SIM_OSCCON] & 0x70) >> 0x04] / 1000000 + 0x01);
+    }
+
+    return (SIM_ADC_TAD_PER_CONVERSION * clockDividers[(registers[SIM_ADCON0] & 0xC0) >> 0x06] + 0x03) / 0x04;
+}
+
+//Determine the number of instruction cycles a single bit takes on the EUSART with the current baud rate generator settings
+static unsigned long eusartBitCycles(void) {
+    unsigned short generator = registers[SIM_SPBRG];
+    unsigned char divider = (registers[SIM_TXSTA] & 0x04) == 0x04 ? 0x10 : 0x40;
+
+    //The 16 bit baud rate generator uses SPBRGH as well, and divides the clock by a quarter as much
+    if ((registers[SIM_BAUDCTL] & 0x08) == 0x08) {
+        generator |= registers[SIM_SPBRGH] << 0x08;
+        divider /= 0x04;
+    }
+
+    return divider * (generator + 0x01UL) / 0x04;
+}
+
+//Determine the time a single instruction cycle takes in whole nanoseconds, an oscillator error leaves a fraction behind that is carried into the next cycle
+static unsigned long cycleNanoseconds(void) {
+    unsigned long long period = 4000000000000ULL / oscillatorFrequencies[(registers[SIM_OSCCON] & 0x70) >> 0x04];  //Cycle time in picoseconds
+
+    if (oscillatorError == 0x00) {
+        return period / 1000;
+    }
+
+    picoseconds += period * 1000000 / (1000000 + oscillatorError);
+    period = picoseconds / 1000;
+    picoseconds %= 1000;
+    return period;
+}
+
+//Determine the time the watchdog timer takes to time out with the current WDTCON pre-scale, it runs off the 31kHz LFINTOSC whatever the system clock is
+static unsigned long long watchdogPeriod(void) {
+    return (0x20ULL << ((registers[SIM_WDTCON] & 0x1E) >> 0x01)) * 1000000000ULL / 31000;
+}
+
+//Determine if any enabled interrupt has its flag set
+static unsigned char interruptPending(void) {
+    if ((registers[SIM_INTCON] & 0x20) == 0x20 && (registers[SIM_INTCON] & 0x04) == 0x04) {
+        return 0x01;
+    }
+
+    if ((registers[SIM_INTCON] & 0x40) == 0x40 && ((registers[SIM_PIR1] & registers[SIM_PIE1]) != 0x00 || (registers[SIM_PIR2] & registers[SIM_PIE2]) != 0x00)) {
+        return 0x01;
+    }
+
+    return 0x00;
+}
+
+//Advance the simulated clock by a single instruction cycle, stepping every peripheral and dispatching interrupts
+static void tick(void) {
+    //Start a conversion if the firmware has set the GO bit, or abort one if the firmware cleared it
+    if (adcBusy == 0x00 && (registers[SIM_ADCON0] & 0x03) == 0x03) {
+        adcBusy = 0x01;
+        adcRemaining = adcConversionCycles();
+        adcSampleChannel = (registers[SIM_ADCON0] & 0x3C) >> 0x02;
+        adcSample = adcSampleChannel < SIM_ADC_CHANNEL_COUNT ? analogInputs[adcSampleChannel] : 0x0000;
+    } else if (adcBusy == 0x01 && (registers[SIM_ADCON0] & 0x02) == 0x00) {
+        adcBusy = 0x00;
+    }
+
+    cycleCount++;
+    isrCycles += isrActive;
+    nanoseconds += cycleNanoseconds();
+    runNanoseconds[(registers[SIM_OSCCON] & 0x70) >> 0x04] += (4000000000ULL / oscillatorFrequencies[(registers[SIM_OSCCON] & 0x70) >> 0x04]);
+
+    //Timer 0, only clocked from the instruction clock as the T0CKI pin is not used
+    if ((registers[SIM_OPTION_REG] & 0x20) == 0x00) {
+        unsigned short prescale = (registers[SIM_OPTION_REG] & 0x08) == 0x08 ? 0x01 : 0x02 << (registers[SIM_OPTION_REG] & 0x07);
+
+        if (++timer0Prescaler >= prescale) {
+            timer0Prescaler = 0x00;
+
+            //Set the overflow flag when the timer rolls over
+            if (++registers[SIM_TMR0] == 0x00) {
+                registers[SIM_INTCON] |= 0x04;
+            }
+        }
+    }
+
+    //Timer 1, only clocked from the instruction clock as there is no crystal on the T1OSO and T1OSI pins
+    if ((registers[SIM_T1CON] & 0x03) == 0x01) {
+        if (++timer1Prescaler >= (0x01 << ((registers[SIM_T1CON] & 0x30) >> 0x04))) {
+            timer1Prescaler = 0x00;
+
+            //Carry into the high byte and set the overflow flag when the timer rolls over
+            if (++registers[SIM_TMR1L] == 0x00 && ++registers[SIM_TMR1H] == 0x00) {
+                registers[SIM_PIR1] |= 0x01;
+            }
+        }
+    }
+
+    //Timer 2, raise its flag once the postscaler has counted enough matches with PR2
+    if ((registers[SIM_T2CON] & 0x04) == 0x04) {
+        unsigned char prescale = (registers[SIM_T2CON] & 0x02) == 0x02 ? 0x10 : (registers[SIM_T2CON] & 0x01) == 0x01 ? 0x04 : 0x01;
+
+        if (++timer2Prescaler >= prescale) {
+            timer2Prescaler = 0x00;
+
+            //The timer resets on the increment after it matches PR2
+            if (registers[SIM_TMR2] == registers[SIM_PR2]) {
+                registers[SIM_TMR2] = 0x00;
+
+                if (++timer2Postscaler > ((registers[SIM_T2CON] & 0x78) >> 0x03)) {
+                    timer2Postscaler = 0x00;
+                    registers[SIM_PIR1] |= 0x02;
+                }
+            } else {
+                registers[SIM_TMR2]++;
+            }
+        }
+    }
+
+    //ADC, load the result and raise the read complete flag once the conversion is done
+    if (adcBusy == 0x01) {
+        if (--adcRemaining == 0x00) {
+            adcBusy = 0x00;
+
+            //Store the result using the justification selected by ADFM
+            if ((registers[SIM_ADCON1] & 0x80) == 0x80) {
+                registers[SIM_ADRESH] = (adcSample >> 0x08) & 0x03;
+                registers[SIM_ADRESL] = adcSample & 0xFF;
+            } else {
+                registers[SIM_ADRESH] = (adcSample >> 0x02) & 0xFF;
+                registers[SIM_ADRESL] = (adcSample & 0x03) << 0x06;
+            }
+
+            if (adcSampleChannel < SIM_ADC_CHANNEL_COUNT) {
+                adcConversions[adcSampleChannel]++;
+            }
+            registers[SIM_ADCON0] &= 0xFD;  //Clear the GO bit
+            registers[SIM_PIR1] |= 0x40;    //Set the ADC read complete flag
+        }
+    }
+
+    //EUSART, a write to TXREG fills it and clears the transmit flag until the byte moves into the transmit shift register
+    if (txregWritten == 0x01) {
+        txregWritten = 0x00;
+        txregFull = 0x01;
+    }
+
+    //Send out the byte in the transmit shift register one bit time at a time
+    if (txRemaining != 0x00 && --txRemaining == 0x00) {
+        txBytes++;
+        if (transmitter != 0) {
+            transmitter(txShift);
+        }
+    }
+
+    //Move TXREG into the transmit shift register once it is empty and the transmitter is enabled
+    if (txRemaining == 0x00 && txregFull == 0x01 && (registers[SIM_TXSTA] & 0x20) == 0x20 && (registers[SIM_RCSTA] & 0x80) == 0x80) {
+        txShift = registers[SIM_TXREG];
+        txRemaining = SIM_EUSART_BITS_PER_BYTE * eusartBitCycles();
+        txregFull = 0x00;
+    }
+
+    //The transmit flag follows TXREG, it is set whenever the transmitter is enabled and TXREG is empty
+    if ((registers[SIM_TXSTA] & 0x20) == 0x20 && txregFull == 0x00) {
+        registers[SIM_PIR1] |= 0x10;
+    } else {
+        registers[SIM_PIR1] &= 0xEF;
+    }
+
+    //Transmit shift register status bit, set while the shift register is empty
+    if (txRemaining == 0x00) {
+        registers[SIM_TXSTA] |= 0x02;
+    } else {
+        registers[SIM_TXSTA] &= 0xFD;
+    }
+
+    //Data EEPROM, follow the unlock sequence the firmware writes into EECON2
+    if (eecon2Written == 0x01) {
+        eecon2Written = 0x00;
+
+        if (registers[SIM_EECON2] == 0x55) {
+            eepromUnlock = 0x01;
+        } else if (registers[SIM_EECON2] == 0xAA && eepromUnlock == 0x01) {
+            eepromUnlock = 0x02;
+        } else {
+            eepromUnlock = 0x00;
+        }
+    }
+
+    //A read completes right away, a write only starts if WREN is set and the unlock sequence came right before it
+    if ((registers[SIM_EECON1] & 0x81) == 0x01) {
+        registers[SIM_EEDAT] = eeprom[registers[SIM_EEADR]];
+        registers[SIM_EECON1] &= 0xFE;
+    }
+    if ((registers[SIM_EECON1] & 0x81) == 0x81) {
+        unsigned short word = flash[((registers[SIM_EEADRH] << 0x08) | registers[SIM_EEADR]) & (SIM_FLASH_WORDS - 0x01)];
+
+        registers[SIM_EEDAT] = word & 0xFF;
+        registers[SIM_EEDATH] = word >> 0x08;
+        registers[SIM_EECON1] &= 0xFE;
+    }
+
+    //Program memory, every word is loaded into the block latches and the block is written once its last word comes in, stalling the CPU
+    if (flashRemaining == 0x00 && (registers[SIM_EECON1] & 0x86) == 0x86) {
+        if (eepromUnlock == 0x02) {
+            unsigned short address = ((registers[SIM_EEADRH] << 0x08) | registers[SIM_EEADR]) & (SIM_FLASH_WORDS - 0x01);
+
+            flashLatches[address & (SIM_FLASH_BLOCK_WORDS - 0x01)] = ((registers[SIM_EEDATH] << 0x08) | registers[SIM_EEDAT]) & 0x3FFF;
+            if ((address & (SIM_FLASH_BLOCK_WORDS - 0x01)) == SIM_FLASH_BLOCK_WORDS - 0x01) {
+                flashWriteAddress = address & ~(SIM_FLASH_BLOCK_WORDS - 0x01);
+                flashRemaining = SIM_FLASH_WRITE_US * (oscillatorFrequencies[(registers[SIM_OSCCON] & 0x70) >> 0x04] / 4000000.0);
+                flashRemaining += flashRemaining == 0x00;
+            }
+        }
+        registers[SIM_EECON1] &= 0xFD;
+        eepromUnlock = 0x00;
+    }
+    if (flashRemaining != 0x00 && --flashRemaining == 0x00) {
+        unsigned char i;
+
+        for (i = 0x00; i < SIM_FLASH_BLOCK_WORDS; i++) {
+            flash[flashWriteAddress + i] = flashLatches[i];
+            flashLatches[i] = 0x3FFF;
+        }
+        flashWrites++;
+    }
+
+    if (eepromRemaining == 0x00 && (registers[SIM_EECON1] & 0x82) == 0x02) {
+        if ((registers[SIM_EECON1] & 0x84) == 0x04 && eepromUnlock == 0x02) {
+            eepromRemaining = SIM_EEPROM_WRITE_US * (oscillatorFrequencies[(registers[SIM_OSCCON] & 0x70) >> 0x04] / 4000000.0);
+            eepromRemaining += eepromRemaining == 0x00;
+            eepromWriteAddress = registers[SIM_EEADR];
+            eepromWriteData = registers[SIM_EEDAT];
+        } else {
+            registers[SIM_EECON1] &= 0xFD;
+        }
+        eepromUnlock = 0x00;
+    }
+
+    //Store the byte, clear the WR bit and raise the write complete flag once the write is done
+    if (eepromRemaining != 0x00 && --eepromRemaining == 0x00) {
+        eeprom[eepromWriteAddress] = eepromWriteData;
+        eepromWrites++;
+        registers[SIM_EECON1] &= 0xFD;
+        registers[SIM_PIR2] |= 0x10;
+    }
+
+    //Clearing CREN clears an overrun and empties the receive FIFO
+    if ((registers[SIM_RCSTA] & 0x10) == 0x00) {
+        registers[SIM_RCSTA] &= 0xFD;
+        rxCount = 0x00;
+        registers[SIM_PIR1] &= 0xDF;
+    }
+
+    //Watchdog timer, timing out while the MCU is awake resets it, which the firmware only lets happen on purpose
+    if ((registers[SIM_WDTCON] & 0x01) == 0x01) {
+        watchdogNanoseconds += (4000000000ULL / oscillatorFrequencies[(registers[SIM_OSCCON] & 0x70) >> 0x04]);
+        if (watchdogNanoseconds >= watchdogPeriod()) {
+            watchdogArmed = 0x01;
+        }
+    } else {
+        watchdogNanoseconds = 0x00;
+    }
+
+    //Output pins, let the board model know about every change to the level driven onto them
+    if (pinWatcher != 0) {
+        unsigned char port;
+
+        for (port = SIM_PORTA; port <= SIM_PORTE; port++) {
+            unsigned char outputs = registers[port] & (registers[SIM_TRISA + port] ^ 0xFF);
+
+            if (outputs != pinOutputs[port]) {
+                pinOutputs[port] = outputs;
+                pinWatcher(port, outputs);
+            }
+        }
+    }
+
+    if (observer != 0) {
+        observer();
+    }
+
+    //Dispatch interrupts, GIE is cleared while the ISR runs just like the hardware does
+    while (isrActive == 0x00 && flashRemaining == 0x00 && (registers[SIM_INTCON] & 0x80) == 0x80 && interruptPending()) {
+        //A run taken for a received byte alone is timed on its own, it is the most a byte can cost the ISR
+        unsigned char receiveOnly = (registers[SIM_INTCON] & 0x24) != 0x24 && (registers[SIM_PIR1] & registers[SIM_PIE1]) == 0x20 && (registers[SIM_PIR2] & registers[SIM_PIE2]) == 0x00;
+        unsigned long long isrStart = isrCycles;
+
+        isrActive = 0x01;
+        registers[SIM_INTCON] &= 0x7F;
+
+        step(SIM_CYCLES_ISR);
+        hardwareInterruptISR();
+
+        registers[SIM_INTCON] |= 0x80;
+        isrActive = 0x00;
+
+        if (receiveOnly == 0x01) {
+            receiveIsrs++;
+            receiveIsrCycles += isrCycles - isrStart;
+        }
+    }
+}
+
+//Advance the simulated clock one cycle at a time, so interrupts can preempt the firmware in the middle of a costed block of code
+static void step(unsigned long cycles) {
+    while (cycles-- != 0x00) {
+        tick();
+    }
+
+    //The CPU stalls while a block of program memory is written, the peripherals keep running
+    while (flashRemaining != 0x00) {
+        tick();
+    }
+}
+
+/***************
+ *  Functions  *
+ ***************/
+
+//Put the register file and peripherals into their power-on state
+void simReset(void) {
+    unsigned short address;
+    unsigned char i;
+
+    for (i = 0x00; i < SIM_REGISTER_COUNT; i++) {
+        registers[i] = 0x00;
+    }
+
+    registers[SIM_TRISA] = 0xFF;
+    registers[SIM_TRISB] = 0xFF;
+    registers[SIM_TRISC] = 0xFF;
+    registers[SIM_TRISD] = 0xFF;
+    registers[SIM_TRISE] = 0x0F;
+    registers[SIM_ANSEL] = 0xFF;
+    registers[SIM_ANSELH] = 0x3F;
+    registers[SIM_OPTION_REG] = 0xFF;
+    registers[SIM_PR2] = 0xFF;
+    registers[SIM_OSCCON] = 0x60;
+    registers[SIM_WDTCON] = 0x08;
+    registers[SIM_TXSTA] = 0x02;
+
+    //The data EEPROM keeps its contents over a reset, it only starts out erased
+    if (eepromBlank == 0x01) {
+        for (address = 0x00; address < SIM_EEPROM_SIZE; address++) {
+            eeprom[address] = 0xFF;
+        }
+        eepromBlank = 0x00;
+    }
+
+    //Program memory keeps its contents over a reset too
+    if (flashBlank == 0x01) {
+        for (address = 0x00; address < SIM_FLASH_WORDS; address++) {
+            flash[address] = 0x3FFF;
+        }
+        flashBlank = 0x00;
+    }
+
+    for (i = 0x00; i < SIM_FLASH_BLOCK_WORDS; i++) {
+        flashLatches[i] = 0x3FFF;
+    }
+
+    for (i = 0x00; i < 0x05; i++) {
+        digitalInputs[i] = 0x00;
+        pinOutputs[i] = 0x00;
+    }
+
+    for (i = 0x00; i < 0x08; i++) {
+        runNanoseconds[i] = 0x00;
+    }
+
+    for (i = 0x00; i < SIM_ADC_CHANNEL_COUNT; i++) {
+        analogInputs[i] = 0x0000;
+        adcConversions[i] = 0x00;
+    }
+
+    cycleCount = 0x00;
+    nanoseconds = 0x00;
+    timer0Prescaler = 0x00;
+    timer2Prescaler = 0x00;
+    timer2Postscaler = 0x00;
+    timer1Prescaler = 0x00;
+    clockFrozen = 0x00;
+    nops = 0x00;
+    sleepNanoseconds = 0x00;
+    sleeps = 0x00;
+    isrCycles = 0x00;
+    receiveIsrs = 0x00;
+    receiveIsrCycles = 0x00;
+    picoseconds = 0x00;
+    adcBusy = 0x00;
+    isrActive = 0x00;
+    watchdogArmed = 0x00;
+    watchdogNanoseconds = 0x00;
+    txregWritten = 0x00;
+    txregFull = 0x00;
+    txRemaining = 0x00;
+    txBytes = 0x00;
+    eecon2Written = 0x00;
+    eepromUnlock = 0x00;
+    eepromRemaining = 0x00;
+    eepromWrites = 0x00;
+    flashRemaining = 0x00;
+    flashWrites = 0x00;
+    rxCount = 0x00;
+}
+
+//Access a register from the firmware, advances the simulated clock and merges the input pins into port reads
+unsigned char *simRegister(enum simRegisterIndex index) {
+    if (clockFrozen == 0x00) {
+        step(SIM_CYCLES_PER_ACCESS);
+
+        //The main loop finishes every pass by writing PORTA, charge the cost of the C code around it there
+        if (index == SIM_PORTA && isrActive == 0x00) {
+            step(SIM_CYCLES_MAIN_LOOP);
+        }
+    }
+
+    //TXREG is only ever written by the firmware, the byte is picked up by the EUSART on the next cycle
+    if (index == SIM_TXREG) {
+        txregWritten = 0x01;
+    }
+
+    //Reading RCREG takes the first byte out of the receive FIFO, the receive flag stays set while there is another one behind it
+    if (index == SIM_RCREG && rxCount != 0x00) {
+        registers[SIM_RCREG] = rxFifo[0x00];
+        rxFifo[0x00] = rxFifo[0x01];
+        rxCount--;
+    }
+    if (index == SIM_RCREG && rxCount == 0x00) {
+        registers[SIM_PIR1] &= 0xDF;
+    }
+
+    //EECON2 is only ever written by the firmware, the unlock sequence is followed on the next cycle
+    if (index == SIM_EECON2) {
+        eecon2Written = 0x01;
+    }
+
+    //Pins configured as inputs reflect the outside world rather than the output latch
+    if (index <= SIM_PORTE) {
+        unsigned char tris = registers[SIM_TRISA + index];
+
+        registers[index] = (registers[index] & (tris ^ 0xFF)) | (digitalInputs[index] & tris);
+    }
+
+    return &registers[index];
+}
+
+//Execute a no operation instruction from the firmware
+void simNop(void) {
+    nops++;
+    if (clockFrozen == 0x00) {
+        step(SIM_CYCLES_PER_NOP);
+    }
+}
+
+//Execute a SLEEP instruction from the firmware, the instruction clock and every timer clocked from it stop till the watchdog timer times out
+//An enabled interrupt with its flag already set keeps the MCU awake, as does a disabled watchdog timer since nothing else can wake the simulated MCU
+void simSleep(void) {
+    unsigned long long slept;
+
+    if (clockFrozen == 0x01) {
+        return;
+    }
+
+    if (interruptPending() || (registers[SIM_WDTCON] & 0x01) == 0x00) {
+        step(SIM_CYCLES_PER_NOP);
+        return;
+    }
+
+    //Jump straight to the time out, SLEEP clears the watchdog timer so it counts its whole period
+    slept = watchdogPeriod();
+    nanoseconds += slept;
+    sleepNanoseconds += slept;
+    watchdogNanoseconds = 0x00;
+    sleeps++;
+    if (observer != 0) {
+        observer();
+    }
+
+    //Waking up by the watchdog timer carries on from the instruction after SLEEP
+    step(SIM_CYCLES_PER_NOP);
+}
+
+//Set the error of the oscillator in parts per million, positive runs fast, so copies of the panel running side by side drift apart like real ones
+void simSetOscillatorError(long ppm) {
+    oscillatorError = ppm;
+}
+
+//Stop or restart the simulated clock, while it is stopped register accesses don't advance it and no peripheral or interrupt runs on its own
+void simSetClockFrozen(unsigned char frozen) {
+    clockFrozen = frozen;
+}
+
+//Set the callback that is called after every clock step
+void simSetObserver(simObserver newObserver) {
+    observer = newObserver;
+}
+
+//Set the callback that receives the bytes sent out by the EUSART
+void simSetTransmitter(simTransmitter newTransmitter) {
+    transmitter = newTransmitter;
+}
+
+//Set the callback that follows the output pins of every port
+void simSetPinWatcher(simPinWatcher newWatcher) {
+    pinWatcher = newWatcher;
+}
+
+//Set the voltage on an analog channel as a 10 bit ADC reading
+void simSetAnalogInput(unsigned char channel, unsigned short value) {
+    if (channel < SIM_ADC_CHANNEL_COUNT) {
+        analogInputs[channel] = value & 0x03FF;
+    }
+}
+
+//Set the logic level on the input pins of a port
+void simSetDigitalInputs(enum simRegisterIndex port, unsigned char value) {
+    if (port <= SIM_PORTE) {
+        digitalInputs[port] = value;
+    }
+}
+
+//Receive a byte on the RX pin of the EUSART, the byte is dropped unless the serial port and the receiver are enabled
+//The FIFO holds 2 bytes, a byte that comes in while it is full sets OERR and the receiver stops until CREN is cleared
+void simReceive(unsigned char data) {
+    if ((registers[SIM_RCSTA] & 0x92) != 0x90) {
+        return;
+    }
+
+    if (rxCount == 0x02) {
+        registers[SIM_RCSTA] |= 0x02;
+        return;
+    }
+
+    rxFifo[rxCount++] = data;
+    registers[SIM_PIR1] |= 0x20;
+}
+
+//Baud rate the EUSART is currently set up for
+unsigned long simEusartBaud(void) {
+    return oscillatorFrequencies[(registers[SIM_OSCCON] & 0x70) >> 0x04] / (0x04 * eusartBitCycles());
+}
+
+//Read a register without advancing the simulated clock
+unsigned char simPeek(enum simRegisterIndex index) {
+    return registers[index];
+}
+
+//Number of __nop() executed since the last reset
+unsigned long simNops(void) {
+    return nops;
+}
+
+//Number of instruction cycles executed since the last reset
+unsigned long long simCycles(void) {
+    return cycleCount;
+}
+
+//Time elapsed since the last reset, follows changes to OSCCON
+unsigned long long simNanoseconds(void) {
+    return nanoseconds;
+}
+
+//Time spent awake at an oscillator frequency since the last reset, selected by the IRCF bits of OSCCON
+unsigned long long simRunNanoseconds(unsigned char ircf) {
+    return ircf < 0x08 ? runNanoseconds[ircf] : 0x00;
+}
+
+//Time spent asleep since the last reset
+unsigned long long simSleepNanoseconds(void) {
+    return sleepNanoseconds;
+}
+
+//Number of times SLEEP put the MCU to sleep since the last reset
+unsigned long simSleeps(void) {
+    return sleeps;
+}
+
+//Number of instruction cycles spent in hardwareInterruptISR() since the last reset, the cost of entering and leaving it included
+unsigned long long simIsrCycles(void) {
+    return isrCycles;
+}
+
+//Number of runs of hardwareInterruptISR() taken for a received byte with no other interrupt pending since the last reset
+unsigned long simReceiveIsrs(void) {
+    return receiveIsrs;
+}
+
+//Number of instruction cycles spent in those runs since the last reset, the cost of entering and leaving the ISR included
+unsigned long long simReceiveIsrCycles(void) {
+    return receiveIsrCycles;
+}
+
+//Current oscillator frequency in Hz, as selected by OSCCON
+unsigned long simOscillatorFrequency(void) {
+    return oscillatorFrequencies[(registers[SIM_OSCCON] & 0x70) >> 0x04];
+}
+
+//Non-zero while hardwareInterruptISR() is running
+unsigned char simInIsr(void) {
+    return isrActive;
+}
+
+//Non-zero once the watchdog timer has timed out while the MCU was awake, resetting the panel
+unsigned char simWatchdogArmed(void) {
+    return watchdogArmed;
+}
+
+//Number of ADC conversions completed on a channel since the last reset
+unsigned long simAdcConversions(unsigned char channel) {
+    return channel < SIM_ADC_CHANNEL_COUNT ? adcConversions[channel] : 0x00;
+}
+
+//Number of bytes the EUSART has finished sending since the last reset
+unsigned long simEusartBytes(void) {
+    return txBytes;
+}
+
+//Contents of the data EEPROM, kept across resets like the real thing
+unsigned char *simEeprom(void) {
+    return eeprom;
+}
+
+//Number of data EEPROM writes completed since the last reset
+unsigned long simEepromWrites(void) {
+    return eepromWrites;
+}
+
+//Contents of program memory, kept across resets, the firmware only reaches it through EECON1
+unsigned short *simFlash(void) {
+    return flash;
+}
+
+//Number of program memory blocks written since the last reset
+unsigned long simFlashWrites(void) {
+    return flashWrites;
+}
@@ -0,0 +1,97 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Simulated PIC16F884 register file and peripherals, used to run      *
+ *  Main.c natively on a Linux host for benchmarking and testing        *
+ ************************************************************************/
+
+#ifndef PIC16F884_H
+#define PIC16F884_H
+
+/***************
+ *  Registers  *
+ ***************/
+
+//Indexes into the simulated register file, only the registers used by the firmware are present
+enum simRegisterIndex {
+    SIM_PORTA, SIM_PORTB, SIM_PORTC, SIM_PORTD, SIM_PORTE,
+    SIM_TRISA, SIM_TRISB, SIM_TRISC, SIM_TRISD, SIM_TRISE,
+    SIM_ANSEL, SIM_ANSELH,
+    SIM_ADCON0, SIM_ADCON1, SIM_ADRESH, SIM_ADRESL,
+    SIM_INTCON, SIM_PIR1, SIM_PIR2, SIM_PIE1, SIM_PIE2,
+    SIM_OPTION_REG, SIM_TMR0, SIM_T2CON, SIM_TMR2, SIM_PR2, SIM_OSCCON, SIM_WDTCON,
+    SIM_TXSTA, SIM_RCSTA, SIM_SPBRG, SIM_SPBRGH, SIM_BAUDCTL, SIM_TXREG, SIM_RCREG,
+    SIM_EEDAT, SIM_EEADR, SIM_EEDATH, SIM_EEADRH, SIM_EECON1, SIM_EECON2,
+    SIM_T1CON, SIM_TMR1L, SIM_TMR1H,
+    SIM_REGISTER_COUNT
+};
+
+/*******************
+ *  Cost Model     *
+ *******************/
+
+//Instruction cycle costs charged to the simulated clock. Main.c is compiled natively, so the cost of plain C code is not visible to the
+//simulator, instead the big fixed costs are taken from the baseline production listing (dist/default/production/Software.production.lst)
+#define SIM_CYCLES_PER_ACCESS 0x01     //Cost of a single special function register access
+#define SIM_CYCLES_PER_NOP 0x01        //Cost of a single __nop()
+#define SIM_CYCLES_ISR 0x3C            //Cost of entering, running and leaving hardwareInterruptISR() along the common path, including context save
+#define SIM_CYCLES_MAIN_LOOP 0x01F4    //Cost of the input and output tasks, the code that used to make up the while loop in main() outside of softwareISR(), charged at the PORTA write
+
+#define SIM_ADC_TAD_PER_CONVERSION 0x0B  //Number of TAD periods a single 10 bit conversion takes
+#define SIM_ADC_CHANNEL_COUNT 0x0E       //Number of analog channels on the PIC16F884 (AN0 to AN13)
+
+#define SIM_EUSART_BITS_PER_BYTE 0x0A    //Bits sent for every byte in 8N1 asynchronous mode, including the start and stop bits
+
+#define SIM_EEPROM_SIZE 0x0100           //Bytes of data EEPROM
+#define SIM_EEPROM_WRITE_US 0x1388       //Time a single data EEPROM write takes, in microseconds
+
+#define SIM_FLASH_WORDS 0x1000           //Words of program memory
+#define SIM_FLASH_BLOCK_WORDS 0x04       //Words written to program memory at once, the block is written when its last word is loaded
+#define SIM_FLASH_WRITE_US 0x07D0        //Time the CPU stalls for while a block of program memory is written, in microseconds
+
+/***************
+ *  Functions  *
+ ***************/
+
+//Observer callback, called after every step of the simulated clock, used by the harnesses to inject inputs and detect outputs
+typedef void (*simObserver)(void);
+
+//Transmitter callback, called with every byte the EUSART finishes sending out on the TX pin
+typedef void (*simTransmitter)(unsigned char data);
+
+//Pin callback, called whenever the level driven onto the output pins of a port changes, pins configured as inputs read as 0
+typedef void (*simPinWatcher)(enum simRegisterIndex port, unsigned char outputs);
+
+void simReset(void);                                                 //Put the register file and peripherals into their power-on state
+unsigned char *simRegister(enum simRegisterIndex index);             //Access a register from the firmware, advances the simulated clock
+void simNop(void);                                                   //Execute a no operation instruction from the firmware
+void simSleep(void);                                                 //Execute a SLEEP instruction from the firmware, jumps ahead to the watchdog timer time out
+void simSetObserver(simObserver observer);                           //Set the callback that is called after every clock step
+void simSetOscillatorError(long ppm);                                //Set the error of the oscillator in parts per million, positive runs fast, simulated time follows the real clock
+void simSetClockFrozen(unsigned char frozen);                        //Stop or restart the simulated clock, for programs that call the interrupts and tasks themselves
+void simSetTransmitter(simTransmitter transmitter);                  //Set the callback that receives the bytes sent out by the EUSART
+void simSetPinWatcher(simPinWatcher watcher);                        //Set the callback that follows the output pins of every port
+void simSetAnalogInput(unsigned char channel, unsigned short value);  //Set the voltage on an analog channel as a 10 bit ADC reading
+void simSetDigitalInputs(enum simRegisterIndex port, unsigned char value);  //Set the logic level on the input pins of a port
+void simReceive(unsigned char data);                                 //Receive a byte on the RX pin of the EUSART
+unsigned long simEusartBaud(void);                                   //Baud rate the EUSART is currently set up for
+unsigned char simPeek(enum simRegisterIndex index);                  //Read a register without advancing the simulated clock
+unsigned long simNops(void);                                         //Number of __nop() executed since the last reset, the firmware only idles on them
+unsigned long long simCycles(void);                                  //Number of instruction cycles executed since the last reset
+unsigned long long simNanoseconds(void);                             //Time elapsed since the last reset, follows changes to OSCCON
+unsigned long long simRunNanoseconds(unsigned char ircf);             //Time spent awake at an oscillator frequency since the last reset, selected by the IRCF bits of OSCCON
+unsigned long long simSleepNanoseconds(void);                        //Time spent asleep since the last reset
+unsigned long simSleeps(void);                                       //Number of times SLEEP put the MCU to sleep since the last reset
+unsigned long long simIsrCycles(void);                               //Number of instruction cycles spent in hardwareInterruptISR() since the last reset
+unsigned long simReceiveIsrs(void);                                  //Number of runs of hardwareInterruptISR() taken for a received byte with no other interrupt pending since the last reset
+unsigned long long simReceiveIsrCycles(void);                        //Number of instruction cycles spent in those runs since the last reset
+unsigned long simOscillatorFrequency(void);                          //Current oscillator frequency in Hz, as selected by OSCCON
+unsigned char simInIsr(void);                                        //Non-zero while hardwareInterruptISR() is running
+unsigned char simWatchdogArmed(void);                                //Non-zero once the watchdog timer has timed out while the MCU was awake, resetting the panel
+unsigned long simAdcConversions(unsigned char channel);              //Number of ADC conversions completed on a channel since the last reset
+unsigned long simEusartBytes(void);                                  //Number of bytes the EUSART has finished sending since the last reset
+unsigned char *simEeprom(void);                                      //Contents of the data EEPROM, kept across resets like the real thing
+unsigned long simEepromWrites(void);                                 //Number of data EEPROM writes completed since the last reset
+unsigned short *simFlash(void);                                      //Contents of program memory, kept across resets, the firmware only reaches it through EECON1
+unsigned long simFlashWrites(void);                                  //Number of program memory blocks written since the last reset
+
+#endif
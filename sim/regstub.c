@@ -0,0 +1,45 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Register stub for the fuzz core, a plain PIC16F884 register file    *
+ *  with no clock, timers or peripherals behind it                      *
+ ************************************************************************/
+
+#include "pic16f884.h"
+
+static unsigned char registers[SIM_REGISTER_COUNT];  //The special function registers
+static unsigned char digitalInputs[0x05];            //Logic level driven onto the pins of PORTA to PORTE by the outside world
+
+/***************
+ *  Registers  *
+ ***************/
+
+//Access a register from the firmware, only the input pins are merged into port reads, nothing else happens behind the firmware's back
+unsigned char *simRegister(enum simRegisterIndex index) {
+    if (index <= SIM_PORTE) {
+        unsigned char tris = registers[SIM_TRISA + index];
+
+        registers[index] = (registers[index] & (tris ^ 0xFF)) | (digitalInputs[index] & tris);
+    }
+
+    return &registers[index];
+}
+
+//Execute a no operation instruction from the firmware, there is no clock to advance
+void simNop(void) {
+}
+
+//Execute a SLEEP instruction from the firmware, there is no clock to jump ahead
+void simSleep(void) {
+}
+
+//Set the logic level on the input pins of a port
+void simSetDigitalInputs(enum simRegisterIndex port, unsigned char value) {
+    if (port <= SIM_PORTE) {
+        digitalInputs[port] = value;
+    }
+}
+
+//Read a register without merging the input pins
+unsigned char simPeek(enum simRegisterIndex index) {
+    return registers[index];
+}
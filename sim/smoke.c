@@ -0,0 +1,164 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Smoke reset test, latches a smoke detector on an SLC, pushes the    *
+ *  reset button and checks that the SLC is power cycled through the    *
+ *  shift register while alarms on the other SLC's still come in        *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+#define SMOKE_LATCHED_SLC 0x02               //SLC the latching smoke detector is on, SLC3
+#define SMOKE_OTHER_SLC 0x04                 //SLC an alarm comes in on while the smoke reset is running, SLC5
+#define SMOKE_BUTTON_CYCLES 0x30000ULL       //Cycles the reset button is held down for
+#define SMOKE_OTHER_DELAY_CYCLES 0x40000ULL  //Cycles after the power is cut that the alarm on the other SLC comes in
+#define SMOKE_OFF_MIN_MS 0x07D0              //Shortest the power may stay cut for, in milliseconds
+#define SMOKE_OFF_MAX_MS 0x0898              //Longest the power may stay cut for, in milliseconds
+#define SMOKE_CONFIRM_BUDGET_MS 0x14         //Longest the alarm on the other SLC may take to be confirmed, in milliseconds
+
+/***************
+ *  Variables  *
+ ***************/
+
+static unsigned char scenarioStep = 0x00;          //Step of the scenario the simulated panel is on
+static unsigned long long stepAt = 0x00;           //Cycle the current step of the scenario started at
+static unsigned char latched = 0x00;               //Set while the smoke detector is latched in alarm, it only drops out once its power is cut
+static unsigned char poweredBefore = 0x00;         //SLC's that were powered when the reset button was pushed
+static unsigned char othersDropped = 0x00;         //Set if any SLC other than the latched one lost power during the smoke reset
+static unsigned long long offAt = 0x00;            //Simulated time the power to the latched SLC was cut
+static unsigned long long onAt = 0x00;             //Simulated time the power to the latched SLC came back
+static unsigned long long otherAt = 0x00;          //Simulated time the alarm on the other SLC came in
+static unsigned long long otherConfirmed = 0x00;   //Simulated time the alarm on the other SLC was confirmed
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Drive the reading of the SLC with the latching smoke detector, an SLC with its power cut reads as 0 and the detector drops out of alarm
+static void driveLatchedSLC(void) {
+    if ((harnessSlcPower() & (0x01 << SMOKE_LATCHED_SLC)) == 0x00) {
+        latched = 0x00;
+        simSetAnalogInput(HARNESS_SLC_CHANNEL(SMOKE_LATCHED_SLC), 0x0000);
+    } else {
+        simSetAnalogInput(HARNESS_SLC_CHANNEL(SMOKE_LATCHED_SLC), latched == 0x01 ? HARNESS_SLC_ALARM : HARNESS_SLC_NORMAL);
+    }
+}
+
+//Print the results of the scenario, returns non-zero if the smoke reset misbehaved
+static unsigned char printResults(void) {
+    double offMs = (onAt - offAt) / 1000000.0;
+    double confirmMs = (otherConfirmed - otherAt) / 1000000.0;
+    unsigned char failed = 0x00;
+
+    printf("Smoke reset of SLC%u, alarm on SLC%u while it runs\n", SMOKE_LATCHED_SLC + 0x01, SMOKE_OTHER_SLC + 0x01);
+    printf("power cut for %.1f ms, %s\n", offMs, offMs >= SMOKE_OFF_MIN_MS && offMs <= SMOKE_OFF_MAX_MS ? "pass" : "FAIL");
+    failed |= !(offMs >= SMOKE_OFF_MIN_MS && offMs <= SMOKE_OFF_MAX_MS);
+
+    printf("other SLC's kept power, %s\n", othersDropped == 0x00 ? "pass" : "FAIL");
+    failed |= othersDropped;
+
+    printf("SLC%u alarm confirmed in %.3f ms, %s\n", SMOKE_OTHER_SLC + 0x01, confirmMs, confirmMs <= SMOKE_CONFIRM_BUDGET_MS ? "pass" : "FAIL");
+    failed |= confirmMs > SMOKE_CONFIRM_BUDGET_MS;
+
+    printf("smoke detector dropped out of alarm, %s\n", latched == 0x00 ? "pass" : "FAIL");
+    failed |= latched;
+
+    return failed;
+}
+
+//Observer running the scenario, the smoke detector latches, the reset button is pushed and the panel runs until it arms the watchdog to reset
+static void scenarioObserver(void) {
+    unsigned char power = harnessSlcPower();
+
+    if (scenarioStep != 0x00) {
+        driveLatchedSLC();
+    }
+
+    //Follow the power of the SLC's once the reset button has been pushed
+    if (scenarioStep >= 0x02) {
+        if ((power & ~(0x01 << SMOKE_LATCHED_SLC) & poweredBefore) != (poweredBefore & ~(0x01 << SMOKE_LATCHED_SLC))) {
+            othersDropped = 0x01;
+        }
+        if (offAt == 0x00 && (power & (0x01 << SMOKE_LATCHED_SLC)) == 0x00) {
+            offAt = simNanoseconds();
+        }
+        if (offAt != 0x00 && onAt == 0x00 && (power & (0x01 << SMOKE_LATCHED_SLC)) != 0x00) {
+            onAt = simNanoseconds();
+        }
+
+        //Bring in an alarm on another SLC while the power is cut, it must still be confirmed in time
+        if (offAt != 0x00 && otherAt == 0x00 && simNanoseconds() - offAt >= SMOKE_OTHER_DELAY_CYCLES * 4000000000ULL / simOscillatorFrequency()) {
+            simSetAnalogInput(HARNESS_SLC_CHANNEL(SMOKE_OTHER_SLC), HARNESS_SLC_ALARM);
+            otherAt = simNanoseconds();
+        }
+        if (otherAt != 0x00 && otherConfirmed == 0x00 && (generalAlarmCause & (0x01 << SMOKE_OTHER_SLC)) != 0x00) {
+            otherConfirmed = simNanoseconds();
+        }
+    }
+
+    switch (scenarioStep) {
+        case 0x00:
+            if (simCycles() >= HARNESS_WARMUP_CYCLES) {
+                latched = 0x01;
+                scenarioStep++;
+            }
+            break;
+
+        case 0x01:
+            //Push the reset button once the alarm has come in
+            if ((generalAlarmCause & (0x01 << SMOKE_LATCHED_SLC)) != 0x00) {
+                poweredBefore = power;
+                simSetDigitalInputs(SIM_PORTD, 0x0E);
+                stepAt = simCycles();
+                scenarioStep++;
+            }
+            break;
+
+        case 0x02:
+            //Let go of the button
+            if (simCycles() - stepAt >= SMOKE_BUTTON_CYCLES) {
+                simSetDigitalInputs(SIM_PORTD, 0x0F);
+                scenarioStep++;
+            }
+            break;
+
+        default:
+            //The panel arms the watchdog once the reset counter runs out, the smoke reset must be over by then
+            if (simWatchdogArmed() != 0x00) {
+                unsigned char failed;
+
+                if (onAt == 0x00 || otherConfirmed == 0x00) {
+                    fprintf(stderr, "Smoke reset never %s\n", offAt == 0x00 ? "cut the power" : onAt == 0x00 ? "restored the power" : "let the other alarm in");
+                    _exit(0x01);
+                }
+
+                failed = printResults();
+                fflush(stdout);
+                _exit(failed);
+            }
+            if (simCycles() - stepAt > HARNESS_TIMEOUT_CYCLES) {
+                fprintf(stderr, "The panel never reset\n");
+                _exit(0x01);
+            }
+            break;
+    }
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, runs the scenario, the observer prints the results and ends the program
+int main(void) {
+    harnessPowerUp();
+    simSetObserver(scenarioObserver);
+    firmwareMain();
+    return 0x03;
+}
@@ -0,0 +1,328 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Battery standby test, cuts the AC power and measures the duty cycle *
+ *  and current draw of the standby mode against full rate, then checks *
+ *  the low battery trouble and the return to full rate on an alarm     *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Timing, in nanoseconds of simulated time
+#define STANDBY_SETTLE_NS 1000000000ULL          //Time the panel is left to settle before anything is measured
+#define STANDBY_WINDOW_NS 10000000000ULL         //Time the duty cycle is measured over, at full rate and in standby
+#define STANDBY_ENTER_BUDGET_NS 1000000000ULL    //Longest the panel may take to stand by once the AC power is lost
+#define STANDBY_LOW_BATTERY_BUDGET_NS 8000000000ULL  //Longest a low battery may take to come in, 12 readings with the battery taking turns with the NAC's, a sweep every tick
+#define STANDBY_RESTORE_BUDGET_NS 1000000000ULL  //Longest the panel may take to go back to full rate once the AC power is back
+#define STANDBY_ALARM_BUDGET_NS 100000000ULL     //Longest an alarm may take to latch in standby, a sleep, a sweep and the readings at full rate
+#define STANDBY_TIMEOUT_NS 120000000000ULL       //Longest the test may run for
+
+//Standby Limits
+#define STANDBY_MAX_DUTY 0.15                    //Most of the time the panel may spend awake in standby
+#define STANDBY_LOW_BATTERY (HARNESS_BATTERY_NORMAL - 0x0100)  //Reading of a battery that has run low
+#define STANDBY_ALARM_SLC 0x03                   //SLC the alarm comes in on during standby, SLC4
+
+//Current Draw, typical figures of the PIC16F884 at 5V off the internal RC-Oscillator, in microamps, indexed by the IRCF bits of OSCCON
+static const double runMicroamps[0x08] = {11.0, 70.0, 120.0, 200.0, 340.0, 560.0, 1000.0, 1700.0};
+#define STANDBY_SLEEP_MICROAMPS 3.0              //Typical draw asleep with the watchdog timer running
+#define STANDBY_HOURS 24.0                       //Time the battery has to hold the panel up in standby
+#define STANDBY_ALARM_MINUTES 5.0                //Time the battery has to sound the alarm for at the end of the standby time
+#define STANDBY_DERATING 1.25                    //Margin the battery is sized with, for ageing and temperature
+
+//Rest of the Panel, in milliamps, used when no load is given, the board isn't modelled so these are typical figures for the parts on it
+#define STANDBY_LCD_MILLIAMPS 25.0               //Serial 16x2 status LCD with its backlight on
+#define STANDBY_LED_MILLIAMPS 10.0               //Power and Trouble LED's, both lit while the AC power is lost
+#define STANDBY_SLC_MILLIAMPS 1.25               //Each SLC, its EOL resistor and about 20 detectors in standby
+#define STANDBY_NAC_MILLIAMPS 135.0              //Each NAC, a couple of horn strobes
+#define STANDBY_ALARM_EXTRA_MILLIAMPS 15.0       //Alarm LED and buzzer
+#define STANDBY_PANEL_LOAD (STANDBY_LCD_MILLIAMPS + STANDBY_LED_MILLIAMPS + HARNESS_SLC_COUNT * STANDBY_SLC_MILLIAMPS)  //Draw of the rest of the panel in standby, 45mA
+#define STANDBY_PANEL_ALARM_LOAD (STANDBY_PANEL_LOAD + STANDBY_ALARM_EXTRA_MILLIAMPS + HARNESS_NAC_COUNT * STANDBY_NAC_MILLIAMPS)  //Draw of the rest of the panel in alarm, 600mA
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Defined in Main.c
+extern unsigned char standbyMode;
+extern unsigned char generalTroubleCause;
+extern unsigned char utilityCounter;
+
+//Readings taken at the start of a measurement window
+struct window {
+    unsigned long long at;                 //Time the window started at
+    unsigned long long run[0x08];          //Time spent awake at each oscillator frequency
+    unsigned long long sleep;              //Time spent asleep
+    unsigned long sweeps;                  //Readings of the alarm SLC, one every sweep
+    unsigned long ticks;                   //Timer 0 overflows
+};
+
+//Results of a measurement window
+struct measurement {
+    double duty;      //Fraction of the time the panel spent awake
+    double sweeps;    //Sweeps a second
+    double ticks;     //Timer 0 overflows a second
+    double current;   //Average draw of the MCU in microamps
+};
+
+static unsigned char step = 0x00;         //Step of the test the panel is on
+static unsigned long long stepAt = 0x00;  //Time the current step started at
+static unsigned char failed = 0x00;       //Set once any check has failed
+static unsigned char lastCounter = 0x00;  //Utility counter at the last observer call
+static unsigned long ticks = 0x00;        //Timer 0 overflows counted by watching the utility counter
+static unsigned char lastOsccon = 0x60;   //OSCCON at the last observer call
+static unsigned long clockSwitches = 0x00;  //Times the firmware has switched the clock
+static unsigned long busySwitches = 0x00;   //Times the clock was switched with a byte still in the transmit shift register, which would go out at the wrong baud rate
+static unsigned long long latchedAt = 0x00;  //Time the alarm brought in during standby latched
+static struct window start;               //Readings at the start of the window being measured
+static struct measurement fullRate;       //Results at full rate
+static struct measurement standby;        //Results in standby
+static double standbyLoad = STANDBY_PANEL_LOAD;      //Draw of the rest of the panel in standby in milliamps, the status LCD, the LED's and the SLC's
+static double alarmLoad = STANDBY_PANEL_ALARM_LOAD;  //Draw of the rest of the panel in alarm in milliamps, the NAC's and everything in standby
+static unsigned char loadsGiven = 0x00;              //Set once either load was given, rather than the typical panel
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Take the readings a measurement window starts from
+static void startWindow(unsigned long long now) {
+    unsigned char ircf;
+
+    start.at = now;
+    for (ircf = 0x00; ircf < 0x08; ircf++) {
+        start.run[ircf] = simRunNanoseconds(ircf);
+    }
+    start.sleep = simSleepNanoseconds();
+    start.sweeps = simAdcConversions(HARNESS_SLC_CHANNEL(STANDBY_ALARM_SLC));
+    start.ticks = ticks;
+}
+
+//Work out the duty cycle, scan rate and current draw since the window started
+static struct measurement endWindow(unsigned long long now) {
+    struct measurement result;
+    double seconds = (now - start.at) / 1000000000.0;
+    double awake = 0.0;
+    double charge = 0.0;
+    unsigned char ircf;
+
+    for (ircf = 0x00; ircf < 0x08; ircf++) {
+        double run = (simRunNanoseconds(ircf) - start.run[ircf]) / 1000000000.0;
+
+        awake += run;
+        charge += run * runMicroamps[ircf];
+    }
+    charge += (simSleepNanoseconds() - start.sleep) / 1000000000.0 * STANDBY_SLEEP_MICROAMPS;
+
+    result.duty = awake / seconds;
+    result.sweeps = (simAdcConversions(HARNESS_SLC_CHANNEL(STANDBY_ALARM_SLC)) - start.sweeps) / seconds;
+    result.ticks = (ticks - start.ticks) / seconds;
+    result.current = charge / seconds;
+    return result;
+}
+
+//Print the battery a standby and an alarm draw on top of the MCU call for, in standby and at full rate throughout
+static void printBattery(const char *name, double standbyMilliamps, double alarmMilliamps) {
+    double standbyAmpHours = (standby.current / 1000.0 + standbyMilliamps) * STANDBY_HOURS / 1000.0;
+    double fullRateAmpHours = (fullRate.current / 1000.0 + standbyMilliamps) * STANDBY_HOURS / 1000.0;
+    double alarmAmpHours = (fullRate.current / 1000.0 + alarmMilliamps) * STANDBY_ALARM_MINUTES / 60.0 / 1000.0;
+
+    printf("%-10s  %7.1f  %7.1f  %8.4f  %8.4f  %8.4f  %10.4f\n", name, standbyMilliamps, alarmMilliamps, standbyAmpHours, alarmAmpHours, (standbyAmpHours + alarmAmpHours) * STANDBY_DERATING,
+           (fullRateAmpHours + alarmAmpHours) * STANDBY_DERATING);
+}
+
+//Print the measurements and the battery they call for, then end the test
+static void finish(void) {
+    printf("\nmode       awake  sweeps/s  ticks/s  MCU uA\n");
+    printf("full rate  %5.1f%%  %8.1f  %7.2f  %6.1f\n", fullRate.duty * 100.0, fullRate.sweeps, fullRate.ticks, fullRate.current);
+    printf("standby    %5.1f%%  %8.1f  %7.2f  %6.1f\n", standby.duty * 100.0, standby.sweeps, standby.ticks, standby.current);
+
+    //The MCU on its own shows what the standby mode saves, the panel load is what really sizes the battery
+    printf("\nBattery for %.0f h of standby and %.0f min of alarm, x%.2f derating, loads in mA on top of the MCU, %s\n", STANDBY_HOURS, STANDBY_ALARM_MINUTES, STANDBY_DERATING,
+           loadsGiven == 0x01 ? "panel load as given" : "panel load typical of the parts on the board, pass -s and -a for the real one");
+    printf("load        standby    alarm  standby Ah  alarm Ah  total Ah  full rate Ah\n");
+    printBattery("MCU only", 0.0, 0.0);
+    printBattery("panel", standbyLoad, alarmLoad);
+    printf("%s\n", failed == 0x00 ? "PASS" : "FAIL");
+    fflush(stdout);
+    _exit(failed);
+}
+
+//Observer running the test, measures full rate, cuts the AC power, measures standby, runs the battery low and brings in an alarm
+static void standbyObserver(void) {
+    unsigned long long now = simNanoseconds();
+    char detail[0x80];
+
+    //The utility counter counts every Timer 0 overflow, it never moves on by more than 1 between calls
+    if (utilityCounter != lastCounter) {
+        lastCounter = utilityCounter;
+        ticks++;
+    }
+
+    //Catch every switch of the clock, the observer runs after every register access so the transmit shift register is seen as it was at the switch
+    if (simPeek(SIM_OSCCON) != lastOsccon) {
+        lastOsccon = simPeek(SIM_OSCCON);
+        clockSwitches++;
+        if ((simPeek(SIM_TXSTA) & 0x02) == 0x00) {
+            busySwitches++;
+        }
+    }
+
+    switch (step) {
+        case 0x00:
+            if (now >= STANDBY_SETTLE_NS) {
+                startWindow(now);
+                step++;
+            }
+            break;
+
+        case 0x01:
+            if (now - start.at >= STANDBY_WINDOW_NS) {
+                fullRate = endWindow(now);
+                snprintf(detail, sizeof(detail), "awake %.1f%% at %lu Hz, %.1f sweeps/s", fullRate.duty * 100.0, simOscillatorFrequency(), fullRate.sweeps);
+                failed |= harnessCheck("full rate", standbyMode == 0x00 && fullRate.duty > 0.99, detail);
+
+                simSetDigitalInputs(SIM_PORTB, 0x00);
+                stepAt = now;
+                step++;
+            }
+            break;
+
+        case 0x02:
+            //The AC power loss comes in first, then the panel stands by at the end of a sweep and sleeps once everything is sent
+            if (standbyMode == 0x01 && simSleeps() != 0x00) {
+                snprintf(detail, sizeof(detail), "asleep %.1f ms after the AC power was lost, %lu Hz, status LCD at %lu baud", (now - stepAt) / 1000000.0, simOscillatorFrequency(), simEusartBaud());
+                failed |= harnessCheck("enter standby", now - stepAt <= STANDBY_ENTER_BUDGET_NS && (generalTroubleCause & 0x01) == 0x01 && simEusartBaud() > 9500 && simEusartBaud() < 9700, detail);
+
+                stepAt = now;
+                step++;
+            } else if (now - stepAt > STANDBY_ENTER_BUDGET_NS) {
+                failed |= harnessCheck("enter standby", 0x00, "never went to sleep");
+                finish();
+            }
+            break;
+
+        case 0x03:
+            if (now - stepAt >= STANDBY_SETTLE_NS) {
+                startWindow(now);
+                step++;
+            }
+            break;
+
+        case 0x04:
+            if (now - start.at >= STANDBY_WINDOW_NS) {
+                standby = endWindow(now);
+                snprintf(detail, sizeof(detail), "awake %.1f%%, %.1f sweeps/s, %.2f ticks/s, %lu sleeps", standby.duty * 100.0, standby.sweeps, standby.ticks, simSleeps());
+                //Every overflow that finds the scan parked starts a sweep, the odd one Timer 0 makes on its own while a sweep is running doesn't
+                failed |= harnessCheck("standby duty", standbyMode == 0x01 && standby.duty <= STANDBY_MAX_DUTY && standby.sweeps >= standby.ticks * 0.8 && standby.sweeps <= standby.ticks, detail);
+
+                simSetAnalogInput(HARNESS_BATTERY_CHANNEL, STANDBY_LOW_BATTERY);
+                stepAt = now;
+                step++;
+            }
+            break;
+
+        case 0x05:
+            if ((generalTroubleCause & 0x02) == 0x02) {
+                snprintf(detail, sizeof(detail), "came in after %.2f s, still %s", (now - stepAt) / 1000000000.0, standbyMode == 0x01 ? "in standby" : "at full rate");
+                failed |= harnessCheck("low battery", now - stepAt <= STANDBY_LOW_BATTERY_BUDGET_NS && standbyMode == 0x01, detail);
+
+                simSetAnalogInput(HARNESS_BATTERY_CHANNEL, HARNESS_BATTERY_NORMAL);
+                simSetDigitalInputs(SIM_PORTB, 0x80);
+                stepAt = now;
+                step++;
+            } else if (now - stepAt > STANDBY_LOW_BATTERY_BUDGET_NS) {
+                failed |= harnessCheck("low battery", 0x00, "never came in");
+                finish();
+            }
+            break;
+
+        case 0x06:
+            if (standbyMode == 0x00 && (generalTroubleCause & 0x01) == 0x00 && simPeek(SIM_OSCCON) == 0x60) {
+                snprintf(detail, sizeof(detail), "back at %lu Hz after %.1f ms", simOscillatorFrequency(), (now - stepAt) / 1000000.0);
+                failed |= harnessCheck("AC restore", now - stepAt <= STANDBY_RESTORE_BUDGET_NS, detail);
+
+                simSetDigitalInputs(SIM_PORTB, 0x00);
+                stepAt = now;
+                step++;
+            } else if (now - stepAt > STANDBY_RESTORE_BUDGET_NS) {
+                failed |= harnessCheck("AC restore", 0x00, "never went back to full rate");
+                finish();
+            }
+            break;
+
+        case 0x07:
+            //Bring the alarm in while the panel is asleep, so it has to wake up on its own to see it
+            if (standbyMode == 0x01 && simSleeps() != 0x00 && now - stepAt >= STANDBY_SETTLE_NS) {
+                simSetAnalogInput(HARNESS_SLC_CHANNEL(STANDBY_ALARM_SLC), HARNESS_SLC_ALARM);
+                stepAt = now;
+                step++;
+            }
+            break;
+
+        case 0x08:
+            //The alarm latches at the full scan rate, the clock follows once the LCD task sees the EUSART idle, whichever comes last ends the step
+            if (latchedAt == 0x00 && generalAlarmCause != 0x00) {
+                latchedAt = now;
+            }
+            if (latchedAt != 0x00 && simPeek(SIM_OSCCON) == 0x60) {
+                snprintf(detail, sizeof(detail), "SLC%u latched %.1f ms after it went into alarm, back at %lu Hz after %.1f ms", STANDBY_ALARM_SLC + 0x01, (latchedAt - stepAt) / 1000000.0, simOscillatorFrequency(), (now - stepAt) / 1000000.0);
+                failed |= harnessCheck("alarm wake", now - stepAt <= STANDBY_ALARM_BUDGET_NS && standbyMode == 0x00, detail);
+
+                snprintf(detail, sizeof(detail), "%lu switches, %lu with a byte still being sent", clockSwitches, busySwitches);
+                failed |= harnessCheck("clock switch", clockSwitches >= 0x04 && busySwitches == 0x00, detail);
+                finish();
+            } else if (now - stepAt > STANDBY_ALARM_BUDGET_NS) {
+                failed |= harnessCheck("alarm wake", 0x00, latchedAt == 0x00 ? "never latched" : "never went back to full rate");
+                finish();
+            }
+            break;
+    }
+
+    if (now > STANDBY_TIMEOUT_NS) {
+        printf("Test never finished, stuck at step %u\nFAIL\n", step);
+        fflush(stdout);
+        _exit(0x01);
+    }
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, runs the test on the simulated panel, the observer ends the program
+int main(int argc, char **argv) {
+    int option;
+
+    while ((option = getopt(argc, argv, "s:a:")) != -1) {
+        switch (option) {
+            case 's':
+                standbyLoad = strtod(optarg, 0);
+                loadsGiven = 0x01;
+                break;
+            case 'a':
+                alarmLoad = strtod(optarg, 0);
+                loadsGiven = 0x01;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-s standby load in mA] [-a alarm load in mA]\n", argv[0x00]);
+                return 0x02;
+        }
+    }
+
+    printf("Battery standby, duty cycle and current draw with the AC power lost\n");
+    printf("check               result  detail\n");
+    fflush(stdout);
+
+    harnessPowerUp();
+    simSetObserver(standbyObserver);
+    firmwareMain();
+    return 0x03;
+}
@@ -0,0 +1,467 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Firmware update test, runs the uploader against the bootloader      *
+ *  over the simulated EUSART through a clean update, a link lost part  *
+ *  way through the check pass, a power cut part way through the write  *
+ *  pass and an update asked for during an alarm                        *
+ ************************************************************************/
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "pic16f884.h"
+#include "harness.h"
+#include "../uploader/uploader.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Images, the old one already on the panel and the new one sent by the uploader
+#define UPDATE_OLD_BLOCKS 0x02C0     //Blocks taken by the old image
+#define UPDATE_NEW_BLOCKS 0x0330     //Blocks taken by the new image
+#define UPDATE_GAP_BLOCK 0x0100      //First block of a gap in the new image, the old image is left there
+#define UPDATE_GAP_BLOCKS 0x10       //Blocks in the gap
+#define UPDATE_HEX_BOOT_WORDS 0x10   //Words the HEX file carries for the bootloader block, which the uploader has to leave out
+#define UPDATE_STRAY_ADDRESS 0x0F00  //Word address of code past the bootloader in its block, an image carrying it has to be turned down
+#define UPDATE_OVERSIZED_WORDS 0x0204 //Words of a bootloader that has grown into the debug executive, an image carrying it has to be turned down
+
+//Faults
+#define UPDATE_CORRUPT_BLOCK 0x40    //Block whose frame is damaged once in each pass of the clean update
+#define UPDATE_LINK_LOST_FRAMES 0x64 //Frames of the check pass sent before the link is lost
+#define UPDATE_POWER_CUT_BLOCK 0x0200  //Block of the write pass the power is cut at
+
+//Timing, in nanoseconds of simulated time
+#define UPDATE_REFUSED_NS 3000000000ULL  //Time the panel is given to hand over to the bootloader when an update should be turned down
+#define UPDATE_TIMEOUT_NS 20000000000ULL //Longest a scenario may run for
+
+//Scenarios
+#define UPDATE_CLEAN 0x00       //Clean update with a damaged frame in each pass
+#define UPDATE_LINK_LOST 0x01   //The link is lost part way through the check pass
+#define UPDATE_POWER_CUT 0x02   //The power is cut part way through the write pass
+#define UPDATE_ALARM 0x03       //An update asked for during an alarm
+#define UPDATE_SCENARIOS 0x04   //Number of scenarios
+
+//Progress of the uploader
+#define UPDATE_HOST_IDLE 0x00       //Waiting to send the key
+#define UPDATE_HOST_KEY 0x01        //Sending the key
+#define UPDATE_HOST_UPLOADING 0x02  //Stepping through the protocol
+#define UPDATE_HOST_DONE 0x03       //The uploader is finished, successfully or not
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Defined in Main.c
+void bootloader(void);
+
+static const char *scenarioNames[UPDATE_SCENARIOS] = {"clean update", "link lost", "power cut", "during an alarm"};
+
+static struct uploaderImage newImage;              //Image sent by the uploader
+static unsigned short oldFlash[SIM_FLASH_WORDS];   //Program memory before the update, the old image and the bootloader block
+static unsigned short newFlash[SIM_FLASH_WORDS];   //Program memory expected after the update
+static struct uploader uploader;                   //Uploader sending the new image
+static unsigned char scenario = 0x00;              //Scenario being run
+
+//Link between the uploader and the panel
+static unsigned char hostBytes[UPLOADER_FRAME_SIZE];  //Bytes being sent to the panel
+static unsigned char hostLength = 0x00;            //Bytes left to send
+static unsigned char hostSent = 0x00;              //Bytes sent so far
+static unsigned long hostBaud = 0x00;              //Baud rate the uploader is sending at
+static unsigned long long hostGap = 0x00;          //Time left between two bytes, the key is sent a byte at a time
+static unsigned long long hostNextAt = 0x00;       //Time the next byte has finished going out
+static unsigned long long replyDeadline = 0x00;    //Time the uploader gives up waiting for a reply
+static unsigned char replies[0x10];                //Replies received by the uploader and not yet handed over
+static unsigned char replyCount = 0x00;            //Replies waiting to be handed over
+static unsigned char hostState = UPDATE_HOST_IDLE; //Progress of the uploader
+static int hostStatus = UPLOADER_WAIT;             //Result of the uploader once it is finished
+static unsigned char linkLost = 0x00;              //Set once the link is lost, nothing gets through either way
+static unsigned char corrupted = 0x00;             //Passes a frame has been damaged in, first bit is the check pass
+
+//Results
+static unsigned long long keyAt = 0x00;            //Time the key started going out
+static unsigned long long handoverAt = 0x00;       //Time the panel handed over to the bootloader
+static unsigned long long armedAt = 0x00;          //Time the watchdog was enabled to reset the panel
+static unsigned char updatingShown = 0x00;         //Set if the status LCD showed the update at the handover
+static unsigned long long linkLostAt = 0x00;       //Time the link was lost
+static unsigned char powerCuts = 0x00;             //Times the power has been cut
+static jmp_buf powerCut;                           //Where the panel starts over once the power comes back
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Non-zero if the EUSART of the panel runs within 3% of a baud rate, a byte sent at any other rate is lost as a framing error
+static unsigned char baudMatches(unsigned long baud) {
+    unsigned long panel = simEusartBaud();
+
+    return panel * 0x64 >= baud * 0x61 && panel * 0x64 <= baud * 0x67;
+}
+
+//Bytes sent by the EUSART go to the status LCD at its baud rate and to the uploader at the bootloader baud rate
+static void linkTransmit(unsigned char data) {
+    if (baudMatches(UPLOADER_KEY_BAUD)) {
+        harnessLcdReceive(data);
+    } else if (baudMatches(UPLOADER_BAUD) && linkLost == 0x00 && replyCount < sizeof(replies)) {
+        replies[replyCount++] = data;
+    }
+}
+
+//Start sending bytes to the panel, each one takes 10 bit times followed by the gap
+static void hostSend(const unsigned char *data, unsigned char length, unsigned long baud, unsigned long long gap) {
+    memcpy(hostBytes, data, length);
+    hostLength = length;
+    hostSent = 0x00;
+    hostBaud = baud;
+    hostGap = gap;
+    hostNextAt = simNanoseconds() + 10000000000ULL / baud;
+}
+
+//Act on what the uploader came up with, a frame is damaged once in each pass of the clean update
+static void hostAct(int status) {
+    if (status == UPLOADER_SEND) {
+        hostSend(uploader.frame, UPLOADER_FRAME_SIZE, UPLOADER_BAUD, 0x00);
+
+        if (scenario == UPDATE_CLEAN && uploader.frame[0x00] != UPLOADER_END && uploader.block >= UPDATE_CORRUPT_BLOCK && (corrupted & (0x01 << uploader.writing)) == 0x00) {
+            hostBytes[0x05] ^= 0x10;
+            corrupted |= 0x01 << uploader.writing;
+        }
+    } else if (status == UPLOADER_OK || status == UPLOADER_ERROR) {
+        hostState = UPDATE_HOST_DONE;
+        hostStatus = status;
+    }
+}
+
+//Move the link along, sends the next byte once it is due and hands the replies over to the uploader once a frame has gone out
+static void hostStep(void) {
+    unsigned long long now = simNanoseconds();
+
+    if (hostLength != 0x00) {
+        if (now < hostNextAt) {
+            return;
+        }
+
+        if (linkLost == 0x00 && baudMatches(hostBaud)) {
+            simReceive(hostBytes[hostSent]);
+        }
+        hostSent++;
+        hostNextAt = now + hostGap + 10000000000ULL / hostBaud;
+
+        if (--hostLength != 0x00) {
+            return;
+        }
+
+        //The uploader switches to the bootloader baud rate after the key and throws away anything it got before
+        if (hostState == UPDATE_HOST_KEY) {
+            hostState = UPDATE_HOST_UPLOADING;
+            replyCount = 0x00;
+        }
+        replyDeadline = now + uploaderTimeout(&uploader) * 1000000ULL;
+    }
+
+    if (hostState != UPDATE_HOST_UPLOADING) {
+        return;
+    }
+
+    if (replyCount != 0x00) {
+        int reply = replies[0x00];
+
+        memmove(replies, &replies[0x01], --replyCount);
+        hostAct(uploaderReply(&uploader, reply));
+    } else if (now >= replyDeadline) {
+        hostAct(uploaderReply(&uploader, UPLOADER_TIMEOUT));
+    }
+}
+
+//Print the words that don't match what program memory should hold, returns the number of them
+static unsigned long compareFlash(const unsigned short *expected) {
+    const unsigned short *flash = simFlash();
+    unsigned long mismatches = 0x00;
+    unsigned short address;
+
+    for (address = 0x00; address < SIM_FLASH_WORDS; address++) {
+        if (flash[address] != expected[address]) {
+            if (mismatches++ < 0x04) {
+                printf("  word 0x%03X is 0x%04X, should be 0x%04X\n", address, flash[address], expected[address]);
+            }
+        }
+    }
+
+    return mismatches;
+}
+
+//Check the outcome of the scenario and end it
+static void finish(void) {
+    unsigned char failed = 0x00;
+
+    printf("%s:\n", scenarioNames[scenario]);
+
+    switch (scenario) {
+        case UPDATE_CLEAN:
+        case UPDATE_POWER_CUT:
+            printf("  uploader %s, %lu frames sent, %lu of them again, %lu blocks written since the last reset\n", hostStatus == UPLOADER_OK ? "finished" : uploader.error,
+                   uploader.frames, uploader.resent, simFlashWrites());
+            failed |= hostStatus != UPLOADER_OK;
+            failed |= compareFlash(newFlash) != 0x00;
+
+            if (scenario == UPDATE_CLEAN) {
+                printf("  key to bootloader %.1f ms, status LCD %s, bootloader to reset %.1f ms\n", (handoverAt - keyAt) / 1000000.0, updatingShown == 0x01 ? "showed the update" : "never showed the update",
+                       (armedAt - handoverAt) / 1000000.0);
+                failed |= updatingShown != 0x01 || uploader.resent < 0x02;
+            } else {
+                printf("  recovered in %.1f ms after the power came back\n", armedAt / 1000000.0);
+            }
+            break;
+
+        case UPDATE_LINK_LOST:
+            printf("  uploader %s, %lu blocks written, reset %.1f ms after the link was lost\n", hostStatus == UPLOADER_OK ? "finished" : uploader.error, simFlashWrites(),
+                   (armedAt - linkLostAt) / 1000000.0);
+            failed |= hostStatus == UPLOADER_OK || simFlashWrites() != 0x00;
+            failed |= compareFlash(oldFlash) != 0x00;
+            break;
+
+        default:
+            printf("  %s, general alarm %s\n", handoverAt == 0x00 ? "update turned down" : "handed over to the bootloader", generalAlarmCause != 0x00 ? "still sounding" : "gone");
+            failed |= handoverAt != 0x00 || generalAlarmCause == 0x00;
+            failed |= compareFlash(oldFlash) != 0x00;
+            break;
+    }
+
+    printf("  %s\n", failed == 0x00 ? "PASS" : "FAIL");
+    fflush(stdout);
+    _exit(failed);
+}
+
+//Observer running the scenario, sends the key once the panel has settled and follows the handover, the update and the reset
+static void updateObserver(void) {
+    unsigned long long now = simNanoseconds();
+
+    if (hostState == UPDATE_HOST_IDLE && simCycles() >= HARNESS_WARMUP_CYCLES) {
+        //Bring in an alarm first when the update should be turned down
+        if (scenario == UPDATE_ALARM && generalAlarmCause == 0x00) {
+            simSetAnalogInput(HARNESS_SLC_CHANNEL(0x00), HARNESS_SLC_ALARM);
+            return;
+        }
+
+        hostState = UPDATE_HOST_KEY;
+        keyAt = now;
+        hostSend((const unsigned char *) UPLOADER_KEY, strlen(UPLOADER_KEY), UPLOADER_KEY_BAUD, UPLOADER_KEY_GAP * 1000000ULL);
+    }
+
+    if (handoverAt == 0x00 && baudMatches(UPLOADER_BAUD)) {
+        handoverAt = now;
+        updatingShown = strstr(harnessLcdLine(0x00), "UPDATING") != 0 || strstr(harnessLcdLine(0x01), "UPDATING") != 0;
+    }
+
+    hostStep();
+
+    if (scenario == UPDATE_LINK_LOST && linkLost == 0x00 && uploader.writing == 0x00 && uploader.frames >= UPDATE_LINK_LOST_FRAMES) {
+        linkLost = 0x01;
+        linkLostAt = now;
+    }
+    if (scenario == UPDATE_POWER_CUT && powerCuts == 0x00 && uploader.writing == 0x01 && uploader.block >= UPDATE_POWER_CUT_BLOCK) {
+        powerCuts++;
+        longjmp(powerCut, 0x01);
+    }
+    if (scenario == UPDATE_ALARM && keyAt != 0x00 && now - keyAt >= UPDATE_REFUSED_NS) {
+        finish();
+    }
+
+    if (armedAt == 0x00 && simWatchdogArmed() != 0x00) {
+        armedAt = now;
+    }
+    if (armedAt != 0x00 && hostState == UPDATE_HOST_DONE) {
+        finish();
+    }
+
+    if (now > UPDATE_TIMEOUT_NS) {
+        printf("%s:\n  never finished, uploader %s\n  FAIL\n", scenarioNames[scenario], hostState == UPDATE_HOST_DONE ? "finished" : "still running");
+        fflush(stdout);
+        _exit(0x01);
+    }
+}
+
+//Run a scenario from power up with the old image in program memory
+static void runScenario(void) {
+    unsigned short *flash;
+
+    if (setjmp(powerCut) == 0x00) {
+        harnessPowerUp();
+        memcpy(simFlash(), oldFlash, sizeof(oldFlash));
+        simSetTransmitter(linkTransmit);
+        simSetObserver(updateObserver);
+        firmwareMain();
+        _exit(0x03);
+    }
+
+    //The power came back part way through the write pass, the reset vector has to lead into the bootloader
+    harnessPowerUp();
+    flash = simFlash();
+    if (flash[0x00] != (0x3000 | (UPLOADER_BOOT_ADDRESS >> 0x08)) || flash[0x01] != 0x008A || flash[0x02] != (0x2800 | (UPLOADER_BOOT_ADDRESS & 0x07FF))) {
+        printf("%s:\n  reset vector 0x%04X 0x%04X 0x%04X doesn't lead into the bootloader\n  FAIL\n", scenarioNames[scenario], flash[0x00], flash[0x01], flash[0x02]);
+        fflush(stdout);
+        _exit(0x01);
+    }
+
+    //Finish the update the way the uploader does with -r, straight into the protocol without the key
+    uploaderStart(&uploader, &newImage);
+    hostState = UPDATE_HOST_UPLOADING;
+    hostLength = 0x00;
+    replyCount = 0x00;
+    replyDeadline = uploaderTimeout(&uploader) * 1000000ULL;
+    simSetTransmitter(linkTransmit);
+    simSetObserver(updateObserver);
+    bootloader();
+    _exit(0x03);
+}
+
+//Write a data record of an Intel HEX file, every byte of a record, the checksum included, adds up to 0
+static void hexRecord(FILE *file, unsigned short byteAddress, const unsigned char *data, unsigned char count) {
+    unsigned char checksum = count + (byteAddress >> 0x08) + (byteAddress & 0xFF);
+    unsigned char i;
+
+    fprintf(file, ":%02X%04X00", count, byteAddress);
+    for (i = 0x00; i < count; i++) {
+        fprintf(file, "%02X", data[i]);
+        checksum += data[i];
+    }
+    fprintf(file, "%02X\n", (unsigned char) -checksum);
+}
+
+//Build the old and new images, the new one is written out as an XC8 HEX file and loaded by the uploader, returns 0 on success
+static int buildImages(void) {
+    static const unsigned char configuration[0x02] = {0xE4, 0x3F};
+    char path[] = "/tmp/updateXXXXXX";
+    unsigned long long random = 0x2545F4914F6CDD1DULL;
+    unsigned char data[UPLOADER_BLOCK_WORDS * 0x02];
+    unsigned short address;
+    unsigned char i;
+    FILE *file;
+    int fd;
+    int result;
+
+    //Old image, with the bootloader block holding a pattern the update must leave alone
+    for (address = 0x00; address < SIM_FLASH_WORDS; address++) {
+        oldFlash[address] = 0x3FFF;
+        if (address < UPDATE_OLD_BLOCKS * UPLOADER_BLOCK_WORDS) {
+            oldFlash[address] = harnessRandom(&random) & 0x3FFF;
+        } else if (address >= UPLOADER_BOOT_ADDRESS) {
+            oldFlash[address] = 0x2000 | address;
+        }
+    }
+    memcpy(newFlash, oldFlash, sizeof(newFlash));
+
+    fd = mkstemp(path);
+    file = fd < 0x00 ? 0 : fdopen(fd, "w");
+    if (file == 0) {
+        return -1;
+    }
+
+    //New image, one record per block with a gap the old image is left in
+    for (address = 0x00; address < UPDATE_NEW_BLOCKS * UPLOADER_BLOCK_WORDS; address += UPLOADER_BLOCK_WORDS) {
+        if (address >= UPDATE_GAP_BLOCK * UPLOADER_BLOCK_WORDS && address < (UPDATE_GAP_BLOCK + UPDATE_GAP_BLOCKS) * UPLOADER_BLOCK_WORDS) {
+            continue;
+        }
+
+        for (i = 0x00; i < UPLOADER_BLOCK_WORDS; i++) {
+            newFlash[address + i] = harnessRandom(&random) & 0x3FFF;
+            data[i * 0x02] = newFlash[address + i] & 0xFF;
+            data[i * 0x02 + 0x01] = newFlash[address + i] >> 0x08;
+        }
+        hexRecord(file, address * 0x02, data, sizeof(data));
+    }
+
+    //Words for the bootloader block and a configuration word, both of which the uploader leaves out
+    memset(data, 0x00, sizeof(data));
+    for (address = 0x00; address < UPDATE_HEX_BOOT_WORDS; address += UPLOADER_BLOCK_WORDS) {
+        hexRecord(file, (UPLOADER_BOOT_ADDRESS + address) * 0x02, data, sizeof(data));
+    }
+    hexRecord(file, 0x400E, configuration, sizeof(configuration));
+    fprintf(file, ":00000001FF\n");
+    fclose(file);
+
+    result = uploaderLoadHex(path, &newImage);
+    unlink(path);
+
+    return result == 0x00 && newImage.skipped == UPDATE_HEX_BOOT_WORDS ? 0x00 : -1;
+}
+
+//Build an image with a bootloader of the given words and a block of something else at the given address, or none if 0, returns what the uploader made of it
+static int buildBootImage(unsigned short bootWords, unsigned short strayAddress) {
+    static struct uploaderImage bootImage;
+    char path[] = "/tmp/updateXXXXXX";
+    unsigned char data[UPLOADER_BLOCK_WORDS * 0x02];
+    unsigned short address;
+    FILE *file;
+    int fd;
+    int result;
+
+    fd = mkstemp(path);
+    file = fd < 0x00 ? 0 : fdopen(fd, "w");
+    if (file == 0) {
+        return UPLOADER_HEX_UNUSABLE;
+    }
+
+    //A reset vector, the bootloader and maybe a block of something else further on
+    memset(data, 0x00, sizeof(data));
+    hexRecord(file, 0x0000, data, sizeof(data));
+    for (address = 0x00; address < bootWords; address += UPLOADER_BLOCK_WORDS) {
+        hexRecord(file, (UPLOADER_BOOT_ADDRESS + address) * 0x02, data, sizeof(data));
+    }
+    if (strayAddress != 0x00) {
+        hexRecord(file, strayAddress * 0x02, data, sizeof(data));
+    }
+    fprintf(file, ":00000001FF\n");
+    fclose(file);
+
+    result = uploaderLoadHex(path, &bootImage);
+    unlink(path);
+
+    return result;
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, runs every scenario in a child process of its own and returns non-zero if any of them failed
+int main(void) {
+    unsigned char failures = 0x00;
+
+    if (buildImages() != 0x00) {
+        fprintf(stderr, "The uploader failed to load the new image\n");
+        return 0x02;
+    }
+    if (buildBootImage(UPDATE_HEX_BOOT_WORDS, UPDATE_STRAY_ADDRESS) != UPLOADER_HEX_BOOT_BLOCK) {
+        fprintf(stderr, "The uploader took an image with code past the bootloader in its block\n");
+        return 0x02;
+    }
+    if (buildBootImage(UPDATE_OVERSIZED_WORDS, 0x00) != UPLOADER_HEX_BOOT_SIZE || buildBootImage(UPLOADER_BOOT_WORDS, 0x00) != 0x00) {
+        fprintf(stderr, "The uploader didn't hold the bootloader to its %u words\n", UPLOADER_BOOT_WORDS);
+        return 0x02;
+    }
+
+    printf("Firmware update, %u blocks of old image, %u blocks of new image at %u baud\n", UPDATE_OLD_BLOCKS, UPDATE_NEW_BLOCKS - UPDATE_GAP_BLOCKS, UPLOADER_BAUD);
+    fflush(stdout);
+
+    for (scenario = 0x00; scenario < UPDATE_SCENARIOS; scenario++) {
+        pid_t child = fork();
+        int status;
+
+        if (child == 0x00) {
+            uploaderStart(&uploader, &newImage);
+            runScenario();
+        }
+
+        if (child < 0x00 || waitpid(child, &status, 0x00) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0x00) {
+            failures++;
+        }
+    }
+
+    printf("%u of %u scenarios failed\n", failures, UPDATE_SCENARIOS);
+    return failures != 0x00;
+}
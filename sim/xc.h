@@ -0,0 +1,66 @@
+/************************************************************************
+ *  Fire Alarm Panel - Host Simulator                                   *
+ *  Stand-in for the XC8 device header, maps every register used by     *
+ *  Main.c onto the simulated PIC16F884 register file                   *
+ ************************************************************************/
+
+#ifndef SIM_XC_H
+#define SIM_XC_H
+
+#include "pic16f884.h"
+
+//Compiler Extensions
+#define interrupt        //The simulator calls hardwareInterruptISR() directly, so the qualifier is not needed
+#define bank1            //The host has a flat address space, so RAM bank qualifiers are not needed
+#define bank2
+#define BOOT_PLACEMENT   //The simulator can't place a function at an address, the bootloader is called by name instead
+#define __nop() simNop()
+#define SLEEP() simSleep()
+
+//Registers
+#define PORTA (*simRegister(SIM_PORTA))
+#define PORTB (*simRegister(SIM_PORTB))
+#define PORTC (*simRegister(SIM_PORTC))
+#define PORTD (*simRegister(SIM_PORTD))
+#define PORTE (*simRegister(SIM_PORTE))
+#define TRISA (*simRegister(SIM_TRISA))
+#define TRISB (*simRegister(SIM_TRISB))
+#define TRISC (*simRegister(SIM_TRISC))
+#define TRISD (*simRegister(SIM_TRISD))
+#define TRISE (*simRegister(SIM_TRISE))
+#define ANSEL (*simRegister(SIM_ANSEL))
+#define ANSELH (*simRegister(SIM_ANSELH))
+#define ADCON0 (*simRegister(SIM_ADCON0))
+#define ADCON1 (*simRegister(SIM_ADCON1))
+#define ADRESH (*simRegister(SIM_ADRESH))
+#define ADRESL (*simRegister(SIM_ADRESL))
+#define INTCON (*simRegister(SIM_INTCON))
+#define PIR1 (*simRegister(SIM_PIR1))
+#define PIR2 (*simRegister(SIM_PIR2))
+#define PIE1 (*simRegister(SIM_PIE1))
+#define PIE2 (*simRegister(SIM_PIE2))
+#define OPTION_REG (*simRegister(SIM_OPTION_REG))
+#define TMR0 (*simRegister(SIM_TMR0))
+#define T2CON (*simRegister(SIM_T2CON))
+#define TMR2 (*simRegister(SIM_TMR2))
+#define PR2 (*simRegister(SIM_PR2))
+#define OSCCON (*simRegister(SIM_OSCCON))
+#define WDTCON (*simRegister(SIM_WDTCON))
+#define TXSTA (*simRegister(SIM_TXSTA))
+#define RCSTA (*simRegister(SIM_RCSTA))
+#define SPBRG (*simRegister(SIM_SPBRG))
+#define SPBRGH (*simRegister(SIM_SPBRGH))
+#define BAUDCTL (*simRegister(SIM_BAUDCTL))
+#define TXREG (*simRegister(SIM_TXREG))
+#define RCREG (*simRegister(SIM_RCREG))
+#define EEDAT (*simRegister(SIM_EEDAT))
+#define EEADR (*simRegister(SIM_EEADR))
+#define EEDATH (*simRegister(SIM_EEDATH))
+#define EEADRH (*simRegister(SIM_EEADRH))
+#define EECON1 (*simRegister(SIM_EECON1))
+#define EECON2 (*simRegister(SIM_EECON2))
+#define T1CON (*simRegister(SIM_T1CON))
+#define TMR1L (*simRegister(SIM_TMR1L))
+#define TMR1H (*simRegister(SIM_TMR1H))
+
+#endif
@@ -0,0 +1,114 @@
+/************************************************************************
+ *  Fire Alarm Panel - Telemetry Decoder                                *
+ *  Listens to PORTC6 through a serial port on Linux and prints the     *
+ *  state of the panel every time a telemetry frame comes in            *
+ ************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "telemetry.h"
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Names of the causes, indexed by their number in a frame
+static const char *causeNames[TELEMETRY_CAUSE_COUNT] = {"alarm", "pre-alarm", "slc-trouble", "nac-trouble", "general"};
+
+//Names of the ADC channels, indexed by channel
+static const char *channelNames[TELEMETRY_CHANNEL_COUNT] = {
+    "NAC1", "NAC2", "NAC3", "NAC4", "AN4", "BAT", "SLC1", "SLC2", "SLC3", "SLC4", "SLC5", "SLC6", "SLC7", "SLC8"
+};
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Print the state of the panel as a single line, anything not known yet is shown as --
+static void printState(const struct telemetry *telemetry) {
+    unsigned char i;
+
+    printf("%02u %c", telemetry->sequence, telemetry->heartbeat == 0x01 ? 'H' : ' ');
+    for (i = 0x00; i < TELEMETRY_CAUSE_COUNT; i++) {
+        if ((telemetry->knownCauses & (0x01 << i)) != 0x00) {
+            printf(" %s=%02X", causeNames[i], telemetry->causes[i]);
+        } else {
+            printf(" %s=--", causeNames[i]);
+        }
+    }
+    printf(" |");
+    for (i = 0x00; i < TELEMETRY_CHANNEL_COUNT; i++) {
+        if ((telemetry->knownChannels & (0x01 << i)) != 0x00) {
+            printf(" %s=%02X", channelNames[i], telemetry->readings[i]);
+        } else {
+            printf(" %s=--", channelNames[i]);
+        }
+    }
+    printf(" | lost %lu\n", telemetry->lost);
+    fflush(stdout);
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, decodes the frames till the serial port closes
+int main(int argc, char **argv) {
+    struct telemetry telemetry;
+    struct termios settings;
+    const char *device = "/dev/ttyUSB0";
+    unsigned char data;
+    int option;
+    int port;
+
+    while ((option = getopt(argc, argv, "d:")) != -1) {
+        switch (option) {
+            case 'd':
+                device = optarg;
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-d device]\n", argv[0x00]);
+                return 0x02;
+        }
+    }
+
+    port = open(device, O_RDONLY | O_NOCTTY);
+    if (port < 0x00) {
+        fprintf(stderr, "Can't open %s: %s\n", device, strerror(errno));
+        return 0x02;
+    }
+
+    //Raw 8N1 at the status LCD baud rate
+    if (tcgetattr(port, &settings) != 0x00) {
+        fprintf(stderr, "Can't read the settings of %s: %s\n", device, strerror(errno));
+        close(port);
+        return 0x02;
+    }
+    cfmakeraw(&settings);
+    cfsetispeed(&settings, B9600);
+    cfsetospeed(&settings, B9600);
+    settings.c_cflag |= CLOCAL | CREAD;
+    settings.c_cc[VMIN] = 0x01;
+    settings.c_cc[VTIME] = 0x00;
+    if (tcsetattr(port, TCSANOW, &settings) != 0x00) {
+        fprintf(stderr, "Can't set %s to %u baud: %s\n", device, TELEMETRY_BAUD, strerror(errno));
+        close(port);
+        return 0x02;
+    }
+
+    telemetryStart(&telemetry);
+    while (read(port, &data, 0x01) == 0x01) {
+        if (telemetryReceive(&telemetry, data) == TELEMETRY_FRAME) {
+            printState(&telemetry);
+        }
+    }
+
+    close(port);
+    return 0x00;
+}
@@ -0,0 +1,153 @@
+/************************************************************************
+ *  Fire Alarm Panel - Telemetry Decoder                                *
+ *  Follows the bytes sent to the status LCD, checks every telemetry    *
+ *  frame and applies its items to the state of the panel               *
+ ************************************************************************/
+
+#include <string.h>
+
+#include "telemetry.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Decoder States
+#define TELEMETRY_STATE_IDLE 0x00     //Between frames, the bytes are for the status LCD
+#define TELEMETRY_STATE_COMMAND 0x01  //The command prefix came in, the next byte says if a frame starts
+#define TELEMETRY_STATE_FRAME 0x02    //Inside a frame
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Bytes taken by the item starting with the given byte, 0 if no item starts with it
+static unsigned char itemLength(unsigned char item) {
+    if ((item & 0x70) == TELEMETRY_DELTA && (item & 0x0F) < TELEMETRY_CHANNEL_COUNT) {
+        return 0x02;
+    }
+    if ((item & 0x70) == TELEMETRY_READING && (item & 0x0F) < TELEMETRY_CHANNEL_COUNT) {
+        return 0x03;
+    }
+    if ((item & 0x70) == TELEMETRY_CAUSE && (item & 0x07) < TELEMETRY_CAUSE_COUNT) {
+        return 0x02;
+    }
+
+    return item == TELEMETRY_END ? 0x02 : 0x00;
+}
+
+//Throw away the frame being received
+static int damaged(struct telemetry *telemetry) {
+    telemetry->state = TELEMETRY_STATE_IDLE;
+    telemetry->damaged++;
+
+    return TELEMETRY_DAMAGED;
+}
+
+//Apply the items of a whole frame once its check matches
+static int applyFrame(struct telemetry *telemetry) {
+    unsigned char *frame = telemetry->frame;
+    unsigned char check = 0x00;
+    unsigned char sequence = frame[0x00] & TELEMETRY_SEQUENCE_MASK;
+    unsigned char i;
+
+    for (i = 0x00; i < telemetry->length - 0x01; i++) {
+        check += frame[i];
+    }
+    if ((check & 0x7F) != frame[telemetry->length - 0x01]) {
+        return damaged(telemetry);
+    }
+
+    //A gap in the sequence numbers means a change may have been missed, every reading is unknown till it is sent whole again
+    if (telemetry->synced == 0x01 && sequence != ((telemetry->sequence + 0x01) & TELEMETRY_SEQUENCE_MASK)) {
+        telemetry->lost += (sequence - telemetry->sequence - 0x01) & TELEMETRY_SEQUENCE_MASK;
+        telemetry->knownChannels = 0x00;
+    }
+    telemetry->sequence = sequence;
+    telemetry->heartbeat = (frame[0x00] & TELEMETRY_HEARTBEAT) == TELEMETRY_HEARTBEAT;
+    telemetry->synced = 0x01;
+
+    for (i = 0x01; frame[i] != TELEMETRY_END; i += itemLength(frame[i])) {
+        unsigned char index = frame[i] & 0x0F;
+
+        switch (frame[i] & 0x70) {
+            case TELEMETRY_DELTA:
+                //A change only means something on top of a reading that is known
+                if ((telemetry->knownChannels & (0x01 << index)) != 0x00) {
+                    telemetry->readings[index] += (signed char) (frame[i + 0x01] << 0x02) >> 0x02;
+                }
+                break;
+
+            case TELEMETRY_READING:
+                telemetry->readings[index] = (frame[i + 0x01] << 0x07) | frame[i + 0x02];
+                telemetry->knownChannels |= 0x01 << index;
+                break;
+
+            default:
+                index &= 0x07;
+                telemetry->causes[index] = ((frame[i] & 0x08) << 0x04) | frame[i + 0x01];
+                telemetry->knownCauses |= 0x01 << index;
+                break;
+        }
+    }
+
+    telemetry->frames++;
+    telemetry->heartbeats += telemetry->heartbeat;
+    telemetry->state = TELEMETRY_STATE_IDLE;
+    return TELEMETRY_FRAME;
+}
+
+/***************
+ *  Functions  *
+ ***************/
+
+//Get ready to decode, nothing about the panel is known yet
+void telemetryStart(struct telemetry *telemetry) {
+    memset(telemetry, 0x00, sizeof(*telemetry));
+}
+
+//Hand over a byte sent to the status LCD, returns TELEMETRY_FRAME once a frame has been decoded
+int telemetryReceive(struct telemetry *telemetry, unsigned char data) {
+    unsigned char i;
+
+    switch (telemetry->state) {
+        case TELEMETRY_STATE_IDLE:
+            if (data == TELEMETRY_PREFIX) {
+                telemetry->state = TELEMETRY_STATE_COMMAND;
+            }
+            return TELEMETRY_NONE;
+
+        case TELEMETRY_STATE_COMMAND:
+            telemetry->state = TELEMETRY_STATE_IDLE;
+            if (data == TELEMETRY_CURSOR) {
+                telemetry->state = TELEMETRY_STATE_FRAME;
+                telemetry->length = 0x00;
+                telemetry->bytes += 0x02;
+            } else if (data == TELEMETRY_PREFIX) {
+                telemetry->state = TELEMETRY_STATE_COMMAND;
+            }
+            return TELEMETRY_NONE;
+
+        default:
+            //Nothing in a frame reaches 0x80, so a command prefix or anything else that high means bytes went missing
+            if ((data & 0x80) == 0x80 || telemetry->length == TELEMETRY_FRAME_SIZE) {
+                damaged(telemetry);
+                telemetry->state = data == TELEMETRY_PREFIX ? TELEMETRY_STATE_COMMAND : TELEMETRY_STATE_IDLE;
+                return TELEMETRY_DAMAGED;
+            }
+
+            telemetry->frame[telemetry->length++] = data;
+            telemetry->bytes++;
+
+            //Walk the items to find out if the frame is whole, the byte after the end item is the check
+            for (i = 0x01; i < telemetry->length; i += itemLength(telemetry->frame[i])) {
+                if (itemLength(telemetry->frame[i]) == 0x00) {
+                    return damaged(telemetry);
+                }
+                if (telemetry->frame[i] == TELEMETRY_END && i + 0x02 == telemetry->length) {
+                    return applyFrame(telemetry);
+                }
+            }
+            return TELEMETRY_NONE;
+    }
+}
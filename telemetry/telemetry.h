@@ -0,0 +1,65 @@
+/************************************************************************
+ *  Fire Alarm Panel - Telemetry Decoder                                *
+ *  Picks the telemetry frames out of the bytes sent to the status LCD  *
+ *  and keeps track of the panel, shared by the telemetry program and   *
+ *  the host simulator                                                  *
+ ************************************************************************/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Telemetry Framing, must match the telemetry in Main.c
+#define TELEMETRY_BAUD 9600               //Baud rate of the status LCD the frames are sent along with
+#define TELEMETRY_PREFIX 0xFE             //Status LCD command prefix, never sent inside a frame
+#define TELEMETRY_CURSOR 0xD0             //Command byte a frame starts with, it moves the cursor into hidden display RAM
+#define TELEMETRY_FRAME_SIZE 0x18         //Most bytes in a frame after the command
+#define TELEMETRY_HEARTBEAT 0x40          //Header bit set on a heartbeat, the first 6 bits of the header are the sequence number
+#define TELEMETRY_SEQUENCE_MASK 0x3F      //Sequence numbers count up by 1 every frame and wrap around after 63
+#define TELEMETRY_DELTA 0x00              //Item with the change of a reading, the channel in the first 4 bits and a 6 bit two's complement change in the next byte
+#define TELEMETRY_READING 0x10            //Item with a whole reading, the channel in the first 4 bits and the 8 bit reading in the next 2 bytes, top bit first
+#define TELEMETRY_CAUSE 0x20              //Item with a cause bitmap, the cause in the first 3 bits, the top bit of the bitmap in the fourth bit and the other 7 bits in the next byte
+#define TELEMETRY_END 0x7F                //Item ending the frame, followed by the sum of every byte from the header on in 7 bits
+#define TELEMETRY_CHANNEL_COUNT 0x0E      //ADC channels with readings
+#define TELEMETRY_CAUSE_COUNT 0x05        //Cause bitmaps, general alarm, pre-alarm, SLC trouble, NAC trouble and general trouble
+#define TELEMETRY_ALL_CHANNELS 0x3FFF     //Known channels once every reading is known
+
+//Results of handing a byte to the decoder
+#define TELEMETRY_NONE 0x00     //The byte didn't finish a frame
+#define TELEMETRY_FRAME 0x01    //The byte finished a frame, the state has been updated
+#define TELEMETRY_DAMAGED 0x02  //The frame the byte belonged to was damaged and has been thrown away
+
+/***************
+ *  Variables  *
+ ***************/
+
+//State of the panel as told by the frames, along with the decoder working on the next frame
+struct telemetry {
+    unsigned char causes[TELEMETRY_CAUSE_COUNT];       //Cause bitmaps, valid once their bit is set in knownCauses
+    unsigned char readings[TELEMETRY_CHANNEL_COUNT];   //Top 8 bits of the ADC readings, valid once their bit is set in knownChannels
+    unsigned char knownCauses;                         //Causes received since the decoder started, first bit is the general alarm
+    unsigned short knownChannels;                      //Channels with a known reading, cleared whenever a frame is lost as a change may have been missed
+    unsigned char sequence;                            //Sequence number of the last frame
+    unsigned char heartbeat;                           //Set if the last frame was a heartbeat
+    unsigned char synced;                              //Set once a frame has come in, so the next sequence number is known
+    unsigned long frames;                              //Frames decoded
+    unsigned long heartbeats;                          //Heartbeats among the frames decoded
+    unsigned long lost;                                //Frames missing from the sequence numbers, damaged ones included
+    unsigned long damaged;                             //Frames thrown away as damaged
+    unsigned long bytes;                               //Bytes of frames received, the command included
+    unsigned char state;                               //Where the decoder is, between frames, after the command prefix or inside a frame
+    unsigned char length;                              //Bytes of the frame received so far
+    unsigned char frame[TELEMETRY_FRAME_SIZE];         //Bytes of the frame received so far
+};
+
+/***************
+ *  Functions  *
+ ***************/
+
+void telemetryStart(struct telemetry *telemetry);                        //Get ready to decode, nothing about the panel is known yet
+int telemetryReceive(struct telemetry *telemetry, unsigned char data);  //Hand over a byte sent to the status LCD, returns TELEMETRY_FRAME once a frame has been decoded
+
+#endif
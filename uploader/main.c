@@ -0,0 +1,195 @@
+/************************************************************************
+ *  Fire Alarm Panel - Firmware Uploader                                *
+ *  Sends an XC8 HEX file to the panel over a serial port on Linux,     *
+ *  TX to the software update port on PORTC7 and RX from PORTC6         *
+ ************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
+
+#include "uploader.h"
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Set the serial port to raw 8N1 at any baud rate, 250000 baud isn't one of the standard rates so termios2 is used
+static int setBaud(int port, unsigned long baud) {
+    struct termios2 settings;
+
+    if (ioctl(port, TCGETS2, &settings) != 0x00) {
+        return -1;
+    }
+
+    settings.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT) | CSIZE | PARENB | CSTOPB | CRTSCTS);
+    settings.c_cflag |= BOTHER | (BOTHER << IBSHIFT) | CS8 | CLOCAL | CREAD;
+    settings.c_iflag = 0x00;
+    settings.c_oflag = 0x00;
+    settings.c_lflag = 0x00;
+    settings.c_cc[VMIN] = 0x00;
+    settings.c_cc[VTIME] = 0x00;
+    settings.c_ispeed = baud;
+    settings.c_ospeed = baud;
+
+    return ioctl(port, TCSETS2, &settings);
+}
+
+//Write every byte out and wait for them to leave the serial port
+static int sendAll(int port, const unsigned char *data, size_t length) {
+    while (length != 0x00) {
+        ssize_t sent = write(port, data, length);
+
+        if (sent < 0x00 && errno != EINTR) {
+            return -1;
+        }
+        if (sent > 0x00) {
+            data += sent;
+            length -= sent;
+        }
+    }
+
+    return ioctl(port, TCSBRK, 0x01);
+}
+
+//Wait for a single byte, returns UPLOADER_TIMEOUT if none came in time
+static int receive(int port, unsigned long timeout) {
+    struct pollfd poller;
+    unsigned char data;
+
+    poller.fd = port;
+    poller.events = POLLIN;
+    if (poll(&poller, 0x01, timeout) == 0x01 && read(port, &data, 0x01) == 0x01) {
+        return data;
+    }
+
+    return UPLOADER_TIMEOUT;
+}
+
+//Milliseconds since some point in the past
+static double milliseconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+/*********************
+ *  Core Processing  *
+ *********************/
+
+//Main Function, sends the image and returns non-zero if the update failed
+int main(int argc, char **argv) {
+    static struct uploaderImage image;
+    struct uploader uploader;
+    const char *device = "/dev/ttyUSB0";
+    unsigned char recover = 0x00;
+    unsigned long blocks = 0x00;
+    unsigned long block;
+    double started;
+    int option;
+    int port;
+    int result;
+    int status;
+
+    while ((option = getopt(argc, argv, "d:r")) != -1) {
+        switch (option) {
+            case 'd':
+                device = optarg;
+                break;
+
+            case 'r':
+                recover = 0x01;
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-d device] [-r] image.hex\n", argv[0x00]);
+                return 0x02;
+        }
+    }
+    if (optind != argc - 0x01) {
+        fprintf(stderr, "Usage: %s [-d device] [-r] image.hex\n", argv[0x00]);
+        return 0x02;
+    }
+
+    result = uploaderLoadHex(argv[optind], &image);
+    if (result == UPLOADER_HEX_BOOT_BLOCK) {
+        fprintf(stderr, "%s has code in the bootloader block past the bootloader, which the update can't write, build it with --ROM=default,-D00-FFF\n", argv[optind]);
+        return 0x02;
+    }
+    if (result == UPLOADER_HEX_BOOT_SIZE) {
+        fprintf(stderr, "%s has a bootloader of %lu words, more than the %u words it has before the debug executive\n", argv[optind], image.bootWords, UPLOADER_BOOT_WORDS);
+        return 0x02;
+    }
+    if (result != 0x00) {
+        fprintf(stderr, "%s is not a usable HEX file, it must be readable and carry a reset vector\n", argv[optind]);
+        return 0x02;
+    }
+    for (block = 0x00; block < UPLOADER_BOOT_ADDRESS / UPLOADER_BLOCK_WORDS; block++) {
+        blocks += image.used[block];
+    }
+    printf("%lu blocks to send", blocks);
+    if (image.skipped != 0x00) {
+        printf(", %lu words in the bootloader block left out, the bootloader on the panel is kept, %lu of its %u words are the bootloader", image.skipped, image.bootWords, UPLOADER_BOOT_WORDS);
+    }
+    printf("\n");
+
+    port = open(device, O_RDWR | O_NOCTTY);
+    if (port < 0x00) {
+        fprintf(stderr, "Can't open %s: %s\n", device, strerror(errno));
+        return 0x02;
+    }
+
+    //Send the key a byte at a time at the status LCD baud rate unless the panel is already waiting in the bootloader
+    if (recover == 0x00) {
+        size_t i;
+
+        if (setBaud(port, UPLOADER_KEY_BAUD) != 0x00) {
+            fprintf(stderr, "Can't set %s to %u baud: %s\n", device, UPLOADER_KEY_BAUD, strerror(errno));
+            close(port);
+            return 0x02;
+        }
+        for (i = 0x00; i < strlen(UPLOADER_KEY); i++) {
+            if (sendAll(port, (const unsigned char *) &UPLOADER_KEY[i], 0x01) != 0x00) {
+                fprintf(stderr, "Can't send the key: %s\n", strerror(errno));
+                close(port);
+                return 0x02;
+            }
+            usleep(UPLOADER_KEY_GAP * 1000);
+        }
+    }
+    if (setBaud(port, UPLOADER_BAUD) != 0x00) {
+        fprintf(stderr, "Can't set %s to %u baud: %s\n", device, UPLOADER_BAUD, strerror(errno));
+        close(port);
+        return 0x02;
+    }
+    ioctl(port, TCFLSH, TCIFLUSH);
+
+    //Step through the protocol, sending whatever frame the uploader comes up with after each reply
+    started = milliseconds();
+    uploaderStart(&uploader, &image);
+    do {
+        status = uploaderReply(&uploader, receive(port, uploaderTimeout(&uploader)));
+        if (status == UPLOADER_SEND && sendAll(port, uploader.frame, UPLOADER_FRAME_SIZE) != 0x00) {
+            fprintf(stderr, "Can't send a frame: %s\n", strerror(errno));
+            close(port);
+            return 0x01;
+        }
+    } while (status == UPLOADER_SEND || status == UPLOADER_WAIT);
+    close(port);
+
+    if (status != UPLOADER_OK) {
+        fprintf(stderr, "Update failed, %s\n", uploader.error);
+        return 0x01;
+    }
+
+    printf("Update done in %.1f seconds, %lu frames sent, %lu of them again\n", (milliseconds() - started) / 1000.0, uploader.frames, uploader.resent);
+    return 0x00;
+}
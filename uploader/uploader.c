@@ -0,0 +1,311 @@
+/************************************************************************
+ *  Fire Alarm Panel - Firmware Uploader                                *
+ *  Loads an image out of an XC8 HEX file and steps through the         *
+ *  bootloader protocol, a check pass followed by a write pass          *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uploader.h"
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Replies being waited for
+#define UPLOADER_STATE_READY 0x00  //Waiting for the bootloader to start listening
+#define UPLOADER_STATE_FRAME 0x01  //Waiting for the reply to a frame
+#define UPLOADER_STATE_END 0x02    //Waiting for the reply to the end of a pass
+#define UPLOADER_STATE_OVER 0x03   //The update is over, nothing else is sent
+
+/*************
+ *  Helpers  *
+ *************/
+
+//Convert a hex digit pair into a byte, returns -1 if either character is not a hex digit
+static int hexByte(const char *text) {
+    char digits[0x03];
+    char *end;
+    long value;
+
+    digits[0x00] = text[0x00];
+    digits[0x01] = text[0x01];
+    digits[0x02] = 0x00;
+
+    value = strtol(digits, &end, 0x10);
+    return end == &digits[0x02] ? (int) value : -1;
+}
+
+//Find the next block with something in it from the given block on, returns UPLOADER_BOOT_ADDRESS / UPLOADER_BLOCK_WORDS if there are none left
+static unsigned short nextBlock(const struct uploader *uploader, unsigned short block) {
+    while (block < UPLOADER_BOOT_ADDRESS / UPLOADER_BLOCK_WORDS && uploader->image->used[block] == 0x00) {
+        block++;
+    }
+
+    return block;
+}
+
+//Finish a frame by adding the CRC of its first 11 bytes
+static void sealFrame(struct uploader *uploader) {
+    unsigned short crc = 0xFFFF;
+    unsigned char i;
+
+    for (i = 0x00; i < UPLOADER_FRAME_SIZE - 0x02; i++) {
+        crc = uploaderCrc(crc, uploader->frame[i]);
+    }
+
+    uploader->frame[UPLOADER_FRAME_SIZE - 0x02] = crc >> 0x08;
+    uploader->frame[UPLOADER_FRAME_SIZE - 0x01] = crc & 0xFF;
+    uploader->retries = 0x00;
+    uploader->frames++;
+}
+
+//Build the frame of the current block, or the end of the pass once every block has been sent
+static int buildFrame(struct uploader *uploader) {
+    unsigned short address = uploader->block * UPLOADER_BLOCK_WORDS;
+    unsigned char i;
+
+    memset(uploader->frame, 0x00, UPLOADER_FRAME_SIZE);
+
+    if (uploader->block == UPLOADER_BOOT_ADDRESS / UPLOADER_BLOCK_WORDS) {
+        uploader->frame[0x00] = UPLOADER_END;
+        uploader->frame[0x01] = uploader->imageCrc >> 0x08;
+        uploader->frame[0x02] = uploader->imageCrc & 0xFF;
+        uploader->state = UPLOADER_STATE_END;
+    } else {
+        uploader->frame[0x00] = uploader->writing == 0x01 ? UPLOADER_WRITE : UPLOADER_CHECK;
+        uploader->frame[0x01] = address >> 0x08;
+        uploader->frame[0x02] = address & 0xFF;
+        for (i = 0x00; i < UPLOADER_BLOCK_WORDS; i++) {
+            uploader->frame[0x03 + i * 0x02] = uploader->image->words[address + i] & 0xFF;
+            uploader->frame[0x04 + i * 0x02] = uploader->image->words[address + i] >> 0x08;
+        }
+        uploader->state = UPLOADER_STATE_FRAME;
+    }
+
+    sealFrame(uploader);
+    return UPLOADER_SEND;
+}
+
+//Start a pass from the first block
+static int startPass(struct uploader *uploader, unsigned char writing) {
+    uploader->writing = writing;
+    uploader->imageCrc = 0xFFFF;
+    uploader->block = nextBlock(uploader, 0x00);
+
+    return buildFrame(uploader);
+}
+
+//Give up on the update
+static int fail(struct uploader *uploader, const char *error) {
+    uploader->state = UPLOADER_STATE_OVER;
+    uploader->error = error;
+
+    return UPLOADER_ERROR;
+}
+
+//Send the frame again after it was turned down or went unanswered
+static int resend(struct uploader *uploader) {
+    if (++uploader->retries > UPLOADER_FRAME_RETRIES) {
+        return fail(uploader, uploader->state == UPLOADER_STATE_END ? "the end of the pass was turned down too many times" : "a frame was turned down too many times");
+    }
+
+    uploader->frames++;
+    uploader->resent++;
+    return UPLOADER_SEND;
+}
+
+/***************
+ *  Functions  *
+ ***************/
+
+//Add a byte to a CRC-16-CCITT, the same way the bootloader does
+unsigned short uploaderCrc(unsigned short crc, unsigned char data) {
+    unsigned char work = (crc >> 0x08) ^ data;
+
+    work ^= work >> 0x04;
+    return (crc << 0x08) ^ ((unsigned short) work << 0x0C) ^ ((unsigned short) work << 0x05) ^ work;
+}
+
+//Load the image out of an Intel HEX file built by XC8, returns 0 on success, UPLOADER_HEX_UNUSABLE, UPLOADER_HEX_BOOT_BLOCK or UPLOADER_HEX_BOOT_SIZE
+//Words in the bootloader block, the ID locations, the configuration words and the data EEPROM can't be written by the bootloader, so they are left out
+//The bootloader is a single function placed at the start of its block, so the words of the block have to be one run from there, anything past it is code the linker put in the block and the image is turned down
+int uploaderLoadHex(const char *path, struct uploaderImage *image) {
+    char line[0x0200];
+    unsigned char bootUsed[UPLOADER_FLASH_WORDS - UPLOADER_BOOT_ADDRESS];
+    unsigned long base = 0x00;
+    unsigned char ended = 0x00;
+    FILE *file = fopen(path, "r");
+    unsigned long i;
+
+    if (file == 0) {
+        return UPLOADER_HEX_UNUSABLE;
+    }
+
+    for (i = 0x00; i < UPLOADER_BOOT_ADDRESS; i++) {
+        image->words[i] = 0x3FFF;
+    }
+    memset(image->used, 0x00, sizeof(image->used));
+    memset(bootUsed, 0x00, sizeof(bootUsed));
+    image->skipped = 0x00;
+    image->bootWords = 0x00;
+
+    while (ended == 0x00 && fgets(line, sizeof(line), file) != 0) {
+        int count;
+        int type;
+        int checksum;
+        unsigned long address;
+
+        if (line[0x00] != ':') {
+            continue;
+        }
+
+        count = strlen(line) >= 0x0B ? hexByte(&line[0x01]) : -1;
+        if (count < 0x00 || strlen(line) < (size_t) (0x0B + count * 0x02)) {
+            fclose(file);
+            return UPLOADER_HEX_UNUSABLE;
+        }
+        address = (hexByte(&line[0x03]) << 0x08) | hexByte(&line[0x05]);
+        type = hexByte(&line[0x07]);
+
+        //Every byte of a record, the checksum included, adds up to 0
+        checksum = 0x00;
+        for (i = 0x00; i < (unsigned long) count + 0x05; i++) {
+            int value = hexByte(&line[0x01 + i * 0x02]);
+
+            if (value < 0x00) {
+                fclose(file);
+                return UPLOADER_HEX_UNUSABLE;
+            }
+            checksum += value;
+        }
+        if ((checksum & 0xFF) != 0x00) {
+            fclose(file);
+            return UPLOADER_HEX_UNUSABLE;
+        }
+
+        if (type == 0x01) {
+            ended = 0x01;
+        } else if (type == 0x04 && count == 0x02) {
+            base = (unsigned long) ((hexByte(&line[0x09]) << 0x08) | hexByte(&line[0x0B])) << 0x10;
+        } else if (type == 0x00) {
+            for (i = 0x00; i < (unsigned long) count; i++) {
+                unsigned long byteAddress = base + address + i;
+                unsigned long word = byteAddress / 0x02;
+                int value = hexByte(&line[0x09 + i * 0x02]);
+
+                //Count the words of the bootloader block and keep track of where they are, anything past program memory is left out without a word
+                if (word >= UPLOADER_BOOT_ADDRESS) {
+                    image->skipped += (byteAddress & 0x01) == 0x00 && word < UPLOADER_HEX_WORDS;
+                    if (word < UPLOADER_FLASH_WORDS) {
+                        bootUsed[word - UPLOADER_BOOT_ADDRESS] = 0x01;
+                    }
+                    continue;
+                }
+
+                //Words are stored low byte first, only 14 bits of each word are used
+                if ((byteAddress & 0x01) == 0x00) {
+                    image->words[word] = (image->words[word] & 0x3F00) | value;
+                } else {
+                    image->words[word] = (image->words[word] & 0x00FF) | ((value & 0x3F) << 0x08);
+                }
+                image->used[word / UPLOADER_BLOCK_WORDS] = 0x01;
+            }
+        }
+    }
+
+    fclose(file);
+
+    //The image has to carry a reset vector, the bootloader writes the first block last to hand over to the new image
+    if (ended == 0x00 || image->used[0x00] == 0x00) {
+        return UPLOADER_HEX_UNUSABLE;
+    }
+
+    //Skip over the bootloader, any word of the block after it would be silently lost
+    for (i = 0x00; i < sizeof(bootUsed) && bootUsed[i] == 0x01; i++) {
+    }
+    image->bootWords = i;
+    for (; i < sizeof(bootUsed); i++) {
+        if (bootUsed[i] == 0x01) {
+            return UPLOADER_HEX_BOOT_BLOCK;
+        }
+    }
+
+    //The bootloader has to stay clear of the debug executive, a bootloader that has outgrown its words only shows up once it is built
+    if (image->bootWords > UPLOADER_BOOT_WORDS) {
+        return UPLOADER_HEX_BOOT_SIZE;
+    }
+
+    return 0x00;
+}
+
+//Get ready to send an image, the first thing to wait for is the ready reply
+void uploaderStart(struct uploader *uploader, const struct uploaderImage *image) {
+    memset(uploader, 0x00, sizeof(*uploader));
+    uploader->image = image;
+    uploader->state = UPLOADER_STATE_READY;
+}
+
+//Hand over a reply from the panel or UPLOADER_TIMEOUT, returns what to do next
+int uploaderReply(struct uploader *uploader, int reply) {
+    switch (uploader->state) {
+        case UPLOADER_STATE_READY:
+            if (reply == UPLOADER_READY) {
+                return startPass(uploader, 0x00);
+            }
+            return reply == UPLOADER_TIMEOUT ? fail(uploader, "the bootloader never answered") : UPLOADER_WAIT;
+
+        case UPLOADER_STATE_FRAME:
+        case UPLOADER_STATE_END:
+            //The bootloader starts over once it gives up waiting, so start over with it
+            if (reply == UPLOADER_READY) {
+                return startPass(uploader, 0x00);
+            }
+
+            if (uploader->state == UPLOADER_STATE_FRAME && reply == UPLOADER_ACK) {
+                unsigned char i;
+
+                for (i = 0x01; i < UPLOADER_FRAME_SIZE - 0x02; i++) {
+                    uploader->imageCrc = uploaderCrc(uploader->imageCrc, uploader->frame[i]);
+                }
+                uploader->block = nextBlock(uploader, uploader->block + 0x01);
+                return buildFrame(uploader);
+            }
+
+            if (uploader->state == UPLOADER_STATE_END && reply == UPLOADER_DONE) {
+                if (uploader->writing == 0x01) {
+                    uploader->state = UPLOADER_STATE_OVER;
+                    return UPLOADER_OK;
+                }
+                return startPass(uploader, 0x01);
+            }
+
+            if (reply == UPLOADER_FAILED) {
+                if (uploader->state == UPLOADER_STATE_FRAME) {
+                    return fail(uploader, "the bootloader gave up waiting and went back to the old image");
+                }
+                if (uploader->writing == 0x00) {
+                    return fail(uploader, "the image didn't come through the check pass, the panel went back to the old image");
+                }
+                if (++uploader->passRetries > UPLOADER_PASS_RETRIES) {
+                    return fail(uploader, "the image read back wrong, the panel is waiting in the bootloader for another try");
+                }
+                return startPass(uploader, 0x01);
+            }
+
+            if (reply == UPLOADER_NAK || reply == UPLOADER_TIMEOUT) {
+                return resend(uploader);
+            }
+            return UPLOADER_WAIT;
+
+        default:
+            return UPLOADER_ERROR;
+    }
+}
+
+//Milliseconds to wait for the next reply
+unsigned long uploaderTimeout(const struct uploader *uploader) {
+    return uploader->state == UPLOADER_STATE_READY ? UPLOADER_READY_TIMEOUT : UPLOADER_REPLY_TIMEOUT;
+}
@@ -0,0 +1,93 @@
+/************************************************************************
+ *  Fire Alarm Panel - Firmware Uploader                                *
+ *  Sends a new image to the bootloader over the software update port,  *
+ *  shared by the uploader program and the host simulator               *
+ ************************************************************************/
+
+#ifndef UPLOADER_H
+#define UPLOADER_H
+
+/***************
+ *  Constants  *
+ ***************/
+
+//Bootloader Protocol, must match the bootloader in Main.c
+#define UPLOADER_KEY "UPDATE"          //Key that hands the panel over to the bootloader
+#define UPLOADER_KEY_BAUD 9600         //Baud rate the key is sent at, the panel runs the EUSART at the status LCD baud rate
+#define UPLOADER_BAUD 250000           //Baud rate the bootloader runs the EUSART at
+#define UPLOADER_FRAME_SIZE 0x0D       //Bytes in a frame, command, word address, 4 words low byte first and a CRC-16 of the first 11 bytes
+#define UPLOADER_BOOT_ADDRESS 0x0D00   //Word address of the bootloader, the block from here on is never written by an update
+#define UPLOADER_BOOT_WORDS 0x0200     //Words the bootloader may take, the PICkit 2 debug executive takes the rest of the block
+#define UPLOADER_BLOCK_WORDS 0x04      //Words in a frame, the size of a program memory write block
+#define UPLOADER_CHECK 'C'             //Command of a frame only checked into the image CRC
+#define UPLOADER_WRITE 'W'             //Command of a frame written into program memory
+#define UPLOADER_END 'E'               //Command of the frame ending a pass, carrying the image CRC
+#define UPLOADER_READY 'B'             //Reply once the bootloader is listening
+#define UPLOADER_ACK 0x06              //Reply once a frame has been taken in
+#define UPLOADER_NAK 0x15              //Reply when a frame was damaged or not allowed
+#define UPLOADER_DONE 'K'              //Reply when the image CRC of a pass matches
+#define UPLOADER_FAILED 'F'            //Reply when the image CRC of a pass doesn't match
+
+//Intel HEX Layout, XC8 writes byte addresses with every word taking up 2 bytes, low byte first
+#define UPLOADER_FLASH_WORDS 0x1000  //Words of program memory, the bootloader block runs from the bootloader address to here
+#define UPLOADER_HEX_WORDS 0x2000UL  //Word address where program memory ends and the ID locations, configuration words and data EEPROM start
+
+//Results of loading a HEX file
+#define UPLOADER_HEX_UNUSABLE (-1)  //The file can't be read, is damaged or carries no reset vector
+#define UPLOADER_HEX_BOOT_BLOCK (-2) //The file has words in the bootloader block that aren't the bootloader, they would be lost as the block is never written
+#define UPLOADER_HEX_BOOT_SIZE (-3)  //The bootloader runs past its words into the debug executive
+
+//Timing, in milliseconds
+#define UPLOADER_READY_TIMEOUT 0x1388  //Longest to wait for the bootloader to start listening, it repeats the ready reply about every 2 seconds while it waits
+#define UPLOADER_REPLY_TIMEOUT 0x01F4  //Longest to wait for a reply to a frame, longer than the gap after which the bootloader throws away a frame cut short
+#define UPLOADER_KEY_GAP 0x96          //Gap between the bytes of the key, the panel only looks at the EUSART about every 65ms and holds 2 bytes at most
+
+//Retries
+#define UPLOADER_FRAME_RETRIES 0x04  //Times a frame is sent again after it was turned down or went unanswered
+#define UPLOADER_PASS_RETRIES 0x02   //Times the write pass is sent again after the image read back from the panel didn't match
+
+//Results of handing a reply to the uploader
+#define UPLOADER_SEND 0x00    //The frame is ready to be sent
+#define UPLOADER_WAIT 0x01    //Nothing to send, keep waiting for a reply
+#define UPLOADER_OK 0x02      //The new image has been written and checked, the panel is resetting into it
+#define UPLOADER_ERROR 0x03   //The update failed, the reason is in error
+#define UPLOADER_TIMEOUT (-1) //Passed in place of a reply once the timeout has run out
+
+/***************
+ *  Variables  *
+ ***************/
+
+//Image to be sent, only the blocks with something in them are sent
+struct uploaderImage {
+    unsigned short words[UPLOADER_BOOT_ADDRESS];                      //Words of the image, unused words are left erased
+    unsigned char used[UPLOADER_BOOT_ADDRESS / UPLOADER_BLOCK_WORDS];  //Set for every block with at least one word of the image in it
+    unsigned long skipped;                                            //Words of the HEX file in the bootloader block, left out as the bootloader on the panel is kept
+    unsigned long bootWords;                                          //Words of the bootloader, the run of words from the bootloader address on
+};
+
+//Progress of an update
+struct uploader {
+    const struct uploaderImage *image;        //Image being sent
+    unsigned char state;                      //Reply being waited for, the ready reply, the reply to a frame or the reply to the end of a pass
+    unsigned char writing;                    //Set during the write pass, clear during the check pass
+    unsigned short block;                     //Block of the frame being sent
+    unsigned short imageCrc;                  //CRC-16 of the address and words of every frame taken in during the pass
+    unsigned char retries;                    //Times the frame has been sent again
+    unsigned char passRetries;                //Times the write pass has been sent again
+    unsigned long frames;                     //Frames sent, counting the ones sent again
+    unsigned long resent;                     //Frames sent again
+    const char *error;                        //Reason the update failed
+    unsigned char frame[UPLOADER_FRAME_SIZE];  //Frame to send
+};
+
+/***************
+ *  Functions  *
+ ***************/
+
+unsigned short uploaderCrc(unsigned short crc, unsigned char data);                //Add a byte to a CRC-16-CCITT, the same way the bootloader does
+int uploaderLoadHex(const char *path, struct uploaderImage *image);               //Load the image out of an Intel HEX file built by XC8, returns 0 on success
+void uploaderStart(struct uploader *uploader, const struct uploaderImage *image);  //Get ready to send an image, the first thing to wait for is the ready reply
+int uploaderReply(struct uploader *uploader, int reply);                          //Hand over a reply from the panel or UPLOADER_TIMEOUT, returns what to do next
+unsigned long uploaderTimeout(const struct uploader *uploader);                   //Milliseconds to wait for the next reply
+
+#endif